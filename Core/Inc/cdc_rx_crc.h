@@ -0,0 +1,45 @@
+/*
+ * cdc_rx_crc.h
+ *
+ *  USB CDC 수신 경로의 Y-MODEM 패킷 경계 추적 + CRC-16 누적 계산
+ *  CDC_Receive_HS()에서 링 버퍼에 쓴 바이트를 그대로 보고 [SOH|STX|LBLK][BLK][~BLK][DATA][CRC] 경계를 따라감
+ *  패킷이 끝나면 (헤더의 스트림 위치, 크기, CRC, 마지막 바이트 도착 시각)을 기록 → 수신측은 비교만 수행
+ *  추적은 추측이므로 수신측이 읽은 헤더 위치와 기록이 일치할 때만 사용 (어긋나면 기존 CRC 계산)
+ */
+
+#ifndef INC_CDC_RX_CRC_H_
+#define INC_CDC_RX_CRC_H_
+
+#include "main.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+// 완료 패킷 기록 수 (링 버퍼 32KB = 1KB 패킷 약 30개)
+#define CDC_RX_CRC_RECORDS      32
+
+typedef struct {
+    uint32_t offset;            // 헤더 바이트의 스트림 위치 (Y-MODEM 모드 진입 후 누적 바이트 수)
+    uint16_t size;              // 데이터 크기 (128/1024/8192)
+    uint16_t crc;               // 데이터 CRC-16 (crc_valid일 때만)
+    bool crc_valid;             // CRC 누적 사용 + CRC-16 패킷 (LBLK는 CRC-32이므로 경계만 추적)
+    uint32_t done_cycles;       // 마지막 바이트(CRC 끝) 도착 시각 (DWT)
+} CdcRxPacket_t;
+
+// Y-MODEM 모드 진입 시 (링 버퍼 클리어와 함께): 스트림 위치 0, 기록 비움
+void cdc_rx_crc_reset(void);
+
+// 수신 세션 설정: crc_enabled이면 CRC-16 누적, large_blocks이면 LBLK 헤더도 경계 추적
+void cdc_rx_crc_configure(bool crc_enabled, bool large_blocks);
+
+// 인터럽트 (CDC_Receive_HS): 링 버퍼에 들어간 바이트 전달
+void cdc_rx_crc_feed(const uint8_t *data, uint32_t length);
+
+// 메인 루프 (CDC_Read_Data): 링 버퍼에서 읽은 바이트 수 / 현재 읽기 위치
+void cdc_rx_crc_consumed(uint32_t length);
+uint32_t cdc_rx_crc_position(void);
+
+// offset에 헤더가 있는 패킷 기록 꺼내기 (그 앞의 기록은 버림)
+// 반환값: false이면 기록 없음 (추적이 어긋났거나 기록 큐가 가득 참)
+bool cdc_rx_crc_take(uint32_t offset, CdcRxPacket_t *packet);
+
+#endif /* INC_CDC_RX_CRC_H_ */
@@ -0,0 +1,50 @@
+/*
+ * cdc_rx_pool.h
+ *
+ *  USB CDC 수신 슬롯 풀 (Y-MODEM 무복사 수신)
+ *  OUT 엔드포인트는 빈 슬롯(512바이트)에 직접 수신하고, CDC_Receive_HS()는 채운 슬롯을 큐에 넣은 뒤
+ *  다음 빈 슬롯으로 다시 수신을 시작 (인터럽트에서 복사 없음)
+ *  메인 루프는 가장 오래된 슬롯부터 읽고, 다 읽은 슬롯을 반환
+ *  빈 슬롯이 없으면 수신을 시작하지 않음 → 호스트는 NAK를 받고 대기 (데이터 손실 없음)
+ *
+ *  슬롯은 채운 순서대로 사용/반환하므로 슬롯 번호 = 누적 채운 수 % 슬롯 수 (별도 빈 목록 없음)
+ *  단일 생산자(인터럽트) / 단일 소비자(메인 루프), ring_buffer와 같은 누적 카운터 방식
+ */
+
+#ifndef INC_CDC_RX_POOL_H_
+#define INC_CDC_RX_POOL_H_
+
+#include "main.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+// 슬롯 크기 = USB HS bulk 최대 패킷, 64개 = 32KB (이전 링 버퍼와 같은 용량)
+#define CDC_RX_SLOT_SIZE        512
+#define CDC_RX_POOL_SLOTS       64
+
+void cdc_rx_pool_init(void);
+
+// 인터럽트: 다음에 수신할 빈 슬롯 (없으면 NULL → 수신 보류)
+uint8_t *cdc_rx_pool_next(void);
+// 인터럽트: cdc_rx_pool_next()로 받은 슬롯에 length바이트가 들어옴 (0이면 슬롯을 그대로 다시 사용)
+void cdc_rx_pool_push(uint32_t length);
+
+// 빈 슬롯 수 (수신 재개 판단)
+uint32_t cdc_rx_pool_free(void);
+
+// 메인 루프: 읽지 않은 바이트 수 / 가장 오래된 슬롯의 남은 데이터 (복사 없이 처리할 때)
+uint32_t cdc_rx_pool_available(void);
+uint32_t cdc_rx_pool_peek(const uint8_t **data);
+// 메인 루프: 처리한 바이트 수 (슬롯을 끝까지 읽으면 반환)
+void cdc_rx_pool_release(uint32_t length);
+// 메인 루프: 최대 length바이트 복사 (슬롯 경계를 넘어 이어서)
+uint32_t cdc_rx_pool_read(uint8_t *data, uint32_t length);
+// 메인 루프: 받은 데이터 모두 버림 (인터럽트와 겹쳐도 안전)
+void cdc_rx_pool_clear(void);
+
+// 시험용 저장 공간 대여: 수신 대기 중인 슬롯(명령 모드에서 파싱 중인 슬롯)을 피한 연속 16KB
+uint8_t *cdc_rx_pool_scratch(uint32_t *size);
+// 풀 전체 (32KB, 32바이트 정렬): CDC 클래스가 내려가 있는 동안만 (MSC 모드 클래스 핸들)
+uint8_t *cdc_rx_pool_storage(uint32_t *size);
+
+#endif /* INC_CDC_RX_POOL_H_ */
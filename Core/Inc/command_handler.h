@@ -8,6 +8,8 @@
 #define INC_COMMAND_HANDLER_H_
 
 #include "uart_command.h"
+#include "ymodem.h"
+#include "ymodem_sim.h"
 #include <stdbool.h>
 
 // Y-MODEM 업로드 요청 구조체
@@ -15,6 +17,13 @@ typedef struct {
     bool requested;
     int channel;
     char file_path[128];
+    YmodemMode_t mode;      // 전송 모드 (UPLOAD 명령의 옵션 인수)
+    bool batch;             // 배치 전송 (BATCH 명령, 블록 0 파일명으로 경로 결정)
+    uint32_t resume_offset; // 재개 전송 시작 위치 (RESUME 명령, 0이면 새 파일)
+    uint32_t options;       // YMODEM_OPT_* (LZ4 압축, X 확장 블록)
+    bool download;          // Y-MODEM 송신 (DOWNLOAD 명령, SD → 호스트)
+    bool simulate;          // 온보드 시뮬레이션 (YSIM 명령, 내부 송신기)
+    YmodemSimConfig_t sim_config;
 } UploadRequest_t;
 
 // 전역 변수 (extern)
@@ -23,6 +32,8 @@ extern volatile UploadRequest_t upload_request;
 // 함수 프로토타입
 void execute_command(UartCommand_t *cmd);
 void process_upload_request(void);  // 메인 루프에서 호출
+void process_msc_request(void);     // 메인 루프에서 호출 (MSC ON/OFF 후 USB 재열거)
+void process_sd_job_request(void);  // 메인 루프에서 호출 (SDBENCH/VERIFY/WAVBENCH/SIGS 등 긴 SD 작업 실행 후 응답)
 void format_sd_card(void);  // SD 카드 포맷
 
 #endif /* INC_COMMAND_HANDLER_H_ */
@@ -0,0 +1,51 @@
+/*
+ * crc_engine.h
+ *
+ *  CRC-16/XMODEM 계산 엔진 (Y-MODEM 패킷 검증용)
+ *  다항식 0x1021, 초기값 0, 반사 없음
+ *  + CRC-32 (확장 블록 검증용)
+ */
+
+#ifndef INC_CRC_ENGINE_H_
+#define INC_CRC_ENGINE_H_
+
+#include "main.h"
+#include <stdint.h>
+
+// CRC-16 엔진 선택 (빌드 옵션 -DCRC16_ENGINE=... 로 변경 가능)
+#define CRC16_ENGINE_BITWISE    0   // 비트 단위 (바이트당 8회 루프, 기준 구현)
+#define CRC16_ENGINE_TABLE      1   // 256 엔트리 테이블 (바이트당 1회 조회)
+#define CRC16_ENGINE_SLICE4     2   // slice-by-4 (4바이트당 4회 조회)
+#define CRC16_ENGINE_SLICE8     3   // slice-by-8 (8바이트당 8회 조회)
+#define CRC16_ENGINE_HW         4   // STM32H7 하드웨어 CRC 유닛
+
+#ifndef CRC16_ENGINE
+#define CRC16_ENGINE            CRC16_ENGINE_SLICE8
+#endif
+
+// 초기화 (하드웨어 CRC 유닛 클럭 활성화)
+void crc_engine_init(void);
+
+// 선택된 엔진으로 CRC-16 계산
+uint16_t crc16_ccitt(const uint8_t *data, uint32_t length);
+
+// 이전 CRC 값에 이어서 계산 (분할된 데이터용)
+uint16_t crc16_ccitt_update(uint16_t crc, const uint8_t *data, uint32_t length);
+
+// 개별 엔진 (검증/벤치마크용)
+uint16_t crc16_update_bitwise(uint16_t crc, const uint8_t *data, uint32_t length);
+uint16_t crc16_update_table(uint16_t crc, const uint8_t *data, uint32_t length);
+uint16_t crc16_update_slice4(uint16_t crc, const uint8_t *data, uint32_t length);
+uint16_t crc16_update_slice8(uint16_t crc, const uint8_t *data, uint32_t length);
+uint16_t crc16_update_hw(uint16_t crc, const uint8_t *data, uint32_t length);
+
+// CRC-32 (IEEE 802.3 / zlib 호환, Y-MODEM 확장 블록)
+// crc: 이전 결과 (처음은 0), 하드웨어 CRC 유닛 사용
+uint32_t crc32_update(uint32_t crc, const uint8_t *data, uint32_t length);
+uint32_t crc32_update_bitwise(uint32_t crc, const uint8_t *data, uint32_t length);
+
+// 모든 엔진을 비트 단위 기준 구현과 비교하고 cycles/byte 측정 (CRCTEST 명령)
+// 반환값: 불일치 엔진 수 (0이면 모두 정상)
+int crc_engine_self_test(char *report, uint32_t report_size);
+
+#endif /* INC_CRC_ENGINE_H_ */
@@ -0,0 +1,81 @@
+/*
+ * delta_sync.h
+ *
+ *  블록 서명 기반 차등 업로드 (rsync 방식)
+ *  1) 장치: 기존 파일을 BLOCK 단위로 나눠 블록마다 약한(롤링) 체크섬 + CRC-32 서명 기록 (SIGS)
+ *  2) 호스트: 새 파일에서 롤링 체크섬으로 기존 블록과 일치하는 위치를 찾아 [리터럴 | 블록 참조] 스트림 생성
+ *  3) 장치: Y-MODEM으로 받은 스트림을 해석해 리터럴은 그대로, 참조는 기존 파일에서 순차 복사 (SYNC)
+ */
+
+#ifndef INC_DELTA_SYNC_H_
+#define INC_DELTA_SYNC_H_
+
+#include "main.h"
+#include <stdint.h>
+
+// 블록 크기 (2의 거듭제곱, 서명과 스트림 헤더에 기록)
+#define DELTA_BLOCK_MIN         512
+#define DELTA_BLOCK_MAX         8192
+#define DELTA_BLOCK_DEFAULT     4096
+
+// 서명 파일 "<파일>.sig" (little-endian)
+// [DeltaSigHeader_t][DeltaSigEntry_t x block_count] - 마지막 블록은 짧을 수 있음 (실제 길이로 계산)
+#define DELTA_SIG_MAGIC         0x47495344  // "DSIG"
+#define DELTA_SIG_SUFFIX        ".sig"
+
+typedef struct __attribute__((packed)) {
+    uint32_t magic;
+    uint32_t block_size;
+    uint32_t file_size;
+    uint32_t block_count;
+} DeltaSigHeader_t;
+
+typedef struct __attribute__((packed)) {
+    uint32_t weak;              // delta_weak_checksum()
+    uint32_t strong;            // CRC-32 (IEEE 802.3, crc32_update(0, ...))
+} DeltaSigEntry_t;
+
+// 차등 스트림 (Y-MODEM 데이터 블록, little-endian)
+// [DELTA_STREAM_MAGIC 4][block_size 4][basis_size 4] (명령)* [DELTA_OP_END]
+// 헤더의 block_size/basis_size가 현재 파일과 다르면 (서명 이후 파일이 바뀜) 거부
+// DELTA_OP_END 이후의 바이트 (마지막 블록의 0x1A 패딩)는 무시
+#define DELTA_STREAM_MAGIC      0x31595344  // "DSY1"
+#define DELTA_OP_END            0x00        // [새 파일 전체 CRC-32 4]
+#define DELTA_OP_LITERAL        0x01        // [길이 4][데이터]
+#define DELTA_OP_COPY           0x02        // [첫 블록 4][블록 수 4] → 기존 파일 연속 구간 (파일 끝에서 잘림)
+
+// 해석 상태
+typedef enum {
+    DELTA_STREAM_OK = 0,        // 진행 중 (다음 입력 대기)
+    DELTA_STREAM_DONE,          // DELTA_OP_END 수신
+    DELTA_STREAM_ERROR,         // 잘못된 스트림 또는 출력 실패
+    DELTA_STREAM_COPY           // 블록 참조에서 멈춤 (delta_stream_resume()으로 복사 후 나머지 입력 해석)
+} DeltaStreamStatus_t;
+
+// 리터럴 출력 콜백 / 기존 파일 구간 복사 콜백 (0이 아니면 해석 중단)
+// 복사 콜백은 한 블록 참조를 resume budget 단위로 나눠 순차 위치로 여러 번 받음
+typedef int (*DeltaStreamOutput_t)(const uint8_t *data, uint32_t size);
+typedef int (*DeltaStreamCopy_t)(uint32_t offset, uint32_t size);
+
+// 약한 체크섬 (rsync 롤링 체크섬): a = sum(x[i]), b = sum((n - i) * x[i]), 각각 mod 65536
+// 반환값: a | (b << 16)
+uint32_t delta_weak_checksum(const uint8_t *data, uint32_t size);
+
+// 새 스트림 해석 시작 (basis_size: 현재 파일 크기)
+void delta_stream_init(uint32_t basis_size, DeltaStreamOutput_t literal, DeltaStreamCopy_t copy);
+
+// 입력 조각 해석 (패킷 경계와 무관하게 이어서 처리)
+// 블록 참조를 만나면 복사하지 않고 DELTA_STREAM_COPY 반환, 남은 입력은 resume까지 그대로 유지되어야 함
+DeltaStreamStatus_t delta_stream_decode(const uint8_t *data, uint32_t size);
+
+// 멈춘 블록 참조를 최대 budget 바이트 복사하고, 끝나면 남은 입력 해석을 이어 감
+// (다음 블록 참조나 budget 소진 시 다시 DELTA_STREAM_COPY)
+DeltaStreamStatus_t delta_stream_resume(uint32_t budget);
+
+// 현재 상태 / DELTA_OP_END의 CRC-32 / 리터럴·복사 바이트 수
+DeltaStreamStatus_t delta_stream_status(void);
+uint32_t delta_stream_expected_crc(void);
+uint32_t delta_stream_literal_bytes(void);
+uint32_t delta_stream_copied_bytes(void);
+
+#endif /* INC_DELTA_SYNC_H_ */
@@ -0,0 +1,48 @@
+/*
+ * lz4_stream.h
+ *
+ *  LZ4 프레임 스트리밍 해제 (압축 업로드용)
+ *  입력을 임의 크기 조각으로 받아 즉시 해제, 작업 메모리는 64KB 히스토리로 고정
+ */
+
+#ifndef INC_LZ4_STREAM_H_
+#define INC_LZ4_STREAM_H_
+
+#include "main.h"
+#include <stdint.h>
+
+// LZ4 매치 거리 최대값 (65535) 이상인 히스토리 링 크기 (2의 거듭제곱)
+#define LZ4_HISTORY_SIZE        65536
+
+// 해제 상태
+typedef enum {
+    LZ4_STREAM_OK = 0,          // 진행 중 (다음 입력 대기)
+    LZ4_STREAM_DONE,            // 프레임 종료 마크 수신 (이후 입력은 무시 - Y-MODEM 패딩)
+    LZ4_STREAM_ERROR,           // 잘못된 프레임 또는 출력 실패
+    LZ4_STREAM_PAUSED           // 출력 콜백이 lz4_stream_pause() 요청 (lz4_stream_resume()으로 이어서)
+} Lz4StreamStatus_t;
+
+// 해제된 데이터 출력 콜백 (0이 아니면 해제 중단)
+// 출력을 바로 처리할 수 없으면 콜백 안에서 lz4_stream_pause() - 이 출력 이후에서 멈춤
+typedef int (*Lz4StreamOutput_t)(const uint8_t *data, uint32_t size);
+
+// 새 프레임 해제 시작
+void lz4_stream_init(Lz4StreamOutput_t output);
+
+// 입력 조각 해제 (패킷 경계와 무관하게 이어서 처리)
+// LZ4_STREAM_PAUSED이면 남은 입력과 히스토리는 resume까지 그대로 유지되어야 함
+Lz4StreamStatus_t lz4_stream_decode(const uint8_t *data, uint32_t size);
+
+// 출력 콜백에서 해제 일시 정지 요청 / 멈춘 자리부터 남은 입력 해제
+void lz4_stream_pause(void);
+Lz4StreamStatus_t lz4_stream_resume(void);
+
+// 현재 상태 / 해제된 총 바이트 수
+Lz4StreamStatus_t lz4_stream_status(void);
+uint32_t lz4_stream_output_bytes(void);
+
+// 합성 프레임으로 해제 결과 검증 및 속도 측정 (LZ4TEST 명령)
+// 반환값: 0이면 정상
+int lz4_stream_self_test(char *report, uint32_t report_size);
+
+#endif /* INC_LZ4_STREAM_H_ */
@@ -0,0 +1,55 @@
+/*
+ * msc_storage.h
+ *
+ *  USB 대용량 저장 장치(MSC)용 SD 블록 접근
+ *  - 호스트가 볼륨을 쓰는 동안(HOST)은 FatFs를 마운트 해제하고, 돌려받으면(FIRMWARE) 다시 마운트
+ *    (두 쪽이 같은 FAT를 따로 캐시하면 파일시스템이 깨지므로 동시에 소유하지 않음)
+ *  - 블록 읽기/쓰기는 sd_diskio의 DMA 다중 블록 경로(SD_Driver) 그대로 사용
+ *  - usbd_storage_if.c(USBD_MSC_ENABLE)가 SCSI READ/WRITE를 여기로 넘김
+ */
+
+#ifndef INC_MSC_STORAGE_H_
+#define INC_MSC_STORAGE_H_
+
+#include "main.h"
+#include "ff.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+// SD 카드 용량 (init_sdmmc()에서 카드 정보로 채움)
+extern uint32_t cached_block_num;       // 마지막 블록 번호 (블록 수 - 1)
+extern uint16_t cached_block_size;      // 블록 크기 (512)
+extern uint8_t capacity_cached;
+
+// 호스트 세션 통계 (attach 시 초기화)
+typedef struct {
+    uint32_t read_blocks;
+    uint32_t write_blocks;
+    uint32_t read_us;           // SD 읽기 시간 합 (DMA 시작 ~ 카드 TRANSFER 복귀)
+    uint32_t write_us;          // SD 쓰기 시간 합 (카드 프로그래밍 종료까지)
+    uint32_t usb_read_blocks;   // 연속 요청 구간의 블록 수 (USB 전송 포함 처리량용)
+    uint32_t usb_read_us;       // 연속 요청 간격 합 (SD + USB 전송, 호스트가 쉰 시간 제외)
+    uint32_t usb_write_blocks;
+    uint32_t usb_write_us;
+    uint32_t errors;
+    uint32_t attached_ms;       // 호스트 소유 시간
+} MscStorageStats_t;
+
+// 소유권 전환: attach는 FatFs 마운트 해제 후 호스트 소유 (업로드 중이면 FR_LOCKED, 재생 중인 채널은 정지)
+// detach는 다시 마운트 (호스트가 바꾼 FAT/디렉토리를 새로 읽음, 재생 파일은 다시 LOAD 필요)
+FRESULT msc_storage_attach(void);
+FRESULT msc_storage_detach(void);
+bool msc_storage_host_owned(void);
+
+// 블록 읽기/쓰기 (호스트 소유일 때만, 0 = 성공)
+int8_t msc_storage_read(uint8_t *buf, uint32_t blk_addr, uint32_t blk_len);
+int8_t msc_storage_write(const uint8_t *buf, uint32_t blk_addr, uint32_t blk_len);
+
+void msc_storage_stats(MscStorageStats_t *stats);
+
+// 지속 전송 속도 측정 (MSCBENCH 명령, 메인 루프): f_expand()로 연속 할당한 임시 파일(/mscbench.tmp)의
+// 섹터 범위에 청크 크기별로 순차 쓰기 → 읽기, 끝나면 파일 삭제
+// sdmmc1_buffer 사용 (전송 중 불가), 반환값: 실패 수
+int msc_storage_benchmark(uint32_t size_kb, char *report, uint32_t report_size);
+
+#endif /* INC_MSC_STORAGE_H_ */
@@ -16,22 +16,41 @@
 // Y-MODEM 핸드셰이킹으로 SD write 중 Python 대기 → 오버플로우 없음
 #define RING_BUFFER_SIZE  32768
 
+// 단일 생산자(CDC_Receive_HS 인터럽트) / 단일 소비자(메인 루프) 링 버퍼
+// head는 생산자만, tail은 소비자만 증가 (누적 바이트 수, 32비트 래핑)
+// 저장량 = head - tail, 위치 = 누적값 & mask (크기는 2의 거듭제곱)
+// 공유 카운터가 없으므로 인터럽트 금지 없이 양쪽이 동시에 진행 가능
 typedef struct {
-    uint8_t buffer[RING_BUFFER_SIZE];
-    volatile uint32_t head;  // 쓰기 위치
-    volatile uint32_t tail;  // 읽기 위치
-    volatile uint32_t count; // 저장된 데이터 수
+    uint8_t *buffer;
+    uint32_t mask;              // 크기 - 1
+    volatile uint32_t head;     // 누적 쓰기 바이트 (생산자)
+    volatile uint32_t tail;     // 누적 읽기 바이트 (소비자)
 } RingBuffer_t;
 
 // 함수 프로토타입
-void ring_buffer_init(RingBuffer_t *rb);
+void ring_buffer_init(RingBuffer_t *rb, uint8_t *storage, uint32_t size);
+
+// 생산자: 전체가 들어갈 공간이 없으면 false (일부만 쓰지 않음)
 bool ring_buffer_write(RingBuffer_t *rb, uint8_t data);
 bool ring_buffer_write_array(RingBuffer_t *rb, const uint8_t *data, uint32_t length);
+// 생산자: head부터 연속으로 쓸 수 있는 구간 (래핑 지점에서 끊김) → 채운 뒤 commit
+uint32_t ring_buffer_write_span(RingBuffer_t *rb, uint8_t **span);
+void ring_buffer_write_commit(RingBuffer_t *rb, uint32_t length);
+
+// 소비자
 bool ring_buffer_read(RingBuffer_t *rb, uint8_t *data);
 uint32_t ring_buffer_read_array(RingBuffer_t *rb, uint8_t *data, uint32_t length, uint32_t timeout_ms);
+// 소비자: tail부터 연속으로 읽을 수 있는 구간 (래핑 지점에서 끊김) → 처리한 만큼 commit
+uint32_t ring_buffer_read_span(RingBuffer_t *rb, const uint8_t **span);
+void ring_buffer_read_commit(RingBuffer_t *rb, uint32_t length);
 uint32_t ring_buffer_available(RingBuffer_t *rb);
+// 저장된 데이터 버림 (소비자 쪽 연산, 생산자가 쓰는 중이어도 안전)
 void ring_buffer_clear(RingBuffer_t *rb);
 
+// 래핑 경계 검증 + 기존 바이트 단위 구현과 cycles/byte 비교 (RINGTEST 명령)
+// scratch: 16KB 이상 (시험용 링 8KB + 입출력 버퍼), 반환값: 실패 수
+int ring_buffer_self_test(uint8_t *scratch, uint32_t scratch_size, char *report, uint32_t report_size);
+
 // ============================================================================
 // UART DMA TX용 Queue 구조체 및 함수 (레퍼런스: stm32h523-spi-hardware-nss-dma)
 // ============================================================================
@@ -26,6 +26,10 @@ void sound_mon_select(uint8_t channel);
 void init_proc(void);
 void run_proc(void);
 
+// 메인 루프 1회 실행 시간 측정 (DWT 사이클 카운터)
+uint32_t main_loop_max_us(void);
+void main_loop_stats_reset(void);
+
 // SPI 테스트 함수
 void spi_test_basic(uint8_t slave_id);
 void spi_test_data(uint8_t slave_id);
@@ -17,12 +17,29 @@ extern "C" {
 #include "ff.h"
 #include <stdint.h>
 
+/* 재생용 저장 포맷 (업로드 시 변환, wav_transcode_*)
+ * NONE:     16비트 PCM 그대로 (읽을 때 & 0x0FFF 마스킹)
+ * PCM12:    16비트 컨테이너에 하위 12비트만 (미리 마스킹, bits_per_sample=12, block_align=2)
+ *           읽을 때 마스킹 없이 그대로 사용
+ * PACKED12: 2샘플을 3바이트로 묶음 (bits_per_sample=12, block_align=3, 16비트 대비 SD 대역폭 75%)
+ *           b0 = s0[7:0], b1 = s0[11:8] | s1[3:0] << 4, b2 = s1[11:4]
+ *           샘플 수가 홀수이면 마지막 샘플은 2바이트 (s[7:0], s[11:8]) */
+typedef enum {
+    WAV_NATIVE_NONE = 0,
+    WAV_NATIVE_PCM12,
+    WAV_NATIVE_PACKED12
+} WAV_NativeFormat_t;
+
+/* 변환 출력 콜백 (0: 성공, 음수: 실패 → 변환 중단) */
+typedef int (*WAV_TranscodeOutput_t)(const uint8_t *data, uint32_t size);
+
 /* WAV 파일 정보 구조체 */
 typedef struct {
     FIL file;                   // FatFs 파일 핸들
     uint32_t sample_rate;       // 샘플레이트 (Hz)
     uint16_t bits_per_sample;   // 비트 수 (12 또는 16)
     uint16_t channels;          // 채널 수 (1=모노, 2=스테레오)
+    WAV_NativeFormat_t format;  // 저장 포맷 (bits_per_sample/block_align로 판정)
     uint32_t data_size;         // 데이터 크기 (바이트)
     uint32_t data_offset;       // 데이터 시작 오프셋
     uint32_t total_samples;     // 총 샘플 수
@@ -60,6 +77,8 @@ FRESULT wav_open(WAV_FileInfo_t *info, const char *filename);
 
 /**
  * @brief  WAV 파일에서 샘플 읽기 (16비트로 변환)
+ * @note   PACKED12는 buffer 뒤쪽 절반에 읽은 뒤 제자리에서 풀기 (추가 버퍼 없음)
+ *         num_samples는 짝수여야 함 (파일 끝의 홀수 샘플은 예외)
  * @param  info: WAV 파일 정보 구조체 포인터
  * @param  buffer: 출력 버퍼 (16비트 샘플 배열)
  * @param  num_samples: 읽을 샘플 수
@@ -89,6 +108,45 @@ FRESULT wav_close(WAV_FileInfo_t *info);
  */
 uint8_t wav_is_valid(WAV_FileInfo_t *info);
 
+/**
+ * @brief  업로드 스트림 변환 시작 (Y-MODEM 파일마다 호출)
+ * @note   앞부분에서 WAV 헤더를 파싱해 16비트 PCM 모노면 format으로 변환, 아니면 그대로 출력
+ *         변환 시 data 청크 뒤의 바이트(다른 청크, Y-MODEM 0x1A 패딩)는 버림
+ * @param  format: 변환할 포맷 (WAV_NATIVE_NONE이면 그대로 출력)
+ * @param  output: 출력 콜백
+ */
+void wav_transcode_init(WAV_NativeFormat_t format, WAV_TranscodeOutput_t output);
+
+/**
+ * @brief  업로드 데이터 입력 (임의 크기, 샘플 경계에 걸친 바이트는 다음 입력과 이어서 변환)
+ * @retval 0: 성공, 음수: 출력 콜백 실패
+ */
+int wav_transcode_input(const uint8_t *data, uint32_t size);
+
+/**
+ * @brief  업로드 종료 (헤더를 다 받기 전에 끝난 짧은 파일은 그대로 출력)
+ * @retval 0: 성공, 음수: 출력 콜백 실패
+ */
+int wav_transcode_finish(void);
+
+/**
+ * @brief  변환된 파일 크기 (헤더 44바이트 + 변환 데이터)
+ * @retval 0: 변환하지 않음 (그대로 출력)
+ */
+uint32_t wav_transcode_output_size(void);
+
+/**
+ * @brief  포맷별 SD 기록/재생 읽기 벤치마크 (WAVBENCH 명령)
+ * @note   합성 16비트 WAV를 변환기로 기록한 뒤 wav_read_samples()로 끝까지 읽고 삭제
+ *         sdmmc1_buffer 사용 (Y-MODEM 전송 중 호출 금지)
+ * @param  path: 임시 파일 경로
+ * @param  seconds: 오디오 길이 (초, 32kHz)
+ * @param  report: 결과 문자열 (포맷별 한 줄)
+ * @param  report_size: report 크기
+ * @retval 0: 성공, 음수: 실패
+ */
+int wav_benchmark(const char *path, uint32_t seconds, char *report, uint32_t report_size);
+
 #ifdef __cplusplus
 }
 #endif
@@ -9,33 +9,193 @@
 
 #include "main.h"
 #include "ff.h"
+#include <stdbool.h>
 
 // Y-MODEM 상수
 #define YMODEM_SOH              0x01  // 128-byte block
 #define YMODEM_STX              0x02  // 1024-byte block
+#define YMODEM_LBLK             0x03  // 8192-byte block + CRC-32 (확장 블록, X 옵션으로 협상 시에만)
 #define YMODEM_EOT              0x04  // End of transmission
 #define YMODEM_ACK              0x06  // Acknowledge
 #define YMODEM_NAK              0x15  // Negative acknowledge
 #define YMODEM_CAN              0x18  // Cancel
 #define YMODEM_CRC16            0x43  // 'C' for CRC mode
+#define YMODEM_G                0x47  // 'G' for streaming mode (Y-MODEM-G)
+#define YMODEM_WINDOW           0x57  // 'W' for sliding window mode
 
 #define YMODEM_PACKET_SIZE      1024
-#define YMODEM_TIMEOUT_MS       5000   // 5초 (SD 쓰기 지연 대응)
+#define YMODEM_LARGE_PACKET_SIZE    8192   // 확장 블록 = SD 스테이징 버퍼 1개
+#define YMODEM_TIMEOUT_MS       5000   // 5초: 적응 타임아웃 상한, 측정값이 없을 때 기본값 (SD 쓰기 지연 대응)
 
 // 재시도 설정
 #define YMODEM_MAX_TIMEOUT_RETRIES  5   // 타임아웃 재시도 최대 횟수
 #define YMODEM_MAX_NAK_RETRIES      10  // NAK 재시도 최대 횟수
 
+// 적응 타임아웃 (TCP SRTT/RTTVAR 방식, RFC 6298)
+// 구간별 측정값으로 SRTT += (측정 - SRTT)/8, RTTVAR += (|측정 - SRTT| - RTTVAR)/4 갱신
+// 타임아웃 = SRTT + 4 x RTTVAR를 [YMODEM_RTO_MIN_MS, YMODEM_TIMEOUT_MS]로 제한, 연속 타임아웃마다 2배 (백오프)
+// 재전송/재동기화가 끼어든 구간은 측정하지 않음 (Karn), 측정값은 세션 사이에 유지
+#define YMODEM_RTO_MIN_MS           500
+// 타임아웃 후 수신 보류 = SRTT + 2 x RTTVAR (REPLY 구간), [MIN, MAX x 2^(연속 타임아웃 - 1)]로 제한
+// 측정값이 없으면 MAX (이전 고정값 100ms)
+#define YMODEM_RETRY_DELAY_MIN_MS   10
+#define YMODEM_RETRY_DELAY_MAX_MS   100
+#define YMODEM_HANDSHAKE_TIMEOUT_MS 60000   // 송신측 응답 없이 핸드셰이크 문자를 보내는 최대 시간
+
+// 재동기화 설정
+// 잘못된 헤더를 받으면 바이트를 버리면서 그럴듯한 헤더 [SOH|STX|LBLK][BLK][~BLK] (BLK = 기대/직전 블록)를 찾음
+// 찾지 못한 채 링크가 YMODEM_RESYNC_QUIET_MS 동안 조용하면 송신측이 응답 대기 중이므로 즉시 NAK
+// 패킷 중간에 링크가 조용해진 경우(꼬리 손실)도 같은 방식으로 처리 (YMODEM_TIMEOUT_MS 대기 없음)
+#define YMODEM_RESYNC_QUIET_MS      50
+#define YMODEM_RESYNC_SCAN_MAX      4096    // poll 1회에 검사할 최대 바이트 수
+
+// 배치 전송 설정
+// 블록 0의 파일명은 YMODEM_BATCH_ROOT 기준 상대 경로 (예: "ch0/test.wav" -> /audio/ch0/test.wav)
+#define YMODEM_BATCH_ROOT           "/audio"
+#define YMODEM_PATH_MAX             128
+
+// 슬라이딩 윈도우 설정
+// 송신측은 ACK 없이 최대 YMODEM_WINDOW_SIZE개 패킷까지 전송 가능
+#define YMODEM_WINDOW_SIZE          8
+
+// 재개 전송 설정
+// 수신 중 YMODEM_SYNC_INTERVAL마다 f_sync() 후 확정 위치를 "<경로>.ymp"에 기록 (리셋 후에도 유지)
+// 재개 위치는 확정 위치를 YMODEM_PACKET_SIZE 경계로 내림 (블록 단위로 이어서 전송)
+#define YMODEM_SYNC_INTERVAL        (1024 * 1024)
+#define YMODEM_PROGRESS_SUFFIX      ".ymp"
+
+// 파일 다이제스트 설정
+// 스테이징 버퍼를 SD에 쓸 때 CRC-32를 이어서 계산 (추가 읽기 없음), 수신 완료 시 "<경로>.crc"에 기록
+// 재개 전송은 진행 기록에 남긴 확정 위치까지의 CRC에서 이어서 계산
+#define YMODEM_DIGEST_SUFFIX        ".crc"
+
+// 확장 블록 (USB CDC 전용)
+// [LBLK][BLK][~BLK][DATA 8192][CRC-32 4바이트, MSB 먼저] (CRC-32: IEEE 802.3 / zlib)
+// 스테이징 버퍼 경계(파일 위치 8KB 배수, 재개 시 재개 위치 기준)에서만 허용 → 버퍼에 직접 착지 후 그대로 f_write()
+// SOH/STX 블록도 계속 허용하므로 송신측은 마지막 블록만 STX/SOH로 보내면 됨
+#define YMODEM_OPT_LZ4              0x01    // 데이터 블록이 LZ4 프레임
+#define YMODEM_OPT_LARGE_BLOCKS     0x02    // 확장 블록 허용
+#define YMODEM_OPT_RX_CRC           0x04    // CRC-16을 USB 수신 인터럽트에서 누적 계산 (cdc_rx_crc.h, USB CDC 전용)
+#define YMODEM_OPT_NATIVE_PCM12     0x08    // 16비트 WAV를 미리 마스킹한 12비트로 변환해 저장 (wav_parser.h)
+#define YMODEM_OPT_NATIVE_PACKED12  0x10    // 16비트 WAV를 12비트 packed(2샘플 3바이트)로 변환해 저장
+#define YMODEM_OPT_DELTA            0x20    // 데이터 블록이 차등 스트림 (delta_sync.h, 기존 파일 + 리터럴로 재구성)
+
+// 차등 업로드 (YMODEM_OPT_DELTA)
+// 새 파일은 "<경로>.dsy"에 재구성하고, 스트림 CRC-32가 맞으면 기존 파일을 지우고 이름 변경
+// (실패/취소 시 임시 파일만 삭제, 기존 파일은 그대로)
+#define YMODEM_DELTA_SUFFIX         ".dsy"
+// 블록 참조 복사는 poll 1회에 이 크기까지 (기존 파일 읽기 + 스테이징 쓰기), 끝나면 그 패킷을 ACK
+#define YMODEM_DELTA_COPY_BUDGET    (32 * 1024)
+
+// 전송 모드
+// STANDARD: 패킷마다 ACK (Stop-and-Wait, UART/CDC 공통)
+// G: Y-MODEM-G 스트리밍 (USB CDC 전용, 무손실 링크 전제)
+//    송신측은 ACK 없이 연속 전송, 수신측은 에러(CAN) 또는 완료(EOT ACK)만 응답
+// WINDOW: 슬라이딩 윈도우 (USB CDC 전용)
+//    수신측 응답은 2바이트 [ACK][마지막 정상 블록] (누적) 또는 [NAK][누락 블록] (선택적 재전송)
+typedef enum {
+    YMODEM_MODE_STANDARD = 0,
+    YMODEM_MODE_G,
+    YMODEM_MODE_WINDOW
+} YmodemMode_t;
+
+// 수신 구간별 시간 통계 (DWT 사이클 측정, 패킷당 수십 사이클 - 상시 사용)
+// 빌드 옵션 -DYMODEM_PHASE_STATS=0 으로 제거 가능
+#ifndef YMODEM_PHASE_STATS
+#define YMODEM_PHASE_STATS      1
+#endif
+
+typedef enum {
+    YMODEM_PHASE_WAIT_HEADER = 0,   // 수신 준비 → 헤더 바이트 도착 (호스트 왕복 포함)
+    YMODEM_PHASE_PAYLOAD_RX,        // 헤더 → 패킷 전체 수신 완료
+    YMODEM_PHASE_CRC,               // CRC-16 계산
+    YMODEM_PHASE_STAGE_COPY,        // 스테이징 버퍼 복사 (직접 착지하지 못한 페이로드)
+    YMODEM_PHASE_F_WRITE,           // f_write() (SD_READY 포함)
+    YMODEM_PHASE_SD_READY,          // 이전 write-behind DMA/카드 프로그래밍 완료 대기
+    YMODEM_PHASE_ACK_TX,            // ACK/NAK 전송 (USB CDC는 전송 큐 적재까지)
+    YMODEM_PHASE_FIXED_DELAY,       // 수신 보류 (ACK 후 안정화, 타임아웃 후 대기)
+    YMODEM_PHASE_LAST_TO_ACK,       // 패킷 마지막 바이트 USB 도착 → ACK 전송 완료 (표준 모드, USB CDC)
+    YMODEM_PHASE_COUNT
+} YmodemPhase_t;
+
+// 적응 타임아웃 측정 구간
+typedef enum {
+    YMODEM_EST_REPLY = 0,           // 수신 준비 → 다음 패킷 헤더 (데이터 패킷 대기, 배치 핸드셰이크 간격)
+    YMODEM_EST_PAYLOAD,             // 헤더 → 패킷 수신 완료, 1KB당 (패킷 중간 대기)
+    YMODEM_EST_ACK,                 // 데이터 블록 전송 → 응답 (DOWNLOAD 재전송)
+    YMODEM_EST_SD,                  // 8KB f_write() (SD_READY 포함, 호스트 ACK 대기 권장값)
+    YMODEM_EST_COUNT
+} YmodemEstimator_t;
+
 // 결과 코드
 typedef enum {
     YMODEM_OK = 0,
     YMODEM_ERROR,
     YMODEM_TIMEOUT,
     YMODEM_CANCELLED,
-    YMODEM_CRC_ERROR
+    YMODEM_CRC_ERROR,
+    YMODEM_BUSY             // 전송 진행 중 (ymodem_poll() 계속 호출)
 } YmodemResult_t;
 
 // 함수 프로토타입
-YmodemResult_t ymodem_receive(UART_HandleTypeDef *huart, const char *file_path);
+// 비차단 수신: ymodem_start() 후 메인 루프에서 YMODEM_BUSY가 아닐 때까지 ymodem_poll() 호출
+// file_path가 NULL이면 배치 전송 (빈 블록 0을 받을 때까지 여러 파일 수신)
+YmodemResult_t ymodem_start(UART_HandleTypeDef *huart, const char *file_path, YmodemMode_t mode);
+YmodemResult_t ymodem_poll(void);
+bool ymodem_is_active(void);
+uint32_t ymodem_files_received(void);
+
+// 재개 전송: ymodem_resume_offset()으로 이어받을 위치를 구하고 그 위치부터 수신
+// 송신측은 블록 0에 전체 크기를 보내고, 데이터는 offset 바이트부터 블록 1로 번호를 매겨 전송
+// options: YMODEM_OPT_LZ4이면 데이터 블록 스트림은 LZ4 프레임 (블록 0 크기는 해제 후 크기)
+//          YMODEM_OPT_LARGE_BLOCKS이면 확장 블록(YMODEM_LBLK) 수신
+//          YMODEM_OPT_NATIVE_*이면 수신 중 WAV 변환 (재개/확장 블록과 함께 사용 불가, 블록 0 크기는 원본 크기)
+//          YMODEM_OPT_DELTA이면 차등 업로드 (단일 파일, 표준 모드, 블록 0 크기는 새 파일 크기)
+uint32_t ymodem_resume_offset(const char *file_path);
+YmodemResult_t ymodem_start_ex(UART_HandleTypeDef *huart, const char *file_path,
+                               YmodemMode_t mode, uint32_t offset, uint32_t options);
+
+// Y-MODEM 송신 (SD → 호스트, DOWNLOAD 명령)
+// ymodem_send_start() 후 ymodem_poll()로 진행 (수신과 같은 세션, 동시에 하나만)
+// 수신측이 'C'를 보내면 블록 0 (파일명, 크기) → 1KB 데이터 블록 → EOT → 빈 블록 0 순서로 전송
+YmodemResult_t ymodem_send_start(UART_HandleTypeDef *huart, const char *file_path);
+YmodemResult_t ymodem_send(UART_HandleTypeDef *huart, const char *file_path);
+
+// USB CDC 대체 링크 (YSIM 온보드 시뮬레이션: 내부 송신기와 직접 연결)
+// ymodem_start*/ymodem_send_start(huart = NULL) 전에 지정, 세션 종료 시 자동 해제
+typedef struct {
+    uint32_t (*available)(void);                                    // 읽을 수 있는 바이트 수
+    uint32_t (*read)(uint8_t *data, uint32_t length);               // 비차단 읽기
+    HAL_StatusTypeDef (*transmit)(const uint8_t *data, uint16_t length);  // 응답 전송
+} YmodemLink_t;
+
+void ymodem_set_link(const YmodemLink_t *link);
+
+// 구간 통계: 전송 시작 시 자동 초기화, YSTATS 명령으로 구간별 한 줄씩 출력
+void ymodem_stats_reset(void);
+bool ymodem_stats_format(YmodemPhase_t phase, char *line, uint32_t line_size);
+
+// 적응 타임아웃 측정값: YTIMING 명령으로 구간별 한 줄씩 출력 (전송 시작 시 초기화하지 않음)
+void ymodem_timing_reset(void);
+bool ymodem_timing_format(YmodemEstimator_t est, char *line, uint32_t line_size);
+
+// 파일 다이제스트 (VERIFY 명령)
+// ymodem_read_digest(): 수신 시 기록한 크기/CRC-32 읽기 (없거나 손상되면 false)
+// ymodem_file_crc32(): 파일 전체를 32KB 순차 읽기로 다시 계산 (sdmmc1_buffer 사용, 전송 중 불가)
+bool ymodem_read_digest(const char *file_path, uint32_t *size, uint32_t *crc);
+FRESULT ymodem_file_crc32(const char *file_path, uint32_t *size, uint32_t *crc);
+
+// SD 기록 경로 벤치마크 (사전 할당 유무 비교)
+uint32_t ymodem_sd_benchmark(const char *path, uint32_t size, bool prealloc);
+
+// 차등 업로드 서명 생성 (SIGS 명령): "<경로>.sig"에 블록별 서명 기록 (delta_sync.h 형식)
+// sdmmc1_buffer 사용, 전송 중 불가 (FR_LOCKED)
+FRESULT ymodem_delta_signatures(const char *file_path, uint32_t block_size, uint32_t *block_count);
+
+// 마지막 차등 업로드 결과 (리터럴/복사 바이트, 링크 전송량)
+void ymodem_delta_result(uint32_t *literal_bytes, uint32_t *copied_bytes, uint32_t *wire_bytes);
+
+// 차단형 수신 (ymodem_start + ymodem_poll 반복)
+YmodemResult_t ymodem_receive(UART_HandleTypeDef *huart, const char *file_path, YmodemMode_t mode);
 
 #endif /* INC_YMODEM_H_ */
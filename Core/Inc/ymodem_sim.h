@@ -0,0 +1,41 @@
+/*
+ * ymodem_sim.h
+ *
+ *  Y-MODEM 온보드 시뮬레이션 (YSIM 명령)
+ *  내부 송신기를 YmodemLink_t로 수신기에 직접 연결해 USB 호스트 없이 수신 경로 전체를 측정
+ *  링크 지연/속도, SD 쓰기 지연을 모델로 주입하고 수신 후 파일 내용을 검증
+ *  장애 주입: 잡음 선행 / 꼬리 손실 / 헤더 손실을 번갈아 넣고 재동기화 복구 시간을 측정
+ *  차등 업로드: 기존 파일 기록 → 서명 생성 → 중간만 바뀐 새 파일을 [복사 | 리터럴 | 복사] 스트림으로 전송
+ */
+
+#ifndef INC_YMODEM_SIM_H_
+#define INC_YMODEM_SIM_H_
+
+#include "main.h"
+#include "ymodem.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+// 시뮬레이션 수신 파일 (검증 후 삭제)
+#define YMODEM_SIM_PATH         "/ysim.tmp"
+
+// 시뮬레이션 조건
+typedef struct {
+    uint32_t size;              // 전송 크기 (바이트)
+    uint32_t link_delay_us;     // 수신측 응답 → 송신측 다음 프레임 도착까지 지연 (호스트 왕복 모델)
+    uint32_t link_kbps;         // 링크 속도 KB/s (0 = 제한 없음)
+    uint32_t sd_latency_us;     // SD write-behind 최소 완료 시간 (느린 카드 모델, 0 = 실제 카드)
+    YmodemMode_t mode;          // STANDARD 또는 G (윈도우 모드는 미지원)
+    bool large_blocks;          // 8KB 확장 블록 + CRC-32 (YMODEM_OPT_LARGE_BLOCKS)
+    uint32_t fault_interval;    // N번째 데이터 블록마다 장애 주입 (0 = 없음, 표준 모드만)
+    uint32_t delta_edit_kb;     // 차등 업로드: 파일 중간 EDIT_KB만 바뀐 새 파일 (0 = 일반 업로드, 표준 모드만)
+} YmodemSimConfig_t;
+
+// 시뮬레이션 시작: 이후 ymodem_poll()로 진행 (일반 업로드와 같은 세션)
+YmodemResult_t ymodem_sim_start(const YmodemSimConfig_t *config);
+
+// 종료 처리: SD 지연 모델 해제, 수신 파일 검증/삭제, 결과 문자열 작성
+// 반환값: 0이면 전송 성공 + 내용 일치
+int ymodem_sim_finish(YmodemResult_t result, char *report, uint32_t report_size);
+
+#endif /* INC_YMODEM_SIM_H_ */
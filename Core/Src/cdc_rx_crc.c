@@ -0,0 +1,172 @@
+/*
+ * cdc_rx_crc.c
+ *
+ *  USB CDC 수신 경로의 Y-MODEM 패킷 경계 추적 + CRC-16 누적 계산
+ *  CDC_Receive_HS()는 64~512바이트 단위로 호출되므로 패킷 CRC가 수신과 겹쳐 계산됨
+ *  (수신측이 패킷 끝을 확인한 시점에는 이미 계산 완료)
+ */
+
+#include "cdc_rx_crc.h"
+#include "crc_engine.h"
+#include "ymodem.h"
+
+typedef enum {
+    TRACK_HEADER = 0,           // 헤더 바이트 탐색 (그 외 바이트는 건너뜀: EOT, 잡음)
+    TRACK_BLK,                  // BLK
+    TRACK_BLK_INV,              // ~BLK (보수 불일치면 헤더가 아님)
+    TRACK_DATA,                 // 데이터 (CRC 누적)
+    TRACK_TRAILER               // CRC 바이트 (2 또는 4)
+} TrackState_t;
+
+static struct {
+    TrackState_t state;
+    bool crc_enabled;
+    bool large_blocks;
+    uint8_t header;
+    uint8_t blk;
+    uint16_t size;
+    uint16_t remaining;         // 현재 상태에서 남은 바이트 수 (DATA/TRAILER)
+    uint16_t crc;
+    uint32_t start;             // 현재 패킷 헤더의 스트림 위치
+    volatile uint32_t received; // 링 버퍼에 들어간 누적 바이트 수 (인터럽트)
+    volatile uint32_t consumed; // 링 버퍼에서 읽은 누적 바이트 수 (메인 루프)
+    CdcRxPacket_t records[CDC_RX_CRC_RECORDS];
+    volatile uint32_t record_head;  // 인터럽트만 증가
+    volatile uint32_t record_tail;  // 메인 루프만 증가
+} tracker;
+
+void cdc_rx_crc_reset(void)
+{
+    tracker.state = TRACK_HEADER;
+    tracker.received = 0;
+    tracker.consumed = 0;
+    tracker.record_tail = tracker.record_head;
+}
+
+void cdc_rx_crc_configure(bool crc_enabled, bool large_blocks)
+{
+    tracker.crc_enabled = crc_enabled;
+    tracker.large_blocks = large_blocks;
+}
+
+// 완료 패킷 기록 (큐가 가득 차면 버림 - 수신측은 기존 CRC 계산으로 처리)
+static void record_packet(void)
+{
+    uint32_t head = tracker.record_head;
+    if (head - tracker.record_tail >= CDC_RX_CRC_RECORDS) {
+        return;
+    }
+
+    CdcRxPacket_t *rec = &tracker.records[head % CDC_RX_CRC_RECORDS];
+    rec->offset = tracker.start;
+    rec->size = tracker.size;
+    rec->crc = tracker.crc;
+    rec->crc_valid = tracker.crc_enabled && tracker.header != YMODEM_LBLK;
+    rec->done_cycles = DWT->CYCCNT;
+    __DMB();
+    tracker.record_head = head + 1;
+}
+
+void cdc_rx_crc_feed(const uint8_t *data, uint32_t length)
+{
+    uint32_t pos = tracker.received;
+    uint32_t i = 0;
+
+    while (i < length) {
+        switch (tracker.state) {
+        case TRACK_HEADER: {
+            uint8_t b = data[i];
+            tracker.size = (b == YMODEM_SOH) ? 128 : (b == YMODEM_STX) ? YMODEM_PACKET_SIZE :
+                           (b == YMODEM_LBLK && tracker.large_blocks) ? YMODEM_LARGE_PACKET_SIZE : 0;
+            if (tracker.size != 0) {
+                tracker.header = b;
+                tracker.start = pos + i;
+                tracker.state = TRACK_BLK;
+            }
+            i++;
+            break;
+        }
+
+        case TRACK_BLK:
+            tracker.blk = data[i++];
+            tracker.state = TRACK_BLK_INV;
+            break;
+
+        case TRACK_BLK_INV:
+            if (data[i] != (uint8_t)~tracker.blk) {
+                // 헤더가 아님: 현재 바이트부터 다시 탐색
+                tracker.state = TRACK_HEADER;
+                break;
+            }
+            i++;
+            tracker.crc = 0;
+            tracker.remaining = tracker.size;
+            tracker.state = TRACK_DATA;
+            break;
+
+        case TRACK_DATA: {
+            uint32_t n = length - i;
+            if (n > tracker.remaining) {
+                n = tracker.remaining;
+            }
+            // 인터럽트 안이므로 하드웨어 CRC 유닛(메인 루프의 CRC-32와 공유) 대신 소프트웨어 엔진
+            if (tracker.crc_enabled && tracker.header != YMODEM_LBLK) {
+                tracker.crc = crc16_update_slice8(tracker.crc, &data[i], n);
+            }
+            i += n;
+            tracker.remaining -= n;
+            if (tracker.remaining == 0) {
+                tracker.remaining = (tracker.header == YMODEM_LBLK) ? 4 : 2;
+                tracker.state = TRACK_TRAILER;
+            }
+            break;
+        }
+
+        case TRACK_TRAILER: {
+            uint32_t n = length - i;
+            if (n > tracker.remaining) {
+                n = tracker.remaining;
+            }
+            i += n;
+            tracker.remaining -= n;
+            if (tracker.remaining == 0) {
+                record_packet();
+                tracker.state = TRACK_HEADER;
+            }
+            break;
+        }
+        }
+    }
+
+    tracker.received = pos + length;
+}
+
+void cdc_rx_crc_consumed(uint32_t length)
+{
+    tracker.consumed += length;
+}
+
+uint32_t cdc_rx_crc_position(void)
+{
+    return tracker.consumed;
+}
+
+bool cdc_rx_crc_take(uint32_t offset, CdcRxPacket_t *packet)
+{
+    while (tracker.record_tail != tracker.record_head) {
+        __DMB();
+        const CdcRxPacket_t *rec = &tracker.records[tracker.record_tail % CDC_RX_CRC_RECORDS];
+        int32_t diff = (int32_t)(rec->offset - offset);
+        if (diff > 0) {
+            return false;   // 아직 도착하지 않은 위치 (추적이 다른 경계를 따라감)
+        }
+        if (diff == 0) {
+            *packet = *rec;
+        }
+        tracker.record_tail++;  // 복사 후에 슬롯 반환
+        if (diff == 0) {
+            return true;
+        }
+    }
+    return false;
+}
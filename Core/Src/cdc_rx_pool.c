@@ -0,0 +1,139 @@
+/*
+ * cdc_rx_pool.c
+ *
+ *  USB CDC 수신 슬롯 풀 구현
+ *  - 슬롯 k는 누적 채운 수 filled가 k (mod 슬롯 수)일 때 수신, released가 지나가면 빈 슬롯
+ *  - 바이트 수는 bytes_in(생산자)/bytes_out(소비자) 누적값으로 관리 (슬롯별 합산 없이 available)
+ *  - USB HS는 내부 DMA를 쓰지 않으므로 (dma_enable = DISABLE) FIFO → 슬롯 복사는 USB 드라이버가 CPU로 수행
+ *    → 캐시 영역에 두어도 일관성 문제 없음 (DMA를 켜면 캐시 OFF 영역으로 옮기고 32바이트 정렬 유지)
+ */
+
+#include "cdc_rx_pool.h"
+#include <string.h>
+
+__attribute__((aligned(32)))
+static uint8_t slots[CDC_RX_POOL_SLOTS][CDC_RX_SLOT_SIZE];
+
+static struct {
+    uint32_t length[CDC_RX_POOL_SLOTS];     // 슬롯별 수신 길이 (생산자가 채운 뒤 filled 증가)
+    volatile uint32_t filled;               // 누적 채운 슬롯 수 (생산자)
+    volatile uint32_t released;             // 누적 반환 슬롯 수 (소비자)
+    volatile uint32_t bytes_in;             // 누적 수신 바이트 (생산자, filled 다음에 갱신)
+    volatile uint32_t bytes_out;            // 누적 읽은 바이트 (소비자)
+    uint32_t offset;                        // 가장 오래된 슬롯에서 읽은 바이트 (소비자)
+} pool;
+
+void cdc_rx_pool_init(void)
+{
+    memset(&pool, 0, sizeof(pool));
+}
+
+uint8_t *cdc_rx_pool_next(void)
+{
+    uint32_t filled = pool.filled;
+    if (filled - pool.released >= CDC_RX_POOL_SLOTS) {
+        return NULL;
+    }
+    return slots[filled % CDC_RX_POOL_SLOTS];
+}
+
+void cdc_rx_pool_push(uint32_t length)
+{
+    if (length == 0) {
+        return;
+    }
+
+    uint32_t filled = pool.filled;
+    pool.length[filled % CDC_RX_POOL_SLOTS] = length;
+    __DMB();    // 길이가 보인 뒤에 슬롯 공개
+    pool.filled = filled + 1;
+    __DMB();
+    pool.bytes_in += length;
+}
+
+uint32_t cdc_rx_pool_free(void)
+{
+    return CDC_RX_POOL_SLOTS - (pool.filled - pool.released);
+}
+
+uint32_t cdc_rx_pool_available(void)
+{
+    return pool.bytes_in - pool.bytes_out;
+}
+
+uint32_t cdc_rx_pool_peek(const uint8_t **data)
+{
+    uint32_t released = pool.released;
+    if (released == pool.filled) {
+        return 0;
+    }
+
+    __DMB();    // filled 확인 후 길이/데이터 읽기
+    uint32_t index = released % CDC_RX_POOL_SLOTS;
+    *data = &slots[index][pool.offset];
+    return pool.length[index] - pool.offset;
+}
+
+void cdc_rx_pool_release(uint32_t length)
+{
+    uint32_t index = pool.released % CDC_RX_POOL_SLOTS;
+
+    pool.offset += length;
+    pool.bytes_out += length;
+    if (pool.offset >= pool.length[index]) {
+        pool.offset = 0;
+        __DMB();    // 슬롯 데이터를 다 읽은 뒤에 반환
+        pool.released++;
+    }
+}
+
+uint32_t cdc_rx_pool_read(uint8_t *data, uint32_t length)
+{
+    uint32_t done = 0;
+
+    while (done < length) {
+        const uint8_t *span;
+        uint32_t n = cdc_rx_pool_peek(&span);
+        if (n == 0) {
+            break;
+        }
+        if (n > length - done) {
+            n = length - done;
+        }
+        memcpy(&data[done], span, n);
+        cdc_rx_pool_release(n);
+        done += n;
+    }
+    return done;
+}
+
+void cdc_rx_pool_clear(void)
+{
+    uint32_t filled;
+    uint32_t bytes_in;
+
+    // 생산자는 filled → bytes_in 순서로 갱신하므로 filled가 그대로면 두 값이 같은 시점
+    do {
+        filled = pool.filled;
+        bytes_in = pool.bytes_in;
+    } while (filled != pool.filled);
+
+    pool.offset = 0;
+    pool.bytes_out = bytes_in;
+    __DMB();
+    pool.released = filled;
+}
+
+uint8_t *cdc_rx_pool_scratch(uint32_t *size)
+{
+    uint32_t armed = pool.filled % CDC_RX_POOL_SLOTS;
+
+    *size = sizeof(slots) / 2;
+    return (armed < CDC_RX_POOL_SLOTS / 2) ? slots[CDC_RX_POOL_SLOTS / 2] : slots[0];
+}
+
+uint8_t *cdc_rx_pool_storage(uint32_t *size)
+{
+    *size = sizeof(slots);
+    return slots[0];
+}
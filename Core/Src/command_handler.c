@@ -10,6 +10,14 @@
 #include "audio_stream.h"
 #include "ansi_colors.h"
 #include "user_def.h"
+#include "crc_engine.h"
+#include "lz4_stream.h"
+#include "wav_parser.h"
+#include "delta_sync.h"
+#include "usbd_cdc_if.h"  // CDC_Ring_Self_Test(), CDC_Get_Rx_Flow_Stats(), CDC_Get_TX_Stats()
+#include "usbd_storage_if.h"  // STORAGE_Ejected_HS()
+#include "usb_device.h"   // USB_Device_Set_Mode()
+#include "msc_storage.h"
 #include "ff.h"
 #include <string.h>
 #include <stdlib.h>
@@ -22,6 +30,37 @@ extern char SDPath[4];  // SD 카드 경로 ("0:")
 // Y-MODEM 업로드 요청 전역 변수
 volatile UploadRequest_t upload_request = {0};
 
+// USB MSC 전환 요청 (MSC 명령 → 메인 루프에서 재열거)
+typedef enum {
+    MSC_REQUEST_NONE = 0,
+    MSC_REQUEST_ATTACH,     // 볼륨을 호스트에 넘기고 MSC로 재열거
+    MSC_REQUEST_DETACH,     // CDC로 재열거 후 FatFs 다시 마운트
+    MSC_REQUEST_BENCH       // MSCBENCH (SD 다중 블록 측정은 수신 인터럽트 밖에서)
+} MscRequest_t;
+
+static volatile MscRequest_t msc_request = MSC_REQUEST_NONE;
+static volatile uint32_t msc_bench_kb = 0;
+
+// 긴 SD 작업 요청 (명령은 인수만 기록 → 메인 루프에서 실행 후 응답)
+// 수신 인터럽트에서 수 초씩 FatFs를 쓰면 오디오 스트리밍의 f_read와 겹치고 USB/메인 루프가 멈춤
+typedef enum {
+    SD_JOB_NONE = 0,
+    SD_JOB_SDBENCH,         // SDBENCH (업로드 기록 경로, 확장 vs 사전 할당)
+    SD_JOB_VERIFY,          // VERIFY (파일 전체 CRC-32 재계산)
+    SD_JOB_WAVBENCH,        // WAVBENCH (포맷별 임시 WAV 기록 → 재생 경로로 읽기)
+    SD_JOB_SIGS             // SIGS (기준 파일 전체 읽기 → "<파일>.sig" 기록)
+} SdJob_t;
+
+static volatile SdJob_t sd_job = SD_JOB_NONE;
+static uint32_t sd_job_arg = 0;     // 크기/길이 인수
+static char sd_job_path[128];       // 대상 파일 경로
+
+// 메인 루프에서 실행 대기 중인 SD 작업 (같은 FatFs 볼륨과 sdmmc1_buffer를 쓰므로 하나씩만)
+static bool sd_task_pending(void)
+{
+    return (sd_job != SD_JOB_NONE) || (msc_request != MSC_REQUEST_NONE);
+}
+
 // Helper function to convert audio state to string
 static const char* get_state_string(AudioChannelState_t state)
 {
@@ -36,6 +75,85 @@ static const char* get_state_string(AudioChannelState_t state)
     }
 }
 
+// 업로드 옵션 인수 파싱 ("G" / "W" 전송 모드, "LZ4" 압축, "X" 확장 블록, "RXCRC" 수신 중 CRC 계산,
+//                     "PCM12" / "PACK12" 재생 포맷 변환)
+// 잘못된 값이면 에러 응답 후 false
+static bool parse_upload_mode(UartCommand_t *cmd, int arg_index, YmodemMode_t *mode, uint32_t *options)
+{
+    *mode = YMODEM_MODE_STANDARD;
+    *options = 0;
+
+    for (int i = arg_index; i < cmd->argc; i++) {
+        if (strcmp(cmd->argv[i], "G") == 0 && *mode == YMODEM_MODE_STANDARD) {
+            *mode = YMODEM_MODE_G;
+        } else if (strcmp(cmd->argv[i], "W") == 0 && *mode == YMODEM_MODE_STANDARD) {
+            *mode = YMODEM_MODE_WINDOW;
+        } else if (strcmp(cmd->argv[i], "LZ4") == 0 && !(*options & YMODEM_OPT_LZ4)) {
+            *options |= YMODEM_OPT_LZ4;
+        } else if (strcmp(cmd->argv[i], "X") == 0 && !(*options & YMODEM_OPT_LARGE_BLOCKS)) {
+            *options |= YMODEM_OPT_LARGE_BLOCKS;
+        } else if (strcmp(cmd->argv[i], "RXCRC") == 0 && !(*options & YMODEM_OPT_RX_CRC)) {
+            *options |= YMODEM_OPT_RX_CRC;
+        } else if (strcmp(cmd->argv[i], "PCM12") == 0 &&
+                   !(*options & (YMODEM_OPT_NATIVE_PCM12 | YMODEM_OPT_NATIVE_PACKED12))) {
+            *options |= YMODEM_OPT_NATIVE_PCM12;
+        } else if (strcmp(cmd->argv[i], "PACK12") == 0 &&
+                   !(*options & (YMODEM_OPT_NATIVE_PCM12 | YMODEM_OPT_NATIVE_PACKED12))) {
+            *options |= YMODEM_OPT_NATIVE_PACKED12;
+        } else {
+            uart_send_error(401, "Invalid upload mode (must be G, W, LZ4, X, RXCRC, PCM12 or PACK12)");
+            return false;
+        }
+    }
+
+    if ((*mode != YMODEM_MODE_STANDARD || (*options & (YMODEM_OPT_LARGE_BLOCKS | YMODEM_OPT_RX_CRC))) &&
+        get_command_transport() != CMD_TRANSPORT_USB_CDC) {
+        uart_send_error(401, "Upload mode requires USB CDC");
+        return false;
+    }
+
+    // 확장 블록은 스테이징 버퍼에 직접 착지해야 함 (윈도우 슬롯/LZ4 입력 버퍼는 1KB)
+    if ((*options & YMODEM_OPT_LARGE_BLOCKS) &&
+        (*mode == YMODEM_MODE_WINDOW || (*options & YMODEM_OPT_LZ4))) {
+        uart_send_error(401, "X cannot be combined with W or LZ4");
+        return false;
+    }
+
+    // 변환 업로드도 ymodem_packet_buffer에 받아 변환 결과를 스테이징 (확장 블록은 착지 필수)
+    if ((*options & YMODEM_OPT_LARGE_BLOCKS) &&
+        (*options & (YMODEM_OPT_NATIVE_PCM12 | YMODEM_OPT_NATIVE_PACKED12))) {
+        uart_send_error(401, "X cannot be combined with PCM12 or PACK12");
+        return false;
+    }
+
+    return true;
+}
+
+// 준비 응답 접미사 (예: " batch", " resume 1048576" + " LZ4" / " X8192" / " PACK12")
+static void format_ready_suffix(char *suffix, uint32_t size, const char *prefix, uint32_t options)
+{
+    int len = snprintf(suffix, size, "%s%s", prefix, (options & YMODEM_OPT_LZ4) ? " LZ4" : "");
+
+    if ((options & YMODEM_OPT_LARGE_BLOCKS) && len >= 0 && (uint32_t)len < size) {
+        len += snprintf(suffix + len, size - len, " X%d", YMODEM_LARGE_PACKET_SIZE);
+    }
+    if ((options & (YMODEM_OPT_NATIVE_PCM12 | YMODEM_OPT_NATIVE_PACKED12)) && len >= 0 && (uint32_t)len < size) {
+        snprintf(suffix + len, size - len, "%s", (options & YMODEM_OPT_NATIVE_PACKED12) ? " PACK12" : " PCM12");
+    }
+}
+
+// Y-MODEM 준비 완료 응답
+static void send_upload_ready(YmodemMode_t mode, const char *suffix)
+{
+    if (mode == YMODEM_MODE_G) {
+        uart_send_response(ANSI_OK " Ready for Y-MODEM-G%s\r\n", suffix);
+    } else if (mode == YMODEM_MODE_WINDOW) {
+        uart_send_response(ANSI_OK " Ready for Y-MODEM-W %d%s\r\n", YMODEM_WINDOW_SIZE, suffix);
+    } else {
+        uart_send_response(ANSI_OK " Ready for Y-MODEM%s\r\n", suffix);
+    }
+}
+
 // 명령 실행
 void execute_command(UartCommand_t *cmd)
 {
@@ -74,6 +192,12 @@ void execute_command(UartCommand_t *cmd)
             return;
         }
 
+        // 업로드는 메인 루프에서 진행되므로 동시에 하나만 허용
+        if (upload_request.requested || ymodem_is_active()) {
+            uart_send_error(403, "Upload already in progress");
+            return;
+        }
+
         int channel = atoi(cmd->argv[0]);
         char *filename = cmd->argv[1];
 
@@ -221,6 +345,12 @@ void execute_command(UartCommand_t *cmd)
         FRESULT res = f_unlink(file_path);
 
         if (res == FR_OK) {
+            // 수신 시 남긴 다이제스트/진행 기록도 함께 삭제 (없으면 무시)
+            char side_path[sizeof(file_path) + 8];
+            snprintf(side_path, sizeof(side_path), "%s" YMODEM_DIGEST_SUFFIX, file_path);
+            f_unlink(side_path);
+            snprintf(side_path, sizeof(side_path), "%s" YMODEM_PROGRESS_SUFFIX, file_path);
+            f_unlink(side_path);
             uart_send_response(ANSI_OK " Deleted %s\r\n", file_path);
         } else {
             uart_send_error(404, "File not found or delete failed");
@@ -240,7 +370,18 @@ void execute_command(UartCommand_t *cmd)
         int channel = atoi(cmd->argv[0]);
         char *filename = cmd->argv[1];
 
-        printf("[DEBUG] UPLOAD: ch=%d, file=%s\r\n", channel, filename);
+        // 옵션: UPLOAD <ch> <file> G  -> Y-MODEM-G 스트리밍 (USB CDC 전용)
+        //       UPLOAD <ch> <file> W  -> 슬라이딩 윈도우 (USB CDC 전용)
+        //       UPLOAD <ch> <file> [G|W] LZ4 -> 데이터를 LZ4 프레임으로 전송
+        //       UPLOAD <ch> <file> [G] X -> 8KB 확장 블록 + CRC-32 (USB CDC 전용)
+        //       UPLOAD <ch> <file> [G|W] [LZ4] PCM12|PACK12 -> 16비트 WAV를 재생 포맷으로 변환해 저장
+        YmodemMode_t mode;
+        uint32_t options;
+        if (!parse_upload_mode(cmd, 2, &mode, &options)) {
+            return;
+        }
+
+        printf("[DEBUG] UPLOAD: ch=%d, file=%s, mode=%d\r\n", channel, filename, mode);
 
         if (channel < 0 || channel > 5) {
             printf("[DEBUG] UPLOAD: invalid channel %d\r\n", channel);
@@ -259,11 +400,19 @@ void execute_command(UartCommand_t *cmd)
         snprintf((char*)upload_request.file_path, sizeof(upload_request.file_path),
                  "/audio/ch%d/%s", channel, filename);
         upload_request.channel = channel;
+        upload_request.mode = mode;
+        upload_request.batch = false;
+        upload_request.resume_offset = 0;
+        upload_request.options = options;
+        upload_request.download = false;
+        upload_request.simulate = false;
 
         printf("[DEBUG] UPLOAD: sending Ready response\r\n");
 
         // Y-MODEM 준비 완료 응답 (인터럽트 핸들러에서는 여기까지만)
-        uart_send_response(ANSI_OK " Ready for Y-MODEM\r\n");
+        char suffix[32];
+        format_ready_suffix(suffix, sizeof(suffix), "", options);
+        send_upload_ready(mode, suffix);
 
         // 플래그 설정 (메인 루프에서 처리)
         upload_request.requested = true;
@@ -271,6 +420,330 @@ void execute_command(UartCommand_t *cmd)
         printf("[DEBUG] UPLOAD: request queued, will process in main loop\r\n");
     }
 
+    // BATCH 명령 (Y-MODEM 배치 업로드: 블록 0 파일명으로 /audio 아래 경로 결정)
+    else if (strcmp(cmd->command, "BATCH") == 0) {
+        if (upload_request.requested || ymodem_is_active()) {
+            uart_send_error(403, "Upload already in progress");
+            return;
+        }
+
+        // 옵션: BATCH [G|W] [LZ4] [X] [PCM12|PACK12] (UPLOAD와 동일)
+        YmodemMode_t mode;
+        uint32_t options;
+        if (!parse_upload_mode(cmd, 0, &mode, &options)) {
+            return;
+        }
+
+        upload_request.file_path[0] = '\0';
+        upload_request.channel = -1;
+        upload_request.mode = mode;
+        upload_request.batch = true;
+        upload_request.resume_offset = 0;
+        upload_request.options = options;
+        upload_request.download = false;
+        upload_request.simulate = false;
+
+        char suffix[32];
+        format_ready_suffix(suffix, sizeof(suffix), " batch", options);
+        send_upload_ready(mode, suffix);
+
+        // 플래그 설정 (메인 루프에서 처리)
+        upload_request.requested = true;
+    }
+
+    // RESUME 명령 (중단된 업로드 이어받기)
+    // 응답의 오프셋부터 송신: 블록 0은 전체 크기, 데이터는 오프셋 위치부터 블록 1로 시작
+    else if (strcmp(cmd->command, "RESUME") == 0) {
+        if (cmd->argc < 2) {
+            uart_send_error(401, "Invalid arguments: RESUME requires 2 arguments");
+            return;
+        }
+        if (upload_request.requested || ymodem_is_active()) {
+            uart_send_error(403, "Upload already in progress");
+            return;
+        }
+
+        int channel = atoi(cmd->argv[0]);
+        if (channel < 0 || channel > 5) {
+            uart_send_error(402, "Invalid channel (must be 0~5)");
+            return;
+        }
+
+        // 옵션: RESUME <ch> <file> [G|W] [LZ4] [X] (UPLOAD와 동일)
+        YmodemMode_t mode;
+        uint32_t options;
+        if (!parse_upload_mode(cmd, 2, &mode, &options)) {
+            return;
+        }
+        // 변환된 파일 위치는 원본 전송 위치와 다름 (변환 업로드는 처음부터 다시)
+        if (options & (YMODEM_OPT_NATIVE_PCM12 | YMODEM_OPT_NATIVE_PACKED12)) {
+            uart_send_error(401, "PCM12/PACK12 cannot resume");
+            return;
+        }
+
+        snprintf((char*)upload_request.file_path, sizeof(upload_request.file_path),
+                 "/audio/ch%d/%s", channel, cmd->argv[1]);
+        upload_request.channel = channel;
+        upload_request.mode = mode;
+        upload_request.batch = false;
+        upload_request.resume_offset = ymodem_resume_offset((const char*)upload_request.file_path);
+        upload_request.options = options;
+        upload_request.download = false;
+        upload_request.simulate = false;
+
+        printf("[DEBUG] RESUME: %s from %lu bytes\r\n",
+               upload_request.file_path, upload_request.resume_offset);
+
+        char prefix[24];
+        char suffix[40];
+        snprintf(prefix, sizeof(prefix), " resume %lu", upload_request.resume_offset);
+        format_ready_suffix(suffix, sizeof(suffix), prefix, options);
+        send_upload_ready(mode, suffix);
+
+        // 플래그 설정 (메인 루프에서 처리)
+        upload_request.requested = true;
+    }
+
+    // DOWNLOAD 명령 (SD 파일을 Y-MODEM으로 호스트에 송신)
+    // 응답 후 PC는 Y-MODEM 수신을 시작 ('C' 전송)
+    else if (strcmp(cmd->command, "DOWNLOAD") == 0) {
+        if (cmd->argc < 2) {
+            uart_send_error(401, "Invalid arguments: DOWNLOAD requires 2 arguments");
+            return;
+        }
+        if (upload_request.requested || ymodem_is_active()) {
+            uart_send_error(403, "Upload already in progress");
+            return;
+        }
+
+        int channel = atoi(cmd->argv[0]);
+        if (channel < 0 || channel > 5) {
+            uart_send_error(402, "Invalid channel (must be 0~5)");
+            return;
+        }
+
+        snprintf((char*)upload_request.file_path, sizeof(upload_request.file_path),
+                 "/audio/ch%d/%s", channel, cmd->argv[1]);
+
+        FILINFO fno;
+        if (f_stat((const char*)upload_request.file_path, &fno) != FR_OK) {
+            uart_send_error(404, "File not found");
+            return;
+        }
+
+        upload_request.channel = channel;
+        upload_request.mode = YMODEM_MODE_STANDARD;
+        upload_request.batch = false;
+        upload_request.resume_offset = 0;
+        upload_request.options = 0;
+        upload_request.download = true;
+        upload_request.simulate = false;
+
+        uart_send_response(ANSI_OK " Ready for Y-MODEM send %lu\r\n", (uint32_t)fno.fsize);
+
+        // 플래그 설정 (메인 루프에서 처리)
+        upload_request.requested = true;
+    }
+
+    // VERIFY 명령 (SD 파일 CRC-32 재계산 후 수신 시 기록한 다이제스트와 비교)
+    // 응답: OK VERIFY <크기> <CRC-32> MATCH | MISMATCH | NODIGEST
+    // PC는 원본 CRC-32와 비교해 같으면 재업로드 생략
+    else if (strcmp(cmd->command, "VERIFY") == 0) {
+        if (cmd->argc < 2) {
+            uart_send_error(401, "Invalid arguments: VERIFY requires 2 arguments");
+            return;
+        }
+        if (upload_request.requested || ymodem_is_active()) {
+            uart_send_error(403, "Upload in progress");
+            return;
+        }
+        // 파일 전체를 sdmmc1_buffer로 읽으므로 MSCBENCH 등 다른 SD 작업과 겹치면 안 됨
+        if (sd_task_pending()) {
+            uart_send_error(403, "SD task in progress");
+            return;
+        }
+
+        int channel = atoi(cmd->argv[0]);
+        if (channel < 0 || channel > 5) {
+            uart_send_error(402, "Invalid channel (must be 0~5)");
+            return;
+        }
+
+        // 12MB급 파일은 1~2초 걸리므로 응답은 메인 루프에서 (process_sd_job_request)
+        snprintf(sd_job_path, sizeof(sd_job_path), "/audio/ch%d/%s", channel, cmd->argv[1]);
+        sd_job = SD_JOB_VERIFY;
+    }
+
+    // SIGS 명령 (차등 업로드용 블록 서명 생성: "<파일>.sig")
+    // 응답: OK SIGS <서명 파일> <블록 크기> <블록 수>, PC는 DOWNLOAD로 서명을 받아 차등 스트림 생성
+    else if (strcmp(cmd->command, "SIGS") == 0) {
+        if (cmd->argc < 2) {
+            uart_send_error(401, "Invalid arguments: SIGS requires 2 arguments");
+            return;
+        }
+        if (upload_request.requested || ymodem_is_active()) {
+            uart_send_error(403, "Upload in progress");
+            return;
+        }
+        // 기준 파일을 sdmmc1_buffer로 읽으므로 MSCBENCH 등 다른 SD 작업과 겹치면 안 됨
+        if (sd_task_pending()) {
+            uart_send_error(403, "SD task in progress");
+            return;
+        }
+
+        int channel = atoi(cmd->argv[0]);
+        if (channel < 0 || channel > 5) {
+            uart_send_error(402, "Invalid channel (must be 0~5)");
+            return;
+        }
+
+        uint32_t block_size = (cmd->argc >= 3) ? (uint32_t)atoi(cmd->argv[2]) : DELTA_BLOCK_DEFAULT;
+        if (block_size < DELTA_BLOCK_MIN || block_size > DELTA_BLOCK_MAX || (block_size & (block_size - 1)) != 0) {
+            uart_send_error(401, "Invalid block size (512~8192, power of two)");
+            return;
+        }
+
+        // 파일 전체를 읽고 서명 파일을 쓰므로 응답은 메인 루프에서 (process_sd_job_request)
+        snprintf(sd_job_path, sizeof(sd_job_path), "/audio/ch%d/%s", channel, cmd->argv[1]);
+        sd_job_arg = block_size;
+        sd_job = SD_JOB_SIGS;
+    }
+
+    // SYNC 명령 (차등 업로드: 데이터 블록은 SIGS 서명으로 만든 [리터럴 | 블록 참조] 스트림)
+    // 블록 0 크기는 새 파일 크기, 기존 파일은 검증 성공 후에만 교체
+    else if (strcmp(cmd->command, "SYNC") == 0) {
+        if (cmd->argc < 2) {
+            uart_send_error(401, "Invalid arguments: SYNC requires 2 arguments");
+            return;
+        }
+        if (upload_request.requested || ymodem_is_active()) {
+            uart_send_error(403, "Upload already in progress");
+            return;
+        }
+
+        int channel = atoi(cmd->argv[0]);
+        if (channel < 0 || channel > 5) {
+            uart_send_error(402, "Invalid channel (must be 0~5)");
+            return;
+        }
+
+        // 옵션: SYNC <ch> <file> [LZ4] [RXCRC]
+        // 블록 참조 복사는 ACK 전에 끝내야 하므로 표준 모드만 (G/W는 복사 중 링 버퍼가 넘침)
+        YmodemMode_t mode;
+        uint32_t options;
+        if (!parse_upload_mode(cmd, 2, &mode, &options)) {
+            return;
+        }
+        if (mode != YMODEM_MODE_STANDARD || (options & ~(YMODEM_OPT_LZ4 | YMODEM_OPT_RX_CRC))) {
+            uart_send_error(401, "SYNC supports only LZ4 and RXCRC");
+            return;
+        }
+
+        snprintf((char*)upload_request.file_path, sizeof(upload_request.file_path),
+                 "/audio/ch%d/%s", channel, cmd->argv[1]);
+
+        FILINFO fno;
+        if (f_stat((const char*)upload_request.file_path, &fno) != FR_OK) {
+            uart_send_error(404, "File not found");
+            return;
+        }
+
+        upload_request.channel = channel;
+        upload_request.mode = mode;
+        upload_request.batch = false;
+        upload_request.resume_offset = 0;
+        upload_request.options = options | YMODEM_OPT_DELTA;
+        upload_request.download = false;
+        upload_request.simulate = false;
+
+        char suffix[32];
+        format_ready_suffix(suffix, sizeof(suffix), " delta", options);
+        send_upload_ready(mode, suffix);
+
+        // 플래그 설정 (메인 루프에서 처리)
+        upload_request.requested = true;
+    }
+
+    // YSIM 명령 (내부 송신기로 Y-MODEM 수신 경로 시뮬레이션, 호스트 전송 없음)
+    // YSIM <SIZE_KB> [DELAY_US] [KBPS] [SD_US] [G] [X] [F<N>] [D<EDIT_KB>]
+    else if (strcmp(cmd->command, "YSIM") == 0) {
+        if (cmd->argc < 1) {
+            uart_send_error(401, "Invalid arguments: YSIM requires size");
+            return;
+        }
+        if (upload_request.requested || ymodem_is_active()) {
+            uart_send_error(403, "Upload already in progress");
+            return;
+        }
+
+        YmodemSimConfig_t config = { 0 };
+        uint32_t size_kb = (uint32_t)atoi(cmd->argv[0]);
+        if (size_kb < 1 || size_kb > 65536) {
+            uart_send_error(401, "Invalid size (1~65536 KB)");
+            return;
+        }
+        config.size = size_kb * 1024;
+        config.mode = YMODEM_MODE_STANDARD;
+
+        // 숫자 인수는 순서대로 지연/속도/SD 지연, "G"/"X"/"F<N>"(N블록마다 장애 주입)은 위치 무관
+        // "D<EDIT_KB>": 기존 파일 중간 EDIT_KB만 바뀐 새 파일을 차등 업로드 (SIGS + SYNC 경로)
+        uint32_t *models[] = { &config.link_delay_us, &config.link_kbps, &config.sd_latency_us };
+        int model_count = 0;
+        for (int i = 1; i < cmd->argc; i++) {
+            if (strcmp(cmd->argv[i], "G") == 0) {
+                config.mode = YMODEM_MODE_G;
+            } else if (strcmp(cmd->argv[i], "X") == 0) {
+                config.large_blocks = true;
+            } else if (cmd->argv[i][0] == 'F' && atoi(&cmd->argv[i][1]) > 0) {
+                config.fault_interval = (uint32_t)atoi(&cmd->argv[i][1]);
+            } else if (cmd->argv[i][0] == 'D' && atoi(&cmd->argv[i][1]) > 0) {
+                config.delta_edit_kb = (uint32_t)atoi(&cmd->argv[i][1]);
+            } else if (model_count < 3) {
+                *models[model_count++] = (uint32_t)atoi(cmd->argv[i]);
+            } else {
+                uart_send_error(401, "Invalid arguments: YSIM <SIZE_KB> [DELAY_US] [KBPS] [SD_US] [G] [X] [F<N>] [D<EDIT_KB>]");
+                return;
+            }
+        }
+        if (config.fault_interval != 0 && config.mode != YMODEM_MODE_STANDARD) {
+            uart_send_error(401, "Fault injection (F) cannot be combined with G");
+            return;
+        }
+        if (config.delta_edit_kb != 0 && (config.mode != YMODEM_MODE_STANDARD || config.large_blocks)) {
+            uart_send_error(401, "Delta sync (D) cannot be combined with G or X");
+            return;
+        }
+        if (config.delta_edit_kb > size_kb) {
+            uart_send_error(401, "Delta edit larger than file");
+            return;
+        }
+
+        upload_request.sim_config = config;
+        upload_request.mode = config.mode;
+        upload_request.batch = false;
+        upload_request.resume_offset = 0;
+        upload_request.options = config.large_blocks ? YMODEM_OPT_LARGE_BLOCKS : 0;
+        upload_request.download = false;
+        upload_request.simulate = true;
+        snprintf((char*)upload_request.file_path, sizeof(upload_request.file_path), "%s", YMODEM_SIM_PATH);
+
+        char fault_desc[24] = "";
+        char delta_desc[24] = "";
+        if (config.fault_interval != 0) {
+            snprintf(fault_desc, sizeof(fault_desc), ", fault every %lu", config.fault_interval);
+        }
+        if (config.delta_edit_kb != 0) {
+            snprintf(delta_desc, sizeof(delta_desc), ", delta %lu KB", config.delta_edit_kb);
+        }
+        uart_send_response(ANSI_OK " YSIM started %lu KB, delay %lu us, %lu KB/s, SD %lu us%s%s%s%s\r\n",
+                           size_kb, config.link_delay_us, config.link_kbps, config.sd_latency_us,
+                           (config.mode == YMODEM_MODE_G) ? ", G" : "",
+                           config.large_blocks ? ", X" : "", fault_desc, delta_desc);
+
+        // 플래그 설정 (메인 루프에서 처리)
+        upload_request.requested = true;
+    }
+
     // RESET 명령
     else if (strcmp(cmd->command, "RESET") == 0) {
         uart_send_response(ANSI_OK " Resetting...\r\n");
@@ -307,6 +780,227 @@ void execute_command(UartCommand_t *cmd)
         uart_send_response(ANSI_OK " Test complete\r\n");
     }
 
+    // CRCTEST 명령 (CRC-16 엔진 검증 및 성능 측정)
+    else if (strcmp(cmd->command, "CRCTEST") == 0) {
+        // 하드웨어 CRC 유닛은 수신 중 CRC-32 계산과 공유
+        if (upload_request.requested || ymodem_is_active()) {
+            uart_send_error(403, "Upload in progress");
+            return;
+        }
+
+        char report[384];
+        int failures = crc_engine_self_test(report, sizeof(report));
+
+        if (failures == 0) {
+            uart_send_response(ANSI_OK " CRCTEST\r\n%sEND\r\n", report);
+        } else {
+            uart_send_response("%sEND\r\n", report);
+            uart_send_error(500, "CRC engine mismatch");
+        }
+    }
+
+    // LZ4TEST 명령 (압축 업로드 해제기 검증 및 속도 측정)
+    else if (strcmp(cmd->command, "LZ4TEST") == 0) {
+        if (upload_request.requested || ymodem_is_active()) {
+            uart_send_error(403, "Upload in progress");
+            return;
+        }
+
+        char report[192];
+        if (lz4_stream_self_test(report, sizeof(report)) == 0) {
+            uart_send_response(ANSI_OK " LZ4TEST\r\n%sEND\r\n", report);
+        } else {
+            uart_send_response("%sEND\r\n", report);
+            uart_send_error(500, "LZ4 decoder mismatch");
+        }
+    }
+
+    // RINGTEST 명령 (USB CDC 수신 링 버퍼 래핑 검증 및 속도 측정)
+    else if (strcmp(cmd->command, "RINGTEST") == 0) {
+        // 시험 중에는 링 버퍼 저장 공간을 빌림
+        if (upload_request.requested || ymodem_is_active()) {
+            uart_send_error(403, "Upload in progress");
+            return;
+        }
+
+        char report[384];
+        if (CDC_Ring_Self_Test(report, sizeof(report)) == 0) {
+            uart_send_response(ANSI_OK " RINGTEST\r\n%sEND\r\n", report);
+        } else {
+            uart_send_response("%sEND\r\n", report);
+            uart_send_error(500, "Ring buffer mismatch");
+        }
+    }
+
+    // YSTATS 명령 (마지막 Y-MODEM 수신의 구간별 시간 통계)
+    else if (strcmp(cmd->command, "YSTATS") == 0) {
+        if (cmd->argc >= 1 && strcmp(cmd->argv[0], "RESET") == 0) {
+            ymodem_stats_reset();
+            uart_send_response(ANSI_OK " YSTATS reset\r\n");
+            return;
+        }
+
+        // 응답 버퍼 크기 제한으로 구간마다 한 줄씩 전송
+        char line[192];
+        uart_send_response(ANSI_OK " YSTATS\r\n");
+        for (int i = 0; i < YMODEM_PHASE_COUNT; i++) {
+            ymodem_stats_format((YmodemPhase_t)i, line, sizeof(line));
+            uart_send_response("%s\r\n", line);
+        }
+        // USB CDC 수신 흐름 제어 (수신 버퍼 부족으로 NAK 보류한 횟수/시간)
+        CdcRxFlowStats_t flow;
+        CDC_Get_Rx_Flow_Stats(&flow);
+        uart_send_response("RX_FLOW  pauses=%lu resumes=%lu stall=%lu max=%lu us\r\n",
+                           flow.pauses, flow.resumes, flow.stall_us, flow.max_stall_us);
+        // USB CDC 전송 큐 (메시지를 모아 보낸 USB 전송 수, 큐 적재 → 전송 완료 지연, 전송 중 처리량)
+        CdcTxStats_t tx;
+        CDC_Get_TX_Stats(&tx);
+        uart_send_response("TX_QUEUE msgs=%lu packets=%lu bytes=%lu drops=%lu depth=%lu lat avg=%lu max=%lu us %lu KB/s\r\n",
+                           tx.messages, tx.packets, tx.bytes, tx.drops, tx.max_queued,
+                           (tx.packets > 0) ? tx.latency_us / tx.packets : 0, tx.max_latency_us,
+                           (tx.busy_us > 0) ? (uint32_t)(((uint64_t)tx.bytes * 1000000 / tx.busy_us) / 1024) : 0);
+        uart_send_response("END\r\n");
+    }
+
+    // YTIMING 명령 (적응 타임아웃 측정값: 구간별 SRTT/RTTVAR와 현재 타임아웃)
+    else if (strcmp(cmd->command, "YTIMING") == 0) {
+        if (cmd->argc >= 1 && strcmp(cmd->argv[0], "RESET") == 0) {
+            if (ymodem_is_active()) {
+                uart_send_error(403, "Upload in progress");
+                return;
+            }
+            ymodem_timing_reset();
+            uart_send_response(ANSI_OK " YTIMING reset\r\n");
+            return;
+        }
+
+        char line[128];
+        uart_send_response(ANSI_OK " YTIMING\r\n");
+        for (int i = 0; i < YMODEM_EST_COUNT; i++) {
+            ymodem_timing_format((YmodemEstimator_t)i, line, sizeof(line));
+            uart_send_response("%s\r\n", line);
+        }
+        uart_send_response("END\r\n");
+    }
+
+    // SDBENCH 명령 (업로드 SD 기록 경로: 클러스터 단위 확장 vs 연속 사전 할당)
+    else if (strcmp(cmd->command, "SDBENCH") == 0) {
+        uint32_t size_kb = (cmd->argc >= 1) ? (uint32_t)atoi(cmd->argv[0]) : 4096;
+
+        if (size_kb < 64 || size_kb > 65536) {
+            uart_send_error(401, "Invalid size (64~65536 KB)");
+            return;
+        }
+        if (upload_request.requested || ymodem_is_active()) {
+            uart_send_error(403, "Upload in progress");
+            return;
+        }
+        if (sd_task_pending()) {
+            uart_send_error(403, "SD task in progress");
+            return;
+        }
+
+        // 최대 64MB씩 두 번 기록하므로 응답은 메인 루프에서 측정이 끝난 뒤 (process_sd_job_request)
+        sd_job_arg = size_kb;
+        sd_job = SD_JOB_SDBENCH;
+    }
+
+    // WAVBENCH 명령 (재생 포맷별 SD 바이트/오디오 초와 읽기 속도: PCM16 / PCM12 / PACK12)
+    else if (strcmp(cmd->command, "WAVBENCH") == 0) {
+        uint32_t seconds = (cmd->argc >= 1) ? (uint32_t)atoi(cmd->argv[0]) : 10;
+
+        if (seconds < 1 || seconds > 600) {
+            uart_send_error(401, "Invalid length (1~600 s)");
+            return;
+        }
+        // 업로드 스테이징 버퍼(sdmmc1_buffer)를 같이 사용
+        if (upload_request.requested || ymodem_is_active()) {
+            uart_send_error(403, "Upload in progress");
+            return;
+        }
+        if (sd_task_pending()) {
+            uart_send_error(403, "SD task in progress");
+            return;
+        }
+
+        // 최대 600초 분량(약 19MB)을 기록하고 다시 읽으므로 응답은 메인 루프에서 (process_sd_job_request)
+        sd_job_arg = seconds;
+        sd_job = SD_JOB_WAVBENCH;
+    }
+
+    // MSC 명령 (SD 볼륨을 USB 대용량 저장 장치로 호스트에 넘김 / 돌려받음, 인수 없으면 상태)
+    else if (strcmp(cmd->command, "MSC") == 0) {
+        if (cmd->argc < 1) {
+            MscStorageStats_t st;
+            msc_storage_stats(&st);
+            uint32_t read_rate = (st.read_us > 0) ? (uint32_t)(((uint64_t)st.read_blocks * 512 * 100) / st.read_us) : 0;
+            uint32_t write_rate = (st.write_us > 0) ? (uint32_t)(((uint64_t)st.write_blocks * 512 * 100) / st.write_us) : 0;
+            uint32_t usb_read_rate = (st.usb_read_us > 0) ? (uint32_t)(((uint64_t)st.usb_read_blocks * 512 * 100) / st.usb_read_us) : 0;
+            uint32_t usb_write_rate = (st.usb_write_us > 0) ? (uint32_t)(((uint64_t)st.usb_write_blocks * 512 * 100) / st.usb_write_us) : 0;
+            uart_send_response(ANSI_OK " MSC %s %lu ms read %lu KB %lu.%02lu MB/s write %lu KB %lu.%02lu MB/s"
+                               " usb read %lu.%02lu MB/s write %lu.%02lu MB/s errors %lu\r\n",
+                               msc_storage_host_owned() ? "HOST" : "FIRMWARE", st.attached_ms,
+                               st.read_blocks / 2, read_rate / 100, read_rate % 100,
+                               st.write_blocks / 2, write_rate / 100, write_rate % 100,
+                               usb_read_rate / 100, usb_read_rate % 100,
+                               usb_write_rate / 100, usb_write_rate % 100, st.errors);
+            return;
+        }
+
+        if (strcmp(cmd->argv[0], "ON") == 0) {
+            if (!USBD_MSC_ENABLE) {
+                uart_send_error(501, "USB MSC class not built");
+                return;
+            }
+            if (upload_request.requested || ymodem_is_active()) {
+                uart_send_error(403, "Upload in progress");
+                return;
+            }
+            if (msc_storage_host_owned()) {
+                uart_send_response(ANSI_OK " MSC HOST\r\n");
+                return;
+            }
+            if (sd_task_pending()) {
+                uart_send_error(403, "SD task in progress");
+                return;
+            }
+            // 재생 정지와 마운트 해제는 audio_stream_task()의 f_read와 겹치지 않도록 메인 루프에서,
+            // 응답(OK MSC HOST 또는 에러)도 마운트 해제 결과를 보고 process_msc_request()가 전송
+            msc_request = MSC_REQUEST_ATTACH;
+        } else if (strcmp(cmd->argv[0], "OFF") == 0) {
+            uart_send_response(ANSI_OK " MSC FIRMWARE\r\n");
+            // 아직 마운트 해제 전인 MSC ON도 취소 (해제가 먼저 끝났으면 다시 마운트)
+            if (msc_storage_host_owned() || msc_request == MSC_REQUEST_ATTACH) {
+                msc_request = MSC_REQUEST_DETACH;
+            }
+        } else {
+            uart_send_error(401, "Invalid arguments: MSC [ON|OFF]");
+        }
+    }
+
+    // MSCBENCH 명령 (MSC 블록 경로의 지속 전송 속도: 미디어 패킷 크기별 SD 다중 블록 읽기/쓰기)
+    else if (strcmp(cmd->command, "MSCBENCH") == 0) {
+        uint32_t size_kb = (cmd->argc >= 1) ? (uint32_t)atoi(cmd->argv[0]) : 4096;
+
+        if (size_kb < 64 || size_kb > 65536 || (size_kb % 32) != 0) {
+            uart_send_error(401, "Invalid size (64~65536 KB, multiple of 32)");
+            return;
+        }
+        // 업로드 스테이징 버퍼(sdmmc1_buffer)를 같이 사용, 호스트 소유 중에는 FatFs가 없으므로 불가
+        if (upload_request.requested || ymodem_is_active() || msc_storage_host_owned()) {
+            uart_send_error(403, "Upload in progress");
+            return;
+        }
+        if (sd_task_pending()) {
+            uart_send_error(403, "SD task in progress");
+            return;
+        }
+
+        // 수십 MB SD 전송이므로 응답은 메인 루프에서 측정이 끝난 뒤 (process_msc_request)
+        msc_bench_kb = size_kb;
+        msc_request = MSC_REQUEST_BENCH;
+    }
+
     // SPITEST 명령 (SPI 통신 테스트)
     else if (strcmp(cmd->command, "SPITEST") == 0) {
         if (cmd->argc < 1) {
@@ -409,34 +1103,290 @@ void execute_command(UartCommand_t *cmd)
  * @brief  메인 루프에서 호출하여 Y-MODEM 업로드 요청 처리
  *         인터럽트 핸들러가 아닌 메인 컨텍스트에서 실행되므로
  *         USB CDC 전송 완료 인터럽트가 정상 처리됨
+ *         전송 중에는 호출마다 ymodem_poll() 한 단계만 실행 (오디오 스트리밍과 병행)
  */
 void process_upload_request(void)
 {
+    static bool upload_running = false;
+    static uint32_t request_tick = 0;
+
+    // 진행 중인 업로드: 한 단계씩 처리 (메인 루프의 다른 태스크와 번갈아 실행)
+    if (upload_running) {
+        YmodemResult_t result = ymodem_poll();
+        if (result == YMODEM_BUSY) {
+            return;
+        }
+        upload_running = false;
+
+        if (upload_request.simulate) {
+            char report[512];
+            if (ymodem_sim_finish(result, report, sizeof(report)) == 0) {
+                uart_send_response(ANSI_OK " YSIM\r\n%sEND\r\n", report);
+            } else {
+                uart_send_response("%sEND\r\n", report);
+                uart_send_error(501, "YSIM failed");
+            }
+        } else if (result == YMODEM_OK && upload_request.download) {
+            printf("[DEBUG] Y-MODEM download complete\r\n");
+            uart_send_response(ANSI_OK " Download complete %s\r\n", upload_request.file_path);
+        } else if (result == YMODEM_OK && upload_request.batch) {
+            printf("[DEBUG] Y-MODEM batch upload complete\r\n");
+            uart_send_response(ANSI_OK " Batch complete %lu files\r\n", ymodem_files_received());
+        } else if (result == YMODEM_OK && (upload_request.options & YMODEM_OPT_DELTA)) {
+            uint32_t literal_bytes;
+            uint32_t copied_bytes;
+            uint32_t wire_bytes;
+            ymodem_delta_result(&literal_bytes, &copied_bytes, &wire_bytes);
+            printf("[DEBUG] Y-MODEM delta sync complete\r\n");
+            uart_send_response(ANSI_OK " Sync complete %s %lu %lu %lu\r\n", upload_request.file_path,
+                               literal_bytes, copied_bytes, wire_bytes);
+        } else if (result == YMODEM_OK) {
+            printf("[DEBUG] Y-MODEM upload complete\r\n");
+            uart_send_response(ANSI_OK " Upload complete %s\r\n", upload_request.file_path);
+        } else {
+            printf("[DEBUG] Y-MODEM upload failed, result=%d\r\n", result);
+            uart_send_error(501, "Y-MODEM transfer failed");
+        }
+        printf("[DEBUG] Main loop worst iteration during upload: %lu us\r\n", main_loop_max_us());
+        return;
+    }
+
     if (!upload_request.requested) {
+        request_tick = 0;
         return;  // 요청 없음
     }
 
+    // USB CDC 전송 완료 대기 (Ready 응답 후 200ms, 메인 루프는 계속 실행)
+    if (request_tick == 0) {
+        request_tick = HAL_GetTick() | 1;
+        printf("[DEBUG] Processing upload request in main loop\r\n");
+        return;
+    }
+    if (HAL_GetTick() - request_tick < 200) {
+        return;
+    }
+
     // 플래그 클리어 (재진입 방지)
     upload_request.requested = false;
+    request_tick = 0;
+
+    // Y-MODEM 모드 활성화 (CDC 또는 UART)
+    UART_HandleTypeDef *huart = (get_command_transport() == CMD_TRANSPORT_USB_CDC) ? NULL : &huart2;
+    YmodemResult_t result;
+
+    if (upload_request.simulate) {
+        printf("[DEBUG] Starting Y-MODEM simulation (%lu bytes)\r\n", upload_request.sim_config.size);
+        result = ymodem_sim_start((const YmodemSimConfig_t*)&upload_request.sim_config);
+    } else if (upload_request.download) {
+        printf("[DEBUG] Starting Y-MODEM send of %s\r\n", upload_request.file_path);
+        result = ymodem_send_start(huart, (const char*)upload_request.file_path);
+    } else {
+        printf("[DEBUG] Starting Y-MODEM receive to %s\r\n",
+               upload_request.batch ? YMODEM_BATCH_ROOT " (batch)" : (const char*)upload_request.file_path);
+
+        // 배치 전송은 파일 경로 없이 시작 (블록 0마다 경로 결정)
+        // 재개 전송은 확정된 위치부터 이어서 기록, 압축 업로드는 LZ4 해제 후 기록
+        result = ymodem_start_ex(huart,
+                                 upload_request.batch ? NULL : (const char*)upload_request.file_path,
+                                 upload_request.mode, upload_request.resume_offset,
+                                 upload_request.options);
+    }
 
-    printf("[DEBUG] Processing upload request in main loop\r\n");
+    if (result != YMODEM_BUSY) {
+        printf("[DEBUG] Y-MODEM start failed, result=%d\r\n", result);
+        uart_send_error(501, "Y-MODEM transfer failed");
+        return;
+    }
 
-    // USB CDC 전송 완료 대기 (메인 컨텍스트이므로 HAL_Delay 안전)
-    HAL_Delay(200);
+    main_loop_stats_reset();
+    upload_running = true;
+}
 
-    printf("[DEBUG] Starting Y-MODEM receive to %s\r\n", upload_request.file_path);
+/**
+ * @brief USB MSC 전환 처리 (메인 루프에서 호출)
+ *
+ * MSC ON은 여기서 FatFs 마운트를 해제하고 응답합니다 (오디오 스트리밍의 f_read와 같은 컨텍스트).
+ * MSC ON/OFF 응답이 전송될 시간(200ms)을 둔 뒤 USB를 재열거합니다.
+ * MSCBENCH 측정도 수신 인터럽트 대신 여기서 실행하고 결과를 응답합니다.
+ * 호스트가 매체를 꺼내면(eject) 명령 없이 CDC로 돌아와 FatFs를 다시 마운트합니다.
+ */
+void process_msc_request(void)
+{
+    static uint32_t request_tick = 0;
 
-    // Y-MODEM 모드 활성화 (CDC 또는 UART)
-    UART_HandleTypeDef *huart = (get_command_transport() == CMD_TRANSPORT_USB_CDC) ? NULL : &huart2;
-    YmodemResult_t result = ymodem_receive(huart, (const char*)upload_request.file_path);
+    if (msc_request == MSC_REQUEST_NONE && msc_storage_host_owned() &&
+        USB_Device_Get_Mode() == USB_DEVICE_MODE_MSC && STORAGE_Ejected_HS()) {
+        printf("[DEBUG] MSC: medium ejected by host\r\n");
+        msc_request = MSC_REQUEST_DETACH;
+    }
 
-    if (result == YMODEM_OK) {
-        printf("[DEBUG] Y-MODEM upload complete\r\n");
-        uart_send_response(ANSI_OK " Upload complete %s\r\n", upload_request.file_path);
+    if (msc_request == MSC_REQUEST_NONE) {
+        request_tick = 0;
+        return;
+    }
+
+    // MSCBENCH: 재열거가 없으므로 대기 없이 바로 측정
+    if (msc_request == MSC_REQUEST_BENCH) {
+        uint32_t size_kb = msc_bench_kb;
+        char report[256];
+
+        if (ymodem_is_active() || msc_storage_host_owned()) {
+            uart_send_error(403, "Upload in progress");
+        } else if (msc_storage_benchmark(size_kb, report, sizeof(report)) == 0) {
+            uart_send_response(ANSI_OK " MSCBENCH %lu KB\r\n%sEND\r\n", size_kb, report);
+        } else {
+            uart_send_response("%sEND\r\n", report);
+            uart_send_error(405, "MSC benchmark failed");
+        }
+        msc_request = MSC_REQUEST_NONE;
+        return;
+    }
+
+    // MSC ON: 메인 루프 컨텍스트에서 재생 정지 후 마운트 해제, 성공해야 OK 응답 (재열거는 응답 전송 후)
+    if (msc_request == MSC_REQUEST_ATTACH && !msc_storage_host_owned()) {
+        FRESULT res = msc_storage_attach();
+        if (res != FR_OK) {
+            msc_request = MSC_REQUEST_NONE;
+            if (res == FR_LOCKED) {
+                uart_send_error(403, "Upload in progress");
+            } else {
+                uart_send_error(405, "SD volume not available");
+            }
+            return;
+        }
+        uart_send_response(ANSI_OK " MSC HOST\r\n");
+    }
+
+    if (request_tick == 0) {
+        request_tick = HAL_GetTick() | 1;
+        return;
+    }
+    if (HAL_GetTick() - request_tick < 200) {
+        return;
+    }
+
+    MscRequest_t request = msc_request;
+    msc_request = MSC_REQUEST_NONE;
+    request_tick = 0;
+
+    if (request == MSC_REQUEST_ATTACH) {
+        if (USB_Device_Set_Mode(USB_DEVICE_MODE_MSC) != 0) {
+            // 재열거 실패: 볼륨을 펌웨어로 되돌림
+            USB_Device_Set_Mode(USB_DEVICE_MODE_CDC);
+            msc_storage_detach();
+            uart_send_error(501, "USB class switch failed");
+        }
     } else {
-        printf("[DEBUG] Y-MODEM upload failed, result=%d\r\n", result);
-        uart_send_error(501, "Y-MODEM transfer failed");
+        USB_Device_Set_Mode(USB_DEVICE_MODE_CDC);
+        if (msc_storage_detach() != FR_OK) {
+            uart_send_error(405, "SD remount failed");
+        }
+    }
+}
+
+// VERIFY: 파일 CRC-32 재계산 후 수신 시 기록한 다이제스트와 비교
+static void run_verify(const char *file_path)
+{
+    uint32_t size;
+    uint32_t crc;
+    FRESULT fres = ymodem_file_crc32(file_path, &size, &crc);
+    if (fres == FR_NO_FILE || fres == FR_NO_PATH) {
+        uart_send_error(404, "File not found");
+        return;
     }
+    if (fres != FR_OK) {
+        printf("[ERROR] VERIFY %s: fres=%d\r\n", file_path, fres);
+        uart_send_error(405, "File read error");
+        return;
+    }
+
+    uint32_t stored_size;
+    uint32_t stored_crc;
+    const char *status = "NODIGEST";
+    if (ymodem_read_digest(file_path, &stored_size, &stored_crc)) {
+        if (stored_size == size && stored_crc == crc) {
+            status = "MATCH";
+        } else {
+            status = "MISMATCH";
+            printf("[WARN] VERIFY %s: stored %lu bytes %08lX, read %lu bytes %08lX\r\n",
+                   file_path, stored_size, stored_crc, size, crc);
+        }
+    }
+
+    uart_send_response(ANSI_OK " VERIFY %lu %08lX %s\r\n", size, crc, status);
+}
+
+// SIGS: 차등 업로드용 블록 서명 생성, 응답은 "/audio/chN/" 아래 파일명 기준
+static void run_signatures(const char *file_path, uint32_t block_size)
+{
+    uint32_t block_count;
+    FRESULT fres = ymodem_delta_signatures(file_path, block_size, &block_count);
+    if (fres == FR_NO_FILE || fres == FR_NO_PATH) {
+        uart_send_error(404, "File not found");
+        return;
+    }
+    if (fres != FR_OK) {
+        printf("[ERROR] SIGS %s: fres=%d\r\n", file_path, fres);
+        uart_send_error(405, "Signature write error");
+        return;
+    }
+
+    const char *name = &file_path[sizeof("/audio/ch0/") - 1];   // 채널 0~5 → 접두사 길이 고정
+    uart_send_response(ANSI_OK " SIGS %s" DELTA_SIG_SUFFIX " %lu %lu\r\n", name, block_size, block_count);
+}
+
+/**
+ * @brief 긴 SD 작업 처리 (메인 루프에서 호출)
+ *
+ * 벤치마크처럼 수 초 걸리는 SD 작업을 수신 인터럽트 대신 여기서 실행하고 결과를 응답합니다.
+ * 실행 중에는 오디오 스트리밍도 멈추지만, USB 수신과 FatFs 접근이 겹치지 않습니다.
+ */
+void process_sd_job_request(void)
+{
+    SdJob_t job = sd_job;
+
+    if (job == SD_JOB_NONE) {
+        return;
+    }
+    if (ymodem_is_active()) {
+        uart_send_error(403, "Upload in progress");
+        sd_job = SD_JOB_NONE;
+        return;
+    }
+
+    if (job == SD_JOB_SDBENCH) {
+        uint32_t size_kb = sd_job_arg;
+        uint32_t grow_ms = ymodem_sd_benchmark("/sdbench.tmp", size_kb * 1024, false);
+        uint32_t prealloc_ms = ymodem_sd_benchmark("/sdbench.tmp", size_kb * 1024, true);
+
+        if (grow_ms == 0 || prealloc_ms == 0) {
+            uart_send_error(405, "SD benchmark failed");
+        } else {
+            uart_send_response(ANSI_OK " SDBENCH %lu KB\r\n"
+                               "grow:     %lu ms, %lu KB/s\r\n"
+                               "prealloc: %lu ms, %lu KB/s\r\n"
+                               "END\r\n",
+                               size_kb,
+                               grow_ms, size_kb * 1000 / grow_ms,
+                               prealloc_ms, size_kb * 1000 / prealloc_ms);
+        }
+    } else if (job == SD_JOB_VERIFY) {
+        run_verify(sd_job_path);
+    } else if (job == SD_JOB_WAVBENCH) {
+        uint32_t seconds = sd_job_arg;
+        char report[384];
+
+        if (wav_benchmark("/wavbench.tmp", seconds, report, sizeof(report)) == 0) {
+            uart_send_response(ANSI_OK " WAVBENCH %lu s\r\n%sEND\r\n", seconds, report);
+        } else {
+            uart_send_response("%sEND\r\n", report);
+            uart_send_error(405, "WAV benchmark failed");
+        }
+    } else if (job == SD_JOB_SIGS) {
+        run_signatures(sd_job_path, sd_job_arg);
+    }
+
+    sd_job = SD_JOB_NONE;
 }
 
 /**
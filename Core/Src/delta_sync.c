@@ -0,0 +1,279 @@
+/*
+ * delta_sync.c
+ *
+ *  차등 업로드 스트림 해석 구현
+ *  - Y-MODEM 패킷(1KB) 단위로 들어오는 입력을 필드 중간에서 끊겨도 이어서 해석
+ *  - 리터럴은 받은 그대로 출력 콜백으로, 블록 참조는 (파일 위치, 길이)로 복사 콜백에 넘김
+ *    (Y-MODEM은 리터럴을 SD 스테이징 버퍼에 적재, 복사는 기존 파일에서 8KB 단위 순차 읽기)
+ *  - 블록 참조 하나가 수십 MB일 수 있으므로 해석은 참조에서 멈추고, 복사는 호출측이
+ *    delta_stream_resume()으로 나눠서 진행 (메인 루프/오디오 태스크를 막지 않음)
+ *  - 재구성 결과 검증은 수신측 다이제스트(CRC-32)와 DELTA_OP_END의 CRC-32 비교
+ */
+
+#include "delta_sync.h"
+#include <string.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+// 해석 상태
+typedef enum {
+    DELTA_ST_HEADER = 0,        // 매직 + 블록 크기 + 기존 파일 크기 (12)
+    DELTA_ST_OP,                // 명령 (1)
+    DELTA_ST_LITERAL_LENGTH,    // 리터럴 길이 (4)
+    DELTA_ST_LITERAL,           // 리터럴 데이터
+    DELTA_ST_COPY,              // 첫 블록 + 블록 수 (8)
+    DELTA_ST_COPY_DATA,         // 블록 참조 복사 대기/진행 중 (delta_stream_resume())
+    DELTA_ST_END,               // 새 파일 CRC-32 (4)
+    DELTA_ST_DONE,
+    DELTA_ST_ERROR
+} DeltaState_t;
+
+// 해석 상태 (입력 조각 사이에 유지)
+typedef struct {
+    DeltaState_t state;
+    DeltaStreamOutput_t literal;
+    DeltaStreamCopy_t copy;
+    uint8_t field[12];              // 여러 바이트 필드 수집 (조각 경계에서 끊긴 경우)
+    uint8_t field_len;
+    uint32_t basis_size;            // 기존 파일 크기
+    uint32_t block_size;            // 스트림 헤더의 블록 크기
+    uint32_t literal_remaining;     // 현재 리터럴의 남은 바이트
+    uint32_t copy_offset;           // 복사 중인 블록 참조의 다음 위치
+    uint32_t copy_remaining;        // 복사 중인 블록 참조의 남은 바이트
+    const uint8_t *rest_data;       // 블록 참조에서 멈췄을 때 남은 입력 (호출측 버퍼)
+    uint32_t rest_size;
+    uint32_t expected_crc;          // DELTA_OP_END의 CRC-32
+    uint32_t literal_bytes;         // 받은 리터럴 총 바이트
+    uint32_t copied_bytes;          // 기존 파일에서 복사한 총 바이트
+} DeltaStream_t;
+
+static DeltaStream_t delta;
+
+// 내부 함수
+static bool collect_field(const uint8_t **data, uint32_t *size, uint32_t need);
+static uint32_t field_u32(uint32_t index);
+static DeltaStreamStatus_t fail(const char *reason);
+
+// 약한 체크섬 (rsync 롤링 체크섬)
+// b는 a의 누적 합으로 계산 (sum((n - i) * x[i])와 같음), mod 65536은 마지막에 한 번
+uint32_t delta_weak_checksum(const uint8_t *data, uint32_t size)
+{
+    uint32_t a = 0;
+    uint32_t b = 0;
+
+    while (size >= 4) {
+        a += data[0]; b += a;
+        a += data[1]; b += a;
+        a += data[2]; b += a;
+        a += data[3]; b += a;
+        data += 4;
+        size -= 4;
+    }
+    while (size-- > 0) {
+        a += *data++;
+        b += a;
+    }
+    return (a & 0xFFFF) | (b << 16);
+}
+
+// 새 스트림 해석 시작
+void delta_stream_init(uint32_t basis_size, DeltaStreamOutput_t literal, DeltaStreamCopy_t copy)
+{
+    memset(&delta, 0, sizeof(delta));
+    delta.literal = literal;
+    delta.copy = copy;
+    delta.basis_size = basis_size;
+    delta.state = DELTA_ST_HEADER;
+}
+
+// 현재 상태
+DeltaStreamStatus_t delta_stream_status(void)
+{
+    if (delta.state == DELTA_ST_DONE) {
+        return DELTA_STREAM_DONE;
+    }
+    if (delta.state == DELTA_ST_COPY_DATA) {
+        return DELTA_STREAM_COPY;
+    }
+    return (delta.state == DELTA_ST_ERROR) ? DELTA_STREAM_ERROR : DELTA_STREAM_OK;
+}
+
+uint32_t delta_stream_expected_crc(void)
+{
+    return delta.expected_crc;
+}
+
+uint32_t delta_stream_literal_bytes(void)
+{
+    return delta.literal_bytes;
+}
+
+uint32_t delta_stream_copied_bytes(void)
+{
+    return delta.copied_bytes;
+}
+
+// 입력 조각 해석
+DeltaStreamStatus_t delta_stream_decode(const uint8_t *data, uint32_t size)
+{
+    while (size > 0) {
+        switch (delta.state) {
+        case DELTA_ST_HEADER: {
+            if (!collect_field(&data, &size, 12)) {
+                return DELTA_STREAM_OK;
+            }
+            uint32_t block_size = field_u32(4);
+            if (field_u32(0) != DELTA_STREAM_MAGIC) {
+                return fail("bad stream magic");
+            }
+            if (block_size < DELTA_BLOCK_MIN || block_size > DELTA_BLOCK_MAX ||
+                (block_size & (block_size - 1)) != 0) {
+                return fail("bad block size");
+            }
+            // 서명 이후 기존 파일이 바뀌었으면 블록 참조가 맞지 않음
+            if (field_u32(8) != delta.basis_size) {
+                printf("[ERROR] DELTA: basis size %lu, stream expects %lu\r\n", delta.basis_size, field_u32(8));
+                delta.state = DELTA_ST_ERROR;
+                return DELTA_STREAM_ERROR;
+            }
+            delta.block_size = block_size;
+            delta.state = DELTA_ST_OP;
+            break;
+        }
+
+        case DELTA_ST_OP: {
+            uint8_t op = *data++;
+            size--;
+            if (op == DELTA_OP_LITERAL) {
+                delta.state = DELTA_ST_LITERAL_LENGTH;
+            } else if (op == DELTA_OP_COPY) {
+                delta.state = DELTA_ST_COPY;
+            } else if (op == DELTA_OP_END) {
+                delta.state = DELTA_ST_END;
+            } else {
+                return fail("unknown op");
+            }
+            break;
+        }
+
+        case DELTA_ST_LITERAL_LENGTH:
+            if (!collect_field(&data, &size, 4)) {
+                return DELTA_STREAM_OK;
+            }
+            delta.literal_remaining = field_u32(0);
+            delta.state = (delta.literal_remaining > 0) ? DELTA_ST_LITERAL : DELTA_ST_OP;
+            break;
+
+        case DELTA_ST_LITERAL: {
+            uint32_t n = (size < delta.literal_remaining) ? size : delta.literal_remaining;
+            if (delta.literal(data, n) != 0) {
+                return fail("literal output failed");
+            }
+            data += n;
+            size -= n;
+            delta.literal_remaining -= n;
+            delta.literal_bytes += n;
+            if (delta.literal_remaining == 0) {
+                delta.state = DELTA_ST_OP;
+            }
+            break;
+        }
+
+        case DELTA_ST_COPY: {
+            if (!collect_field(&data, &size, 8)) {
+                return DELTA_STREAM_OK;
+            }
+            uint32_t first = field_u32(0);
+            uint32_t count = field_u32(4);
+            uint32_t blocks = (delta.basis_size + delta.block_size - 1) / delta.block_size;
+            if (count == 0 || first >= blocks || count > blocks - first) {
+                return fail("block reference out of range");
+            }
+            // 연속 블록은 한 구간으로 복사 (마지막 블록은 파일 끝에서 잘림)
+            // 복사는 delta_stream_resume()에서, 남은 입력은 그 뒤에 이어서 해석
+            uint32_t offset = first * delta.block_size;
+            uint32_t end = (first + count == blocks) ? delta.basis_size : (first + count) * delta.block_size;
+            delta.copy_offset = offset;
+            delta.copy_remaining = end - offset;
+            delta.rest_data = data;
+            delta.rest_size = size;
+            delta.state = DELTA_ST_COPY_DATA;
+            return DELTA_STREAM_COPY;
+        }
+
+        case DELTA_ST_COPY_DATA:
+            return fail("input during basis copy");
+
+        case DELTA_ST_END:
+            if (!collect_field(&data, &size, 4)) {
+                return DELTA_STREAM_OK;
+            }
+            delta.expected_crc = field_u32(0);
+            delta.state = DELTA_ST_DONE;
+            return DELTA_STREAM_DONE;
+
+        case DELTA_ST_DONE:
+            return DELTA_STREAM_DONE;   // 종료 이후 (Y-MODEM 패딩) 무시
+
+        default:
+            return DELTA_STREAM_ERROR;
+        }
+    }
+
+    return delta_stream_status();
+}
+
+// 멈춘 블록 참조 복사 (budget 바이트까지) 후 남은 입력 해석
+DeltaStreamStatus_t delta_stream_resume(uint32_t budget)
+{
+    while (delta.state == DELTA_ST_COPY_DATA && budget > 0) {
+        uint32_t n = (delta.copy_remaining < budget) ? delta.copy_remaining : budget;
+        if (delta.copy(delta.copy_offset, n) != 0) {
+            return fail("basis copy failed");
+        }
+        delta.copy_offset += n;
+        delta.copy_remaining -= n;
+        delta.copied_bytes += n;
+        budget -= n;
+
+        if (delta.copy_remaining == 0) {
+            const uint8_t *rest = delta.rest_data;
+            uint32_t rest_size = delta.rest_size;
+            delta.rest_size = 0;
+            delta.state = DELTA_ST_OP;
+            if (delta_stream_decode(rest, rest_size) == DELTA_STREAM_ERROR) {
+                return DELTA_STREAM_ERROR;
+            }
+        }
+    }
+
+    return delta_stream_status();
+}
+
+// 여러 바이트 필드 수집 (다 모이면 true, field에 저장)
+static bool collect_field(const uint8_t **data, uint32_t *size, uint32_t need)
+{
+    while (delta.field_len < need && *size > 0) {
+        delta.field[delta.field_len++] = *(*data)++;
+        (*size)--;
+    }
+
+    if (delta.field_len < need) {
+        return false;
+    }
+    delta.field_len = 0;
+    return true;
+}
+
+static uint32_t field_u32(uint32_t index)
+{
+    return (uint32_t)delta.field[index] | ((uint32_t)delta.field[index + 1] << 8) |
+           ((uint32_t)delta.field[index + 2] << 16) | ((uint32_t)delta.field[index + 3] << 24);
+}
+
+static DeltaStreamStatus_t fail(const char *reason)
+{
+    printf("[ERROR] DELTA: %s (at literal %lu, copied %lu)\r\n", reason, delta.literal_bytes, delta.copied_bytes);
+    delta.state = DELTA_ST_ERROR;
+    return DELTA_STREAM_ERROR;
+}
@@ -0,0 +1,631 @@
+/*
+ * lz4_stream.c
+ *
+ *  LZ4 프레임 스트리밍 해제 구현
+ *  - Y-MODEM 패킷(1KB) 단위로 들어오는 입력을 필드 중간에서 끊겨도 이어서 해제
+ *  - 매치 참조용 히스토리는 64KB 링 하나 (블록 최대 크기 4MB 프레임도 동일한 메모리로 해제)
+ *  - 해제 결과는 콜백으로 바로 넘김 (Y-MODEM은 SD 스테이징 버퍼에 적재)
+ *  - 헤더/블록/콘텐츠 체크섬(xxHash32)은 건너뜀 (링크 오류는 패킷 CRC-16으로 검출)
+ */
+
+#include "lz4_stream.h"
+#include <string.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+#define LZ4_FRAME_MAGIC         0x184D2204
+#define LZ4_HISTORY_MASK        (LZ4_HISTORY_SIZE - 1)
+#define LZ4_MIN_MATCH           4
+
+// FLG 바이트
+#define LZ4_FLG_VERSION_MASK    0xC0
+#define LZ4_FLG_VERSION_01      0x40
+#define LZ4_FLG_BLOCK_CHECKSUM  0x10
+#define LZ4_FLG_CONTENT_SIZE    0x08
+#define LZ4_FLG_CONTENT_CHECKSUM 0x04
+#define LZ4_FLG_DICT_ID         0x01
+
+// 블록 크기 필드 최상위 비트: 압축되지 않은 블록
+#define LZ4_BLOCK_UNCOMPRESSED  0x80000000
+
+// 해제 상태
+typedef enum {
+    LZ4_ST_MAGIC = 0,           // 매직 넘버 (4)
+    LZ4_ST_FLG_BD,              // FLG + BD (2)
+    LZ4_ST_DESCRIPTOR,          // [콘텐츠 크기 8] [사전 ID 4] + HC (1)
+    LZ4_ST_BLOCK_SIZE,          // 블록 크기 (4), 0이면 종료 마크
+    LZ4_ST_BLOCK_RAW,           // 압축되지 않은 블록 데이터
+    LZ4_ST_TOKEN,               // 시퀀스 토큰 (리터럴 길이 4비트 | 매치 길이 4비트)
+    LZ4_ST_LITERAL_LENGTH,      // 리터럴 길이 추가 바이트 (255면 계속)
+    LZ4_ST_LITERALS,            // 리터럴 데이터
+    LZ4_ST_OFFSET,              // 매치 거리 (2, little-endian)
+    LZ4_ST_MATCH_LENGTH,        // 매치 길이 추가 바이트 (255면 계속)
+    LZ4_ST_MATCH,               // 매치 복사/출력 (링 끝에서 나눈 조각 단위, 입력 없이 진행)
+    LZ4_ST_BLOCK_CHECKSUM,      // 블록 체크섬 (4, 검증 안 함)
+    LZ4_ST_CONTENT_CHECKSUM,    // 콘텐츠 체크섬 (4, 검증 안 함)
+    LZ4_ST_DONE,
+    LZ4_ST_ERROR
+} Lz4State_t;
+
+// 해제 상태 (입력 조각 사이에 유지)
+typedef struct {
+    Lz4State_t state;
+    Lz4StreamOutput_t output;
+    uint8_t field[16];              // 여러 바이트 필드 수집 (조각 경계에서 끊긴 경우)
+    uint8_t field_len;
+    uint8_t flg;
+    uint32_t block_max;             // BD의 블록 최대 크기
+    uint32_t block_remaining;       // 현재 블록의 남은 입력 바이트
+    uint32_t literal_length;
+    uint32_t match_length;          // 매치의 남은 길이
+    uint32_t match_offset;
+    uint32_t history_pos;           // 다음 출력 바이트의 히스토리 위치
+    uint32_t output_bytes;          // 해제된 총 바이트 (매치 거리 검증에도 사용)
+    bool pause_requested;           // 출력 콜백의 일시 정지 요청
+    bool paused;
+    const uint8_t *rest_data;       // 멈춘 자리의 남은 입력 (호출측 버퍼)
+    uint32_t rest_size;
+} Lz4Stream_t;
+
+static Lz4Stream_t lz4;
+
+// 히스토리 링 (64KB)
+// .bss(RAM_D1_CACHE2 128KB)에 여유가 없어 RAM_D1_DMA에 배치 (캐시 OFF, SD 버퍼와 같은 영역)
+__attribute__((section(".ram_d1_dma")))
+__attribute__((aligned(32)))
+static uint8_t lz4_history[LZ4_HISTORY_SIZE];
+
+// 내부 함수
+static bool collect_field(const uint8_t **data, uint32_t *size, uint32_t need);
+static bool take_block_byte(const uint8_t **data, uint32_t *size, uint8_t *value);
+static bool emit_literals(const uint8_t *data, uint32_t size);
+static bool start_match(uint32_t offset);
+static bool emit_match_chunk(void);
+static Lz4StreamStatus_t fail(const char *reason);
+
+// 새 프레임 해제 시작
+void lz4_stream_init(Lz4StreamOutput_t output)
+{
+    memset(&lz4, 0, sizeof(lz4));
+    lz4.output = output;
+    lz4.state = LZ4_ST_MAGIC;
+}
+
+// 현재 상태
+Lz4StreamStatus_t lz4_stream_status(void)
+{
+    if (lz4.state == LZ4_ST_DONE) {
+        return LZ4_STREAM_DONE;
+    }
+    if (lz4.paused) {
+        return LZ4_STREAM_PAUSED;
+    }
+    return (lz4.state == LZ4_ST_ERROR) ? LZ4_STREAM_ERROR : LZ4_STREAM_OK;
+}
+
+// 해제된 총 바이트 수
+uint32_t lz4_stream_output_bytes(void)
+{
+    return lz4.output_bytes;
+}
+
+// 출력 콜백에서 호출: 현재 출력까지만 처리하고 멈춤
+void lz4_stream_pause(void)
+{
+    lz4.pause_requested = true;
+}
+
+// 멈춘 자리부터 남은 입력 해제
+Lz4StreamStatus_t lz4_stream_resume(void)
+{
+    if (!lz4.paused) {
+        return lz4_stream_status();
+    }
+    lz4.paused = false;
+    return lz4_stream_decode(lz4.rest_data, lz4.rest_size);
+}
+
+// 입력 조각 해제
+// 매치 출력은 입력을 쓰지 않으므로 입력이 끝나도 계속 진행
+Lz4StreamStatus_t lz4_stream_decode(const uint8_t *data, uint32_t size)
+{
+    if (lz4.paused) {
+        return fail("input while paused");
+    }
+
+    while ((size > 0 || lz4.state == LZ4_ST_MATCH) && lz4.state != LZ4_ST_DONE && lz4.state != LZ4_ST_ERROR) {
+        uint8_t value;
+
+        switch (lz4.state) {
+        case LZ4_ST_MAGIC:
+            if (!collect_field(&data, &size, 4)) {
+                break;
+            }
+            if ((lz4.field[0] | (lz4.field[1] << 8) | (lz4.field[2] << 16) |
+                 ((uint32_t)lz4.field[3] << 24)) != LZ4_FRAME_MAGIC) {
+                return fail("bad frame magic");
+            }
+            lz4.state = LZ4_ST_FLG_BD;
+            break;
+
+        case LZ4_ST_FLG_BD: {
+            if (!collect_field(&data, &size, 2)) {
+                break;
+            }
+            lz4.flg = lz4.field[0];
+            uint8_t bd = (lz4.field[1] >> 4) & 0x07;
+            if ((lz4.flg & LZ4_FLG_VERSION_MASK) != LZ4_FLG_VERSION_01) {
+                return fail("unsupported frame version");
+            }
+            if (lz4.flg & LZ4_FLG_DICT_ID) {
+                return fail("dictionary not supported");
+            }
+            if (bd < 4) {
+                return fail("invalid block max size");
+            }
+            lz4.block_max = 1UL << (8 + 2 * bd);  // 4: 64KB, 5: 256KB, 6: 1MB, 7: 4MB
+            lz4.state = LZ4_ST_DESCRIPTOR;
+            break;
+        }
+
+        case LZ4_ST_DESCRIPTOR:
+            // 콘텐츠 크기는 블록 0의 파일 크기와 같으므로 사용하지 않음, HC도 검증 안 함
+            if (collect_field(&data, &size, ((lz4.flg & LZ4_FLG_CONTENT_SIZE) ? 8 : 0) + 1)) {
+                lz4.state = LZ4_ST_BLOCK_SIZE;
+            }
+            break;
+
+        case LZ4_ST_BLOCK_SIZE: {
+            if (!collect_field(&data, &size, 4)) {
+                break;
+            }
+            uint32_t block_size = lz4.field[0] | (lz4.field[1] << 8) | (lz4.field[2] << 16) |
+                                  ((uint32_t)lz4.field[3] << 24);
+            if (block_size == 0) {
+                // 종료 마크
+                lz4.state = (lz4.flg & LZ4_FLG_CONTENT_CHECKSUM) ? LZ4_ST_CONTENT_CHECKSUM : LZ4_ST_DONE;
+                break;
+            }
+            lz4.block_remaining = block_size & ~LZ4_BLOCK_UNCOMPRESSED;
+            if (lz4.block_remaining > lz4.block_max) {
+                return fail("block larger than block max size");
+            }
+            lz4.state = (block_size & LZ4_BLOCK_UNCOMPRESSED) ? LZ4_ST_BLOCK_RAW : LZ4_ST_TOKEN;
+            break;
+        }
+
+        case LZ4_ST_BLOCK_RAW: {
+            uint32_t chunk = (size < lz4.block_remaining) ? size : lz4.block_remaining;
+            if (!emit_literals(data, chunk)) {
+                return fail("output failed");
+            }
+            data += chunk;
+            size -= chunk;
+            lz4.block_remaining -= chunk;
+            if (lz4.block_remaining == 0) {
+                lz4.state = (lz4.flg & LZ4_FLG_BLOCK_CHECKSUM) ? LZ4_ST_BLOCK_CHECKSUM : LZ4_ST_BLOCK_SIZE;
+            }
+            break;
+        }
+
+        case LZ4_ST_TOKEN:
+            if (!take_block_byte(&data, &size, &value)) {
+                return fail("sequence past block end");
+            }
+            lz4.literal_length = value >> 4;
+            lz4.match_length = (value & 0x0F) + LZ4_MIN_MATCH;
+            lz4.state = (lz4.literal_length == 15) ? LZ4_ST_LITERAL_LENGTH : LZ4_ST_LITERALS;
+            break;
+
+        case LZ4_ST_LITERAL_LENGTH:
+            if (!take_block_byte(&data, &size, &value)) {
+                return fail("literal length past block end");
+            }
+            lz4.literal_length += value;
+            if (value != 255) {
+                lz4.state = LZ4_ST_LITERALS;
+            }
+            break;
+
+        case LZ4_ST_LITERALS: {
+            uint32_t chunk = lz4.literal_length;
+            if (chunk > size) {
+                chunk = size;
+            }
+            if (chunk > lz4.block_remaining) {
+                return fail("literals past block end");
+            }
+            if (chunk > 0 && !emit_literals(data, chunk)) {
+                return fail("output failed");
+            }
+            data += chunk;
+            size -= chunk;
+            lz4.block_remaining -= chunk;
+            lz4.literal_length -= chunk;
+
+            if (lz4.literal_length == 0) {
+                // 블록의 마지막 시퀀스는 리터럴만 있음
+                if (lz4.block_remaining == 0) {
+                    lz4.state = (lz4.flg & LZ4_FLG_BLOCK_CHECKSUM) ? LZ4_ST_BLOCK_CHECKSUM : LZ4_ST_BLOCK_SIZE;
+                } else {
+                    lz4.state = LZ4_ST_OFFSET;
+                }
+            }
+            break;
+        }
+
+        case LZ4_ST_OFFSET:
+            if (lz4.field_len == 0 && lz4.block_remaining < 2) {
+                return fail("offset past block end");
+            }
+            if (!collect_field(&data, &size, 2)) {
+                break;
+            }
+            lz4.block_remaining -= 2;
+            if ((lz4.match_length - LZ4_MIN_MATCH) == 15) {
+                lz4.state = LZ4_ST_MATCH_LENGTH;
+                break;
+            }
+            if (!start_match(lz4.field[0] | (lz4.field[1] << 8))) {
+                return fail("invalid match offset");
+            }
+            break;
+
+        case LZ4_ST_MATCH_LENGTH:
+            if (!take_block_byte(&data, &size, &value)) {
+                return fail("match length past block end");
+            }
+            lz4.match_length += value;
+            if (value == 255) {
+                break;
+            }
+            // 매치 거리는 field에 보존되어 있음 (OFFSET 이후 다른 필드를 수집하지 않음)
+            if (!start_match(lz4.field[0] | (lz4.field[1] << 8))) {
+                return fail("invalid match offset");
+            }
+            break;
+
+        case LZ4_ST_MATCH:
+            if (!emit_match_chunk()) {
+                return fail("output failed");
+            }
+            if (lz4.match_length == 0) {
+                lz4.state = LZ4_ST_TOKEN;
+            }
+            break;
+
+        case LZ4_ST_BLOCK_CHECKSUM:
+            if (collect_field(&data, &size, 4)) {
+                lz4.state = LZ4_ST_BLOCK_SIZE;
+            }
+            break;
+
+        case LZ4_ST_CONTENT_CHECKSUM:
+            if (collect_field(&data, &size, 4)) {
+                lz4.state = LZ4_ST_DONE;
+            }
+            break;
+
+        default:
+            break;
+        }
+
+        // 출력 콜백이 멈춤 요청: 남은 입력을 보관하고 반환
+        if (lz4.pause_requested) {
+            lz4.pause_requested = false;
+            lz4.paused = true;
+            lz4.rest_data = data;
+            lz4.rest_size = size;
+            return LZ4_STREAM_PAUSED;
+        }
+    }
+
+    return lz4_stream_status();
+}
+
+// 여러 바이트 필드 수집 (조각 경계에서 끊기면 다음 호출에서 이어서)
+// 완성되면 true, field[0..need-1]에 값
+static bool collect_field(const uint8_t **data, uint32_t *size, uint32_t need)
+{
+    while (lz4.field_len < need && *size > 0) {
+        lz4.field[lz4.field_len++] = *(*data)++;
+        (*size)--;
+    }
+
+    if (lz4.field_len < need) {
+        return false;
+    }
+    lz4.field_len = 0;
+    return true;
+}
+
+// 블록 안의 1바이트 읽기 (블록 끝을 넘으면 false)
+static bool take_block_byte(const uint8_t **data, uint32_t *size, uint8_t *value)
+{
+    if (lz4.block_remaining == 0) {
+        return false;
+    }
+    *value = *(*data)++;
+    (*size)--;
+    lz4.block_remaining--;
+    return true;
+}
+
+// 리터럴 출력 + 히스토리 기록
+static bool emit_literals(const uint8_t *data, uint32_t size)
+{
+    if (lz4.output(data, size) != 0) {
+        return false;
+    }
+    lz4.output_bytes += size;
+
+    while (size > 0) {
+        uint32_t chunk = LZ4_HISTORY_SIZE - lz4.history_pos;
+        if (chunk > size) {
+            chunk = size;
+        }
+        memcpy(&lz4_history[lz4.history_pos], data, chunk);
+        lz4.history_pos = (lz4.history_pos + chunk) & LZ4_HISTORY_MASK;
+        data += chunk;
+        size -= chunk;
+    }
+    return true;
+}
+
+// 매치 시작: 거리 검증 후 LZ4_ST_MATCH에서 조각 단위로 출력
+static bool start_match(uint32_t offset)
+{
+    if (offset == 0 || offset > lz4.output_bytes) {
+        return false;
+    }
+    lz4.match_offset = offset;
+    lz4.state = LZ4_ST_MATCH;
+    return true;
+}
+
+// 매치 복사 한 조각: 히스토리에서 offset 앞의 데이터를 이어 붙이고 출력 (링 끝에서 나눔)
+// offset < length (자기 겹침, 예: 같은 샘플 반복)은 바이트 단위 순방향 복사
+static bool emit_match_chunk(void)
+{
+    uint32_t offset = lz4.match_offset;
+    uint32_t dst = lz4.history_pos;
+    uint32_t src = (dst - offset) & LZ4_HISTORY_MASK;
+    uint32_t chunk = lz4.match_length;
+
+    // 링 끝에서 분할
+    if (chunk > LZ4_HISTORY_SIZE - dst) {
+        chunk = LZ4_HISTORY_SIZE - dst;
+    }
+    if (chunk > LZ4_HISTORY_SIZE - src) {
+        chunk = LZ4_HISTORY_SIZE - src;
+    }
+
+    if (offset < chunk) {
+        for (uint32_t i = 0; i < chunk; i++) {
+            lz4_history[dst + i] = lz4_history[src + i];
+        }
+    } else {
+        memmove(&lz4_history[dst], &lz4_history[src], chunk);
+    }
+
+    if (lz4.output(&lz4_history[dst], chunk) != 0) {
+        return false;
+    }
+    lz4.output_bytes += chunk;
+    lz4.history_pos = (dst + chunk) & LZ4_HISTORY_MASK;
+    lz4.match_length -= chunk;
+    return true;
+}
+
+// 에러 상태로 전환
+static Lz4StreamStatus_t fail(const char *reason)
+{
+    printf("[ERROR] LZ4: %s (at output %lu)\r\n", reason, lz4.output_bytes);
+    lz4.state = LZ4_ST_ERROR;
+    return LZ4_STREAM_ERROR;
+}
+
+// ============================================================================
+// 자체 검증 (LZ4TEST 명령)
+// 주기 1000바이트 파형(f(n))을 리터럴/매치(거리 1000의 배수, 자기 겹침 포함)로 부호화한
+// 합성 프레임을 1KB가 아닌 조각 단위로 넣어 해제 결과와 속도 확인
+// 호스트 압축기 없이 펌웨어 안에서 프레임을 생성하므로 인코더는 단순 시퀀스 나열만 함
+// ============================================================================
+
+#define LZ4_TEST_PERIOD         1000    // 파형 주기 (매치 거리 단위)
+#define LZ4_TEST_BLOCKS         16      // 압축 블록 수
+#define LZ4_TEST_SEQUENCES      20      // 블록당 시퀀스 수 (블록당 해제 크기 < 64KB)
+#define LZ4_TEST_RAW_BLOCK      300     // 마지막 비압축 블록 크기
+#define LZ4_TEST_CHUNK          1021    // 해제기 입력 조각 크기 (필드가 조각 경계에 걸치도록)
+
+static struct {
+    uint8_t chunk[LZ4_TEST_CHUNK];
+    uint32_t chunk_len;
+    uint32_t input_bytes;
+    uint32_t decode_cycles;
+    uint32_t checked;               // 검증한 출력 바이트 수
+    bool verify;
+    bool mismatch;
+} lz4_test;
+
+// 기대 출력 파형
+static uint8_t test_wave(uint32_t n)
+{
+    uint32_t phase = n % LZ4_TEST_PERIOD;
+    return (uint8_t)((phase * 37) ^ (phase >> 2));
+}
+
+// 출력 콜백: 파형과 비교 (속도 측정 시에는 개수만)
+static int test_output(const uint8_t *data, uint32_t size)
+{
+    if (lz4_test.verify) {
+        for (uint32_t i = 0; i < size; i++) {
+            if (data[i] != test_wave(lz4_test.checked + i)) {
+                lz4_test.mismatch = true;
+                return -1;
+            }
+        }
+    }
+    lz4_test.checked += size;
+    return 0;
+}
+
+// 입력 조각이 차면 해제기에 전달 (해제 시간만 측정)
+static void test_flush(void)
+{
+    if (lz4_test.chunk_len == 0) {
+        return;
+    }
+    uint32_t start = DWT->CYCCNT;
+    lz4_stream_decode(lz4_test.chunk, lz4_test.chunk_len);
+    lz4_test.decode_cycles += DWT->CYCCNT - start;
+    lz4_test.chunk_len = 0;
+}
+
+static void test_put(bool emit, uint8_t value)
+{
+    if (!emit) {
+        return;
+    }
+    lz4_test.chunk[lz4_test.chunk_len++] = value;
+    lz4_test.input_bytes++;
+    if (lz4_test.chunk_len == LZ4_TEST_CHUNK) {
+        test_flush();
+    }
+}
+
+static void test_put_le32(uint32_t value)
+{
+    for (int i = 0; i < 4; i++) {
+        test_put(true, (uint8_t)(value >> (8 * i)));
+    }
+}
+
+// 길이 추가 바이트 (15 이상일 때), 반환값: 추가 바이트 수
+static uint32_t test_put_length(bool emit, uint32_t length)
+{
+    if (length < 15) {
+        return 0;
+    }
+    uint32_t count = 0;
+    length -= 15;
+    while (length >= 255) {
+        test_put(emit, 255);
+        length -= 255;
+        count++;
+    }
+    test_put(emit, (uint8_t)length);
+    return count + 1;
+}
+
+// 압축 블록 1개 부호화 (emit이 false면 크기만 계산)
+// produced: 이전까지 출력된 바이트 수 (갱신됨)
+static uint32_t test_block(uint32_t block, uint32_t *produced, bool emit)
+{
+    uint32_t size = 0;
+    uint32_t pos = *produced;
+
+    for (uint32_t k = 0; k < LZ4_TEST_SEQUENCES; k++) {
+        // 첫 시퀀스는 한 주기 이상의 리터럴 (이후 매치 거리 확보)
+        uint32_t lit = (pos == 0) ? LZ4_TEST_PERIOD + 17 : (block * 11 + k * 7) % 50;
+        uint32_t match = LZ4_MIN_MATCH + (block * 31 + k * 53) % 2500;
+        uint32_t m = 1 + (k % 8);
+        while (LZ4_TEST_PERIOD * m > pos + lit) {
+            m--;
+        }
+        uint32_t offset = LZ4_TEST_PERIOD * m;
+
+        uint8_t token = (uint8_t)(((lit < 15) ? lit : 15) << 4);
+        token |= (match - LZ4_MIN_MATCH < 15) ? (match - LZ4_MIN_MATCH) : 15;
+        test_put(emit, token);
+        size += 1 + test_put_length(emit, lit);
+        for (uint32_t i = 0; i < lit; i++) {
+            test_put(emit, test_wave(pos + i));
+        }
+        pos += lit;
+        test_put(emit, (uint8_t)offset);
+        test_put(emit, (uint8_t)(offset >> 8));
+        size += lit + 2 + test_put_length(emit, match - LZ4_MIN_MATCH);
+        pos += match;
+    }
+
+    // 마지막 시퀀스: 리터럴만
+    uint32_t lit = 5 + block % 10;
+    test_put(emit, (uint8_t)(lit << 4));
+    for (uint32_t i = 0; i < lit; i++) {
+        test_put(emit, test_wave(pos + i));
+    }
+    size += 1 + lit;
+    pos += lit;
+
+    if (emit) {
+        *produced = pos;
+    }
+    return size;
+}
+
+// 합성 프레임 전체를 해제기에 공급, 반환값: 해제 결과 상태
+static Lz4StreamStatus_t test_run(bool verify)
+{
+    memset(&lz4_test, 0, sizeof(lz4_test));
+    lz4_test.verify = verify;
+    lz4_stream_init(test_output);
+
+    // 프레임 헤더: 매직, FLG (버전 01, 블록 연결, 체크섬 없음), BD (64KB), HC
+    test_put_le32(LZ4_FRAME_MAGIC);
+    test_put(true, LZ4_FLG_VERSION_01);
+    test_put(true, 0x40);
+    test_put(true, 0x00);
+
+    uint32_t produced = 0;
+    for (uint32_t b = 0; b < LZ4_TEST_BLOCKS; b++) {
+        uint32_t scratch = produced;
+        test_put_le32(test_block(b, &scratch, false));
+        test_block(b, &produced, true);
+    }
+
+    // 비압축 블록
+    test_put_le32(LZ4_BLOCK_UNCOMPRESSED | LZ4_TEST_RAW_BLOCK);
+    for (uint32_t i = 0; i < LZ4_TEST_RAW_BLOCK; i++) {
+        test_put(true, test_wave(produced + i));
+    }
+    produced += LZ4_TEST_RAW_BLOCK;
+
+    // 종료 마크 + Y-MODEM 패딩 (0x1A, 무시되어야 함)
+    test_put_le32(0);
+    for (int i = 0; i < 64; i++) {
+        test_put(true, 0x1A);
+    }
+    test_flush();
+
+    if (lz4_test.checked != produced || lz4_stream_output_bytes() != produced) {
+        lz4_test.mismatch = true;
+    }
+    return lz4_stream_status();
+}
+
+// 해제기 검증 및 속도 측정
+int lz4_stream_self_test(char *report, uint32_t report_size)
+{
+    int offset = 0;
+
+    Lz4StreamStatus_t status = test_run(true);
+    bool ok = (status == LZ4_STREAM_DONE && !lz4_test.mismatch);
+    offset += snprintf(report + offset, report_size - offset,
+                       "verify %s: %lu -> %lu bytes\r\n", ok ? "PASS" : "FAIL",
+                       lz4_test.input_bytes, lz4_test.checked);
+
+    // 속도 측정 (출력 비교 없이 해제만)
+    test_run(false);
+    uint32_t out = lz4_test.checked;
+    uint32_t cycles = lz4_test.decode_cycles;
+    uint32_t centi_cpb = out ? (uint32_t)(((uint64_t)cycles * 100) / out) : 0;
+    uint32_t kbps = cycles ? (uint32_t)(((uint64_t)out * SystemCoreClock) / cycles / 1024) : 0;
+    uint32_t centi_ratio = lz4_test.input_bytes ? (uint32_t)(((uint64_t)out * 100) / lz4_test.input_bytes) : 0;
+
+    offset += snprintf(report + offset, report_size - offset,
+                       "decode %lu.%02lu cycles/byte, %lu KB/s, ratio %lu.%02lu\r\n",
+                       centi_cpb / 100, centi_cpb % 100, kbps, centi_ratio / 100, centi_ratio % 100);
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,245 @@
+/*
+ * msc_storage.c
+ *
+ *  USB 대용량 저장 장치(MSC)용 SD 블록 접근 구현
+ *  - 호스트 소유 중에는 FatFs가 마운트되어 있지 않으므로 펌웨어 쪽 파일 접근은 FR_NOT_ENABLED로 실패
+ *  - SCSI READ(10)/WRITE(10)는 MSC 미디어 패킷 단위로 들어오고, 그대로 다중 블록 DMA 한 번으로 처리
+ */
+
+#include "msc_storage.h"
+#include "fatfs.h"
+#include "user_def.h"       // sdmmc1_buffer (벤치마크)
+#include "ymodem.h"
+#include "audio_stream.h"
+#include <string.h>
+#include <stdio.h>
+
+// init_sdmmc()가 채우는 카드 용량
+uint32_t cached_block_num = 0;
+uint16_t cached_block_size = 512;
+uint8_t capacity_cached = 0;
+
+static volatile bool host_owned = false;
+static uint32_t attach_tick;
+static MscStorageStats_t stats;
+
+// 호스트 연속 전송 구간 추적 (USB 포함 처리량): 직전 요청의 방향/다음 블록/시작 시각
+#define MSC_STREAM_GAP_MS   50      // 요청 간격이 이보다 길면 호스트가 쉰 것으로 보고 새 구간
+static int8_t stream_dir;           // 0 = 없음, 1 = 읽기, 2 = 쓰기
+static uint32_t stream_next_blk;
+static uint32_t stream_prev_len;
+static uint32_t stream_mark;
+
+static uint32_t cycles_to_us(uint32_t cycles)
+{
+    return cycles / (SystemCoreClock / 1000000);
+}
+
+// 같은 방향으로 이어지는 요청이면 직전 요청 시작부터 지금까지(직전 패킷의 SD + USB 전송)를 합산
+static void stream_track(int8_t dir, uint32_t blk_addr, uint32_t blk_len)
+{
+    uint32_t now = DWT->CYCCNT;
+    uint32_t gap_us = cycles_to_us(now - stream_mark);
+
+    if (dir == stream_dir && blk_addr == stream_next_blk && gap_us < MSC_STREAM_GAP_MS * 1000) {
+        if (dir == 1) {
+            stats.usb_read_blocks += stream_prev_len;
+            stats.usb_read_us += gap_us;
+        } else {
+            stats.usb_write_blocks += stream_prev_len;
+            stats.usb_write_us += gap_us;
+        }
+    }
+    stream_dir = dir;
+    stream_next_blk = blk_addr + blk_len;
+    stream_prev_len = blk_len;
+    stream_mark = now;
+}
+
+FRESULT msc_storage_attach(void)
+{
+    if (host_owned) {
+        return FR_OK;
+    }
+    if (!capacity_cached) {
+        return FR_NOT_READY;
+    }
+    if (ymodem_is_active()) {
+        return FR_LOCKED;
+    }
+
+    // 재생 중인 파일과 남은 write-behind 쓰기를 정리한 뒤 마운트 해제
+    audio_stop_all();
+    SD_SetWriteBehind(0);
+    FRESULT res = f_mount(NULL, (TCHAR const*)SDPath, 0);
+    if (res != FR_OK) {
+        printf("[ERROR] MSC: unmount failed (error %d)\r\n", res);
+        return res;
+    }
+
+    memset(&stats, 0, sizeof(stats));
+    stream_dir = 0;
+    attach_tick = HAL_GetTick();
+    host_owned = true;
+    printf("[DEBUG] MSC: volume handed to USB host (%lu blocks)\r\n", cached_block_num + 1);
+    return FR_OK;
+}
+
+FRESULT msc_storage_detach(void)
+{
+    if (!host_owned) {
+        return FR_OK;
+    }
+
+    host_owned = false;
+    stats.attached_ms = HAL_GetTick() - attach_tick;
+    printf("[DEBUG] MSC: host released volume after %lu ms, read %lu KB in %lu us, write %lu KB in %lu us, %lu errors\r\n",
+           stats.attached_ms, stats.read_blocks / 2, stats.read_us,
+           stats.write_blocks / 2, stats.write_us, stats.errors);
+
+    // 호스트가 바꾼 FAT/디렉토리를 새로 읽도록 즉시 마운트
+    FRESULT res = f_mount(&SDFatFS, (TCHAR const*)SDPath, 1);
+    if (res != FR_OK) {
+        printf("[ERROR] MSC: remount failed (error %d)\r\n", res);
+    }
+    return res;
+}
+
+bool msc_storage_host_owned(void)
+{
+    return host_owned;
+}
+
+int8_t msc_storage_read(uint8_t *buf, uint32_t blk_addr, uint32_t blk_len)
+{
+    if (!host_owned || blk_addr + blk_len > cached_block_num + 1) {
+        stats.errors++;
+        return -1;
+    }
+
+    // SD_read()는 완료 후 32바이트 단위로 캐시를 무효화하므로, 버퍼 앞뒤 캐시 라인에 있는
+    // 다른 변수(MSC 핸들 필드 등)의 변경분이 사라지지 않도록 먼저 메모리에 기록
+    uint32_t aligned = (uint32_t)buf & ~0x1F;
+    SCB_CleanDCache_by_Addr((uint32_t*)aligned, blk_len * BLOCKSIZE + ((uint32_t)buf - aligned));
+
+    stream_track(1, blk_addr, blk_len);
+    uint32_t start = DWT->CYCCNT;
+    DRESULT res = SD_Driver.disk_read(0, buf, blk_addr, blk_len);
+    stats.read_us += cycles_to_us(DWT->CYCCNT - start);
+
+    if (res != RES_OK) {
+        stats.errors++;
+        return -1;
+    }
+    stats.read_blocks += blk_len;
+    return 0;
+}
+
+int8_t msc_storage_write(const uint8_t *buf, uint32_t blk_addr, uint32_t blk_len)
+{
+    if (!host_owned || blk_addr + blk_len > cached_block_num + 1) {
+        stats.errors++;
+        return -1;
+    }
+
+    stream_track(2, blk_addr, blk_len);
+    uint32_t start = DWT->CYCCNT;
+    DRESULT res = SD_Driver.disk_write(0, buf, blk_addr, blk_len);
+    stats.write_us += cycles_to_us(DWT->CYCCNT - start);
+
+    if (res != RES_OK) {
+        stats.errors++;
+        return -1;
+    }
+    stats.write_blocks += blk_len;
+    return 0;
+}
+
+void msc_storage_stats(MscStorageStats_t *out)
+{
+    *out = stats;
+    if (host_owned) {
+        out->attached_ms = HAL_GetTick() - attach_tick;
+    }
+}
+
+// MB/s (x100) = 바이트 / us
+static uint32_t rate_x100(uint32_t bytes, uint32_t us)
+{
+    return (us == 0) ? 0 : (uint32_t)(((uint64_t)bytes * 100) / us);
+}
+
+int msc_storage_benchmark(uint32_t size_kb, char *report, uint32_t report_size)
+{
+    // MSC 미디어 패킷 크기 후보 (sdmmc1_buffer 32KB까지)
+    static const uint32_t chunks_kb[] = { 4, 16, 32 };
+    static const char path[] = "/mscbench.tmp";
+    uint32_t blocks = size_kb * 2;
+    uint32_t offset = 0;
+    int failures = 0;
+    FIL fil;
+
+    report[0] = '\0';
+    if (host_owned || !capacity_cached) {
+        snprintf(report, report_size, "card not ready\r\n");
+        return 1;
+    }
+
+    // 시험 영역 = 연속 할당한 임시 파일 (SDBENCH와 같은 f_expand), 다른 파일/FAT 섹터는 건드리지 않음
+    FRESULT res = f_open(&fil, path, FA_CREATE_ALWAYS | FA_WRITE);
+    if (res == FR_OK) {
+        res = f_expand(&fil, blocks * 512, 1);
+        if (res != FR_OK) {
+            f_close(&fil);
+            f_unlink(path);
+        }
+    }
+    if (res != FR_OK) {
+        snprintf(report, report_size, "no contiguous free space (error %d)\r\n", res);
+        return 1;
+    }
+    FATFS *fs = fil.obj.fs;
+    uint32_t base = fs->database + (fil.obj.sclust - 2) * fs->csize;
+
+    for (uint32_t i = 0; i < sizeof(sdmmc1_buffer); i++) {
+        sdmmc1_buffer[i] = (uint8_t)i;
+    }
+
+    for (uint32_t i = 0; i < sizeof(chunks_kb) / sizeof(chunks_kb[0]); i++) {
+        uint32_t chunk = chunks_kb[i] * 2;
+        uint32_t read_us = 0;
+        uint32_t write_us = 0;
+        bool ok = true;
+
+        // 쓰기: 청크 단위 순차 다중 블록 쓰기 (카드 프로그래밍 종료까지)
+        for (uint32_t blk = 0; blk < blocks && ok; blk += chunk) {
+            uint32_t start = DWT->CYCCNT;
+            ok = (SD_Driver.disk_write(0, sdmmc1_buffer, base + blk, chunk) == RES_OK);
+            write_us += cycles_to_us(DWT->CYCCNT - start);
+        }
+
+        // 읽기: 방금 쓴 영역을 같은 청크 단위로 순차 읽기
+        for (uint32_t blk = 0; blk < blocks && ok; blk += chunk) {
+            uint32_t start = DWT->CYCCNT;
+            ok = (SD_Driver.disk_read(0, sdmmc1_buffer, base + blk, chunk) == RES_OK);
+            read_us += cycles_to_us(DWT->CYCCNT - start);
+        }
+
+        if (!ok) {
+            failures++;
+        }
+        uint32_t read_rate = rate_x100(blocks * 512, read_us);
+        uint32_t write_rate = rate_x100(blocks * 512, write_us);
+        offset += snprintf(&report[offset], report_size - offset,
+                           "chunk %2lu KB: read %lu.%02lu MB/s, write %lu.%02lu MB/s%s\r\n",
+                           chunks_kb[i], read_rate / 100, read_rate % 100,
+                           write_rate / 100, write_rate % 100, ok ? "" : " (SD error)");
+        if (offset >= report_size) {
+            break;
+        }
+    }
+
+    f_close(&fil);
+    f_unlink(path);
+    return failures;
+}
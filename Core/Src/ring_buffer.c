@@ -2,63 +2,106 @@
  * ring_buffer.c
  *
  *  USB CDC용 링 버퍼 구현
+ *  - 단일 생산자/단일 소비자: 생산자는 head만, 소비자는 tail만 기록
+ *  - 데이터 복사는 최대 두 구간 memcpy (래핑 지점 전/후)
+ *  - 메모리 순서: 생산자는 데이터 기록 → __DMB() → head 갱신,
+ *                 소비자는 head 확인 → __DMB() → 데이터 읽기 → __DMB() → tail 갱신
  */
 
 #include "ring_buffer.h"
+#include <string.h>
+#include <stdio.h>
 
-// 링 버퍼 초기화
-void ring_buffer_init(RingBuffer_t *rb)
+// 링 버퍼 초기화 (size는 2의 거듭제곱)
+void ring_buffer_init(RingBuffer_t *rb, uint8_t *storage, uint32_t size)
 {
+    rb->buffer = storage;
+    rb->mask = size - 1;
     rb->head = 0;
     rb->tail = 0;
-    rb->count = 0;
 }
 
-// 단일 바이트 쓰기
-bool ring_buffer_write(RingBuffer_t *rb, uint8_t data)
+// 누적 위치 pos부터 length바이트 기록 (래핑 지점에서 두 구간으로 나눔)
+static void copy_in(RingBuffer_t *rb, uint32_t pos, const uint8_t *data, uint32_t length)
 {
-    if (rb->count >= RING_BUFFER_SIZE) {
-        return false;  // 버퍼 가득 찼음
+    uint32_t index = pos & rb->mask;
+    uint32_t first = rb->mask + 1 - index;
+    if (first > length) {
+        first = length;
     }
+    memcpy(&rb->buffer[index], data, first);
+    memcpy(rb->buffer, data + first, length - first);
+}
 
-    rb->buffer[rb->head] = data;
-    rb->head = (rb->head + 1) % RING_BUFFER_SIZE;
-    rb->count++;
+// 누적 위치 pos부터 length바이트 읽기
+static void copy_out(const RingBuffer_t *rb, uint32_t pos, uint8_t *data, uint32_t length)
+{
+    uint32_t index = pos & rb->mask;
+    uint32_t first = rb->mask + 1 - index;
+    if (first > length) {
+        first = length;
+    }
+    memcpy(data, &rb->buffer[index], first);
+    memcpy(data + first, rb->buffer, length - first);
+}
 
-    return true;
+// 단일 바이트 쓰기
+bool ring_buffer_write(RingBuffer_t *rb, uint8_t data)
+{
+    return ring_buffer_write_array(rb, &data, 1);
 }
 
 // 배열 쓰기
 bool ring_buffer_write_array(RingBuffer_t *rb, const uint8_t *data, uint32_t length)
 {
-    if (rb->count + length > RING_BUFFER_SIZE) {
+    uint32_t head = rb->head;
+    if (length > rb->mask + 1 - (head - rb->tail)) {
         return false;  // 공간 부족
     }
 
-    for (uint32_t i = 0; i < length; i++) {
-        rb->buffer[rb->head] = data[i];
-        rb->head = (rb->head + 1) % RING_BUFFER_SIZE;
-        rb->count++;
-    }
+    copy_in(rb, head, data, length);
+    __DMB();    // 데이터가 보인 뒤에 head 갱신
+    rb->head = head + length;
 
     return true;
 }
 
+// 쓰기 구간 (head부터 래핑 지점 또는 tail까지)
+uint32_t ring_buffer_write_span(RingBuffer_t *rb, uint8_t **span)
+{
+    uint32_t head = rb->head;
+    uint32_t index = head & rb->mask;
+    uint32_t room = rb->mask + 1 - (head - rb->tail);
+    uint32_t contiguous = rb->mask + 1 - index;
+
+    *span = &rb->buffer[index];
+    return (room < contiguous) ? room : contiguous;
+}
+
+void ring_buffer_write_commit(RingBuffer_t *rb, uint32_t length)
+{
+    __DMB();
+    rb->head += length;
+}
+
 // 단일 바이트 읽기
 bool ring_buffer_read(RingBuffer_t *rb, uint8_t *data)
 {
-    if (rb->count == 0) {
+    uint32_t tail = rb->tail;
+    if (rb->head == tail) {
         return false;  // 버퍼 비어있음
     }
 
-    *data = rb->buffer[rb->tail];
-    rb->tail = (rb->tail + 1) % RING_BUFFER_SIZE;
-    rb->count--;
+    __DMB();    // head 확인 후 데이터 읽기
+    *data = rb->buffer[tail & rb->mask];
+    __DMB();    // 읽은 뒤에 공간 반환
+    rb->tail = tail + 1;
 
     return true;
 }
 
 // 배열 읽기 (타임아웃 지원)
+// 도착한 만큼 한 번에 복사하고, 모자라면 대기 후 나머지를 이어서 읽음
 uint32_t ring_buffer_read_array(RingBuffer_t *rb, uint8_t *data, uint32_t length, uint32_t timeout_ms)
 {
     uint32_t start_tick = HAL_GetTick();
@@ -75,11 +118,18 @@ uint32_t ring_buffer_read_array(RingBuffer_t *rb, uint8_t *data, uint32_t length
         }
 
         // 데이터 읽기
-        if (rb->count > 0) {
-            data[read_count] = rb->buffer[rb->tail];
-            rb->tail = (rb->tail + 1) % RING_BUFFER_SIZE;
-            rb->count--;
-            read_count++;
+        uint32_t tail = rb->tail;
+        uint32_t available = rb->head - tail;
+        if (available > 0) {
+            uint32_t n = length - read_count;
+            if (n > available) {
+                n = available;
+            }
+            __DMB();
+            copy_out(rb, tail, &data[read_count], n);
+            __DMB();
+            rb->tail = tail + n;
+            read_count += n;
         } else {
             // 데이터가 없으면 대기 (USB 인터럽트 실행 시간 제공)
             // USB CDC는 1ms 폴링 주기이므로 1ms 대기
@@ -97,18 +147,205 @@ uint32_t ring_buffer_read_array(RingBuffer_t *rb, uint8_t *data, uint32_t length
     return read_count;
 }
 
+// 읽기 구간 (tail부터 래핑 지점 또는 head까지, 복사 없이 처리할 때)
+uint32_t ring_buffer_read_span(RingBuffer_t *rb, const uint8_t **span)
+{
+    uint32_t tail = rb->tail;
+    uint32_t index = tail & rb->mask;
+    uint32_t available = rb->head - tail;
+    uint32_t contiguous = rb->mask + 1 - index;
+
+    __DMB();
+    *span = &rb->buffer[index];
+    return (available < contiguous) ? available : contiguous;
+}
+
+void ring_buffer_read_commit(RingBuffer_t *rb, uint32_t length)
+{
+    __DMB();
+    rb->tail += length;
+}
+
 // 사용 가능한 데이터 수
 uint32_t ring_buffer_available(RingBuffer_t *rb)
 {
-    return rb->count;
+    return rb->head - rb->tail;
 }
 
-// 버퍼 클리어
+// 버퍼 클리어 (tail을 head로: 소비자만 tail을 바꾸므로 인터럽트 금지 불필요)
 void ring_buffer_clear(RingBuffer_t *rb)
 {
-    rb->head = 0;
-    rb->tail = 0;
-    rb->count = 0;
+    rb->tail = rb->head;
+}
+
+// ============================================================================
+// 자체 검증 / 벤치마크 (RINGTEST 명령)
+// ============================================================================
+
+#define RING_TEST_SIZE          8192
+#define RING_TEST_STREAM        (8 * RING_TEST_SIZE)    // 검증 시 흘려보낼 바이트 (래핑 8회)
+#define RING_TEST_IO_SIZE       4096
+
+// 비교 기준: 이전 구현 (공유 count, 바이트마다 % 연산)
+typedef struct {
+    uint8_t *buffer;
+    volatile uint32_t head;
+    volatile uint32_t tail;
+    volatile uint32_t count;
+} LegacyRing_t;
+
+static bool legacy_write_array(LegacyRing_t *rb, const uint8_t *data, uint32_t length)
+{
+    if (rb->count + length > RING_TEST_SIZE) {
+        return false;
+    }
+    for (uint32_t i = 0; i < length; i++) {
+        rb->buffer[rb->head] = data[i];
+        rb->head = (rb->head + 1) % RING_TEST_SIZE;
+        rb->count++;
+    }
+    return true;
+}
+
+static uint32_t legacy_read_array(LegacyRing_t *rb, uint8_t *data, uint32_t length)
+{
+    uint32_t read_count = 0;
+    while (read_count < length && rb->count > 0) {
+        data[read_count++] = rb->buffer[rb->tail];
+        rb->tail = (rb->tail + 1) % RING_TEST_SIZE;
+        rb->count--;
+    }
+    return read_count;
+}
+
+static inline uint8_t test_pattern(uint32_t pos)
+{
+    return (uint8_t)(pos * 7 + (pos >> 8));
+}
+
+// 래핑 경계 검증: 쓰기 단위 chunk로 가득 찰 때까지 쓰고, 읽기는 배열/구간 방식을 번갈아
+// 읽기 길이는 chunk와 어긋나게 해 래핑 지점이 매번 다른 위치에 오도록 함
+static bool check_stream(RingBuffer_t *rb, uint8_t *src, uint8_t *dst, uint32_t chunk)
+{
+    uint32_t wpos = 0;
+    uint32_t rpos = 0;
+    uint32_t reads = 0;
+
+    while (rpos < RING_TEST_STREAM) {
+        while (wpos < RING_TEST_STREAM) {
+            uint32_t n = (RING_TEST_STREAM - wpos < chunk) ? RING_TEST_STREAM - wpos : chunk;
+            for (uint32_t i = 0; i < n; i++) {
+                src[i] = test_pattern(wpos + i);
+            }
+            bool fits = (n <= RING_TEST_SIZE - (wpos - rpos));
+            if (ring_buffer_write_array(rb, src, n) != fits) {
+                return false;   // 공간 판정 오류
+            }
+            if (!fits) {
+                break;
+            }
+            wpos += n;
+        }
+        if (ring_buffer_available(rb) != wpos - rpos) {
+            return false;
+        }
+
+        uint32_t want = (chunk * 3) / 2 + 1;
+        if (want > RING_TEST_IO_SIZE) {
+            want = RING_TEST_IO_SIZE;
+        }
+        uint32_t n;
+        if (reads++ & 1) {
+            const uint8_t *span;
+            n = ring_buffer_read_span(rb, &span);
+            n = (n > want) ? want : n;
+            memcpy(dst, span, n);
+            ring_buffer_read_commit(rb, n);
+        } else {
+            uint32_t available = ring_buffer_available(rb);
+            n = ring_buffer_read_array(rb, dst, (available < want) ? available : want, 0);
+        }
+        if (n == 0) {
+            return false;
+        }
+        for (uint32_t i = 0; i < n; i++) {
+            if (dst[i] != test_pattern(rpos + i)) {
+                return false;
+            }
+        }
+        rpos += n;
+    }
+    return ring_buffer_available(rb) == 0;
+}
+
+int ring_buffer_self_test(uint8_t *scratch, uint32_t scratch_size, char *report, uint32_t report_size)
+{
+    static const uint32_t chunks[] = { 1, 7, 64, 512, 1029, 4096 };
+    static const uint32_t bench_chunks[] = { 64, 512 };
+    uint8_t *storage = scratch;
+    uint8_t *src = &scratch[RING_TEST_SIZE];
+    uint8_t *dst = &scratch[RING_TEST_SIZE + RING_TEST_IO_SIZE];
+    RingBuffer_t rb;
+    int failures = 0;
+    int offset = 0;
+
+    if (scratch_size < RING_TEST_SIZE + 2 * RING_TEST_IO_SIZE) {
+        snprintf(report, report_size, "scratch too small\r\n");
+        return 1;
+    }
+
+    // 래핑 경계 검증 (시작 위치를 바꿔 누적값 32비트 래핑도 확인)
+    for (uint32_t c = 0; c < sizeof(chunks) / sizeof(chunks[0]); c++) {
+        ring_buffer_init(&rb, storage, RING_TEST_SIZE);
+        rb.head = rb.tail = 0u - RING_TEST_SIZE * 3 - c * 13;
+        bool ok = check_stream(&rb, src, dst, chunks[c]);
+        if (!ok) {
+            failures++;
+        }
+        offset += snprintf(report + offset, report_size - offset,
+                           "wrap chunk %4lu: %s\r\n", chunks[c], ok ? "PASS" : "FAIL");
+    }
+
+    // 처리 시간: 쓰기 chunk → 읽기 chunk 반복 (USB FS/HS 패킷 크기), 64KB 통과
+    for (uint32_t c = 0; c < sizeof(bench_chunks) / sizeof(bench_chunks[0]); c++) {
+        uint32_t chunk = bench_chunks[c];
+        uint32_t rounds = RING_TEST_STREAM / chunk;
+        uint32_t legacy_w = 0, legacy_r = 0, spsc_w = 0, spsc_r = 0;
+        LegacyRing_t legacy = { .buffer = storage };
+
+        memset(src, 0x5A, chunk);
+        for (uint32_t r = 0; r < rounds; r++) {
+            uint32_t t0 = DWT->CYCCNT;
+            legacy_write_array(&legacy, src, chunk);
+            uint32_t t1 = DWT->CYCCNT;
+            legacy_read_array(&legacy, dst, chunk);
+            uint32_t t2 = DWT->CYCCNT;
+            legacy_w += t1 - t0;
+            legacy_r += t2 - t1;
+        }
+
+        ring_buffer_init(&rb, storage, RING_TEST_SIZE);
+        for (uint32_t r = 0; r < rounds; r++) {
+            uint32_t t0 = DWT->CYCCNT;
+            ring_buffer_write_array(&rb, src, chunk);
+            uint32_t t1 = DWT->CYCCNT;
+            ring_buffer_read_array(&rb, dst, chunk, 0);
+            uint32_t t2 = DWT->CYCCNT;
+            spsc_w += t1 - t0;
+            spsc_r += t2 - t1;
+        }
+
+        // cycles/byte x100
+        uint32_t lw = (uint32_t)(((uint64_t)legacy_w * 100) / RING_TEST_STREAM);
+        uint32_t lr = (uint32_t)(((uint64_t)legacy_r * 100) / RING_TEST_STREAM);
+        uint32_t sw = (uint32_t)(((uint64_t)spsc_w * 100) / RING_TEST_STREAM);
+        uint32_t sr = (uint32_t)(((uint64_t)spsc_r * 100) / RING_TEST_STREAM);
+        offset += snprintf(report + offset, report_size - offset,
+                           "chunk %3lu: legacy W %lu.%02lu R %lu.%02lu, spsc W %lu.%02lu R %lu.%02lu cycles/byte\r\n",
+                           chunk, lw / 100, lw % 100, lr / 100, lr % 100, sw / 100, sw % 100, sr / 100, sr % 100);
+    }
+
+    return failures;
 }
 
 // ============================================================================
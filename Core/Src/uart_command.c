@@ -144,43 +144,10 @@ void uart_send_response(const char *format, ...)
 
     // 전송 방식에 따라 다르게 전송
     if (current_transport == CMD_TRANSPORT_USB_CDC) {
-        // USB CDC로 전송 - UserTxBufferHS에 복사하여 전송
-        extern USBD_HandleTypeDef hUsbDeviceHS;
-        extern uint8_t UserTxBufferHS[APP_TX_DATA_SIZE];
-
-        USBD_CDC_HandleTypeDef *hcdc = (USBD_CDC_HandleTypeDef*)hUsbDeviceHS.pClassData;
-        uint8_t result;
-        uint32_t retry_count = 0;
-        const uint32_t max_retries = 200;  // 최대 200회 재시도
-
-        // 이전 전송 완료 대기
-        while (hcdc->TxState != 0 && retry_count < max_retries) {
-            retry_count++;
-            // Busy-wait (인터럽트가 처리될 시간 제공)
-            for (volatile int i = 0; i < 10000; i++);
-        }
-
-        if (retry_count >= max_retries) {
-            printf("[ERROR] CDC_Transmit: previous transmission timeout (retries=%lu)\r\n", retry_count);
-            return;
-        }
-
-        // UserTxBufferHS에 데이터 복사 (버퍼 수명 문제 해결)
-        if (len > APP_TX_DATA_SIZE) {
-            len = APP_TX_DATA_SIZE;
-        }
-        memcpy(UserTxBufferHS, buffer, len);
-
-        // 전송 (비동기 방식 - 완료를 기다리지 않음)
-        result = CDC_Transmit_HS(UserTxBufferHS, len);
-        if (result == USBD_BUSY) {
-            // Busy 상태면 잠시 후 재시도
-            HAL_Delay(1);
-            result = CDC_Transmit_HS(UserTxBufferHS, len);
-        }
-
-        if (result != USBD_OK && result != USBD_BUSY) {
-            printf("[ERROR] CDC_Transmit failed: %d\r\n", result);
+        // USB CDC로 전송 - 전송 큐에 넣고 바로 반환 (이전 전송이 끝나면 완료 인터럽트에서 모아서 전송)
+        // 명령 처리는 USB 수신 인터럽트 안에서 실행되므로 여기서 전송 완료를 기다릴 수 없음
+        if (!CDC_Queue_Transmit((const uint8_t*)buffer, len)) {
+            printf("[ERROR] CDC_Transmit: TX queue full, response dropped (%u bytes)\r\n", (unsigned)len);
         }
     } else {
         // UART로 전송
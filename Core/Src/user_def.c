@@ -16,6 +16,8 @@
 #include "command_handler.h"
 #include "ansi_colors.h"
 #include "ring_buffer.h"
+#include "crc_engine.h"
+#include "msc_storage.h"
 
 #include  <errno.h>
 #include  <sys/unistd.h> // STDOUT_FILENO, STDERR_FILENO
@@ -257,17 +259,10 @@ void init_sdmmc(void)
 		HAL_SD_CardStateTypeDef card_state = HAL_SD_GetCardState(&hsd1);
 		printf("SD Card State: %d (1=READY, 2=IDENT, 3=STDBY, 4=TRANSFER, 5=SEND, 6=RCV, 7=PRG, 8=DIS, 0xFF=ERR)\r\n", card_state);
 
-		/* Cache values in usbd_storage_if.c (USB 사용 시 필요) */
-		/* 현재 USB는 사용하지 않으므로 주석 처리 */
-		/*
-		extern uint32_t cached_block_num;
-		extern uint16_t cached_block_size;
-		extern uint8_t capacity_cached;
-
+		/* 용량 캐시 (msc_storage.c: USB MSC READ CAPACITY, MSCBENCH) */
 		cached_block_num = card_info.LogBlockNbr - 1;
 		cached_block_size = card_info.LogBlockSize;
 		capacity_cached = 1;
-		*/
 	}
 
 	/* Wait again for HAL to be READY after GetCardInfo */
@@ -802,6 +797,19 @@ void sound_mon_select(uint8_t channel)
 	}
 }
 
+// 메인 루프 최장 실행 시간 (사이클)
+static uint32_t main_loop_max_cycles = 0;
+
+uint32_t main_loop_max_us(void)
+{
+	return main_loop_max_cycles / (SystemCoreClock / 1000000);
+}
+
+void main_loop_stats_reset(void)
+{
+	main_loop_max_cycles = 0;
+}
+
 void init_proc(void)
 {
 	// 시스템 초기화
@@ -809,6 +817,15 @@ void init_proc(void)
 
 	// UART2 DMA TX 초기화 (논블럭 printf)
 	init_UART2_DMA_TX();
+
+	// CRC-16 엔진 초기화 (Y-MODEM 패킷 검증)
+	crc_engine_init();
+
+	// DWT 사이클 카운터 활성화 (메인 루프 실행 시간 측정)
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->LAR = 0xC5ACCE55;
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
 }
 
 void run_proc(void)
@@ -872,12 +889,20 @@ void run_proc(void)
 	uint32_t last_status_print = 0;
 	while(1)
 	{
+		uint32_t loop_start = DWT->CYCCNT;
+
 		/* UART2 DMA TX 큐 처리 (논블럭 printf) */
 		UART2_Process_TX_Queue();
 
-		/* Y-MODEM 업로드 요청 처리 (인터럽트가 아닌 메인 컨텍스트) */
+		/* Y-MODEM 업로드 처리 (인터럽트가 아닌 메인 컨텍스트, 호출마다 한 단계씩) */
 		process_upload_request();
 
+		/* USB MSC 전환 (MSC ON/OFF 명령 또는 호스트 꺼내기 후 재열거) */
+		process_msc_request();
+
+		/* 긴 SD 작업 (SDBENCH 등, 수신 인터럽트 대신 여기서 실행) */
+		process_sd_job_request();
+
 		/* 오디오 스트리밍 태스크 실행 */
 		audio_stream_task();
 
@@ -885,6 +910,7 @@ void run_proc(void)
 		if ((HAL_GetTick() - last_status_print) > 5000) {
 			last_status_print = HAL_GetTick();
 			audio_print_status();  // 오디오 시스템 상태 출력
+			printf("Main loop: max %lu us\r\n", main_loop_max_us());
 		}
 
 		/* LED 토글 (동작 확인용) */
@@ -893,6 +919,12 @@ void run_proc(void)
 			last_led_toggle = HAL_GetTick();
 			HAL_GPIO_TogglePin(OT_SYS_GPIO_Port, OT_SYS_Pin);
 		}
+
+		/* 메인 루프 최장 실행 시간 기록 */
+		uint32_t loop_cycles = DWT->CYCCNT - loop_start;
+		if (loop_cycles > main_loop_max_cycles) {
+			main_loop_max_cycles = loop_cycles;
+		}
 	}
 }
 
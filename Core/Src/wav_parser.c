@@ -8,11 +8,41 @@
  */
 
 #include "wav_parser.h"
+#include "main.h"
+#include "user_def.h"   // sdmmc1_buffer (벤치마크)
 #include <string.h>
 #include <stdio.h>
 
+/* 업로드 변환 설정 */
+#define WAV_TRANSCODE_HEADER_MAX    512     // data 청크 앞까지 모을 최대 헤더 크기 (넘으면 그대로 출력)
+#define WAV_TRANSCODE_CHUNK         512     // 변환 출력 단위 (스택 버퍼)
+#define WAV_CANONICAL_HEADER_SIZE   44      // RIFF + fmt(16) + data 헤더
+
+typedef enum {
+    TRANSCODE_HEADER = 0,       // 헤더 수집 (data 청크 시작까지)
+    TRANSCODE_DATA,             // 샘플 변환
+    TRANSCODE_PASSTHROUGH,      // 변환 대상 아님 (그대로 출력)
+    TRANSCODE_DONE              // data 청크 끝 (이후 바이트 버림)
+} TranscodeState_t;
+
+/* 업로드 변환 상태 (Y-MODEM 수신 1개 파일)
+ * .bss 여유가 없어 RAM_D1_DMA에 배치 (NOLOAD, wav_transcode_init()에서 초기화) */
+static struct {
+    TranscodeState_t state;
+    WAV_NativeFormat_t format;
+    WAV_TranscodeOutput_t output;
+    uint32_t sample_rate;
+    uint32_t data_remaining;    // 남은 입력 샘플 바이트 (16비트 샘플 수 x 2)
+    uint32_t output_bytes;      // 출력한 바이트 (헤더 포함)
+    uint8_t carry[4];           // 샘플 경계에 걸친 입력 바이트 (PCM12: 2, PACKED12: 4바이트 단위)
+    uint32_t carry_len;
+    uint32_t header_len;
+    uint8_t header[WAV_TRANSCODE_HEADER_MAX];
+} transcode __attribute__((section(".ram_d1_dma")));
+
 /* 내부 함수 프로토타입 */
 static FRESULT find_data_chunk(FIL *fp, uint32_t *data_size, uint32_t *data_offset);
+static void unpack12(const uint8_t *in, uint16_t *out, uint32_t count);
 
 /**
  * @brief  WAV 파일 열기 및 헤더 파싱
@@ -71,6 +101,12 @@ FRESULT wav_open(WAV_FileInfo_t *info, const char *filename)
     info->bits_per_sample = header.bits_per_sample;
     info->channels = header.num_channels;
 
+    /* 12비트 저장 포맷 (업로드 시 변환): block_align 3 = 2샘플 3바이트 묶음 */
+    info->format = WAV_NATIVE_NONE;
+    if (header.bits_per_sample == 12) {
+        info->format = (header.block_align == 3) ? WAV_NATIVE_PACKED12 : WAV_NATIVE_PCM12;
+    }
+
     /* data 청크 찾기 */
     res = find_data_chunk(&info->file, &info->data_size, &info->data_offset);
     if (res != FR_OK) {
@@ -79,15 +115,20 @@ FRESULT wav_open(WAV_FileInfo_t *info, const char *filename)
         return res;
     }
 
-    /* 총 샘플 수 계산 */
-    uint32_t bytes_per_sample = (info->bits_per_sample + 7) / 8;  // 올림
-    info->total_samples = info->data_size / (bytes_per_sample * info->channels);
+    /* 총 샘플 수 계산 (PACKED12: 3바이트당 2샘플, 홀수 샘플 끝은 2바이트) */
+    if (info->format == WAV_NATIVE_PACKED12) {
+        info->total_samples = (uint32_t)(((uint64_t)info->data_size * 2) / 3);
+    } else {
+        uint32_t bytes_per_sample = (info->bits_per_sample + 7) / 8;  // 올림
+        info->total_samples = info->data_size / (bytes_per_sample * info->channels);
+    }
     info->current_sample = 0;
     info->is_open = 1;
 
     printf("WAV: Opened %s\r\n", filename);
     printf("  Sample rate: %lu Hz\r\n", info->sample_rate);
-    printf("  Bits/sample: %u\r\n", info->bits_per_sample);
+    printf("  Bits/sample: %u%s\r\n", info->bits_per_sample,
+           (info->format == WAV_NATIVE_PACKED12) ? " (packed)" : "");
     printf("  Channels: %u\r\n", info->channels);
     printf("  Total samples: %lu\r\n", info->total_samples);
 
@@ -176,8 +217,41 @@ FRESULT wav_read_samples(WAV_FileInfo_t *info, uint16_t *buffer, uint32_t num_sa
         return FR_INVALID_PARAMETER;
     }
 
+    /* 12비트 packed 형식 (3바이트 = 2샘플)
+     * buffer[num_samples/2 바이트] 위치에 읽고 앞에서부터 풀기: 샘플 2k, 2k+1의 출력(4k~4k+3)은
+     * 항상 아직 풀지 않은 입력(num_samples/2 + 3k 이후)보다 앞이므로 추가 버퍼 없이 제자리 변환
+     * (AUDIO_BUFFER_SAMPLES 2048이면 읽기 위치 1024바이트 - buffer의 32바이트 정렬 유지) */
+    if (info->format == WAV_NATIVE_PACKED12) {
+        /* 샘플 쌍 중간에서 끊지 않음 (파일 끝의 홀수 샘플만 예외) */
+        if ((samples_to_read & 1) && info->current_sample + samples_to_read < info->total_samples) {
+            samples_to_read--;
+            if (samples_to_read == 0) {
+                return FR_INVALID_PARAMETER;
+            }
+        }
+
+        uint32_t bytes = (samples_to_read / 2) * 3 + (samples_to_read & 1) * 2;
+        uint8_t *packed = (uint8_t *)buffer + (num_samples / 2);
+        res = f_read(&info->file, packed, bytes, &bytes_read);
+        if (res != FR_OK) {
+            return res;
+        }
+        if (bytes_read < bytes) {
+            samples_to_read = (bytes_read / 3) * 2;     // 잘린 파일: 완전한 쌍까지만
+        }
+        unpack12(packed, buffer, samples_to_read);
+        *samples_read = samples_to_read;
+    }
+    /* 미리 마스킹된 12비트 (16비트 컨테이너) - 그대로 사용 */
+    else if (info->format == WAV_NATIVE_PCM12) {
+        res = f_read(&info->file, buffer, samples_to_read * 2, &bytes_read);
+        if (res != FR_OK) {
+            return res;
+        }
+        *samples_read = bytes_read / 2;
+    }
     /* 16비트 데이터 직접 읽기 */
-    if (info->bits_per_sample == 16) {
+    else if (info->bits_per_sample == 16) {
         res = f_read(&info->file, buffer, samples_to_read * 2, &bytes_read);
         if (res != FR_OK) {
             return res;
@@ -189,7 +263,6 @@ FRESULT wav_read_samples(WAV_FileInfo_t *info, uint16_t *buffer, uint32_t num_sa
             buffer[i] &= 0x0FFF;  // 12비트 마스킹
         }
     }
-    /* 12비트 packed 형식 (3바이트 = 2샘플) - 필요시 추가 */
     else {
         printf("WAV: Unsupported bits per sample: %u\r\n", info->bits_per_sample);
         return FR_INVALID_PARAMETER;
@@ -199,6 +272,34 @@ FRESULT wav_read_samples(WAV_FileInfo_t *info, uint16_t *buffer, uint32_t num_sa
     return FR_OK;
 }
 
+/**
+ * @brief  12비트 packed 풀기 (in은 out 뒤쪽과 겹쳐도 됨 - wav_read_samples() 참고)
+ * @note   4샘플(6바이트)씩 비정렬 32/16비트 읽기로 처리 (Cortex-M7 비정렬 LDR 지원)
+ *         읽기를 모두 끝낸 뒤 쓰므로 같은 반복 안에서도 겹침 안전
+ */
+static void unpack12(const uint8_t *in, uint16_t *out, uint32_t count)
+{
+    uint32_t i = 0;
+
+    for (; i + 4 <= count; i += 4, in += 6) {
+        uint32_t w0 = __UNALIGNED_UINT32_READ(in);
+        uint32_t w1 = __UNALIGNED_UINT16_READ(in + 4);
+        out[i]     = (uint16_t)(w0 & 0x0FFF);
+        out[i + 1] = (uint16_t)((w0 >> 12) & 0x0FFF);
+        out[i + 2] = (uint16_t)((w0 >> 24) | ((w1 & 0x0F) << 8));
+        out[i + 3] = (uint16_t)(w1 >> 4);
+    }
+    for (; i + 2 <= count; i += 2, in += 3) {
+        uint8_t b0 = in[0], b1 = in[1], b2 = in[2];
+        out[i]     = (uint16_t)(b0 | ((b1 & 0x0F) << 8));
+        out[i + 1] = (uint16_t)((b1 >> 4) | (b2 << 4));
+    }
+    if (i < count) {
+        uint8_t b0 = in[0], b1 = in[1];
+        out[i] = (uint16_t)(b0 | ((b1 & 0x0F) << 8));
+    }
+}
+
 /**
  * @brief  WAV 파일 읽기 위치 초기화
  */
@@ -258,3 +359,463 @@ uint8_t wav_is_valid(WAV_FileInfo_t *info)
 
     return 1;
 }
+
+/* ---------------------------------------------------------------------------
+ * 업로드 변환 (16비트 PCM → PCM12 / PACKED12)
+ * Y-MODEM 수신 경로가 데이터 블록(또는 LZ4 해제 결과)을 그대로 넘기면 변환해서 출력 콜백으로 전달
+ * ------------------------------------------------------------------------- */
+
+static uint16_t read_le16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t read_le32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void write_le16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void write_le32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static int transcode_emit(const uint8_t *data, uint32_t size)
+{
+    if (size == 0) {
+        return 0;
+    }
+    transcode.output_bytes += size;
+    return transcode.output(data, size);
+}
+
+/* 16비트 샘플 count개 변환 (PACKED12는 count 짝수), 반환값: 출력 바이트 수 */
+static uint32_t transcode_samples(const uint8_t *in, uint32_t count, uint8_t *out)
+{
+    if (transcode.format == WAV_NATIVE_PCM12) {
+        for (uint32_t i = 0; i < count; i++, in += 2) {
+            out[2 * i] = in[0];
+            out[2 * i + 1] = in[1] & 0x0F;
+        }
+        return count * 2;
+    }
+
+    for (uint32_t i = 0; i < count; i += 2, in += 4, out += 3) {
+        uint16_t s0 = read_le16(in) & 0x0FFF;
+        uint16_t s1 = read_le16(in + 2) & 0x0FFF;
+        out[0] = (uint8_t)s0;
+        out[1] = (uint8_t)((s0 >> 8) | (s1 << 4));
+        out[2] = (uint8_t)(s1 >> 4);
+    }
+    return (count / 2) * 3;
+}
+
+/* 변환 후 data 청크 크기 (입력 16비트 샘플 바이트 기준) */
+static uint32_t transcode_data_size(uint32_t input_bytes)
+{
+    uint32_t samples = input_bytes / 2;
+
+    if (transcode.format == WAV_NATIVE_PCM12) {
+        return samples * 2;
+    }
+    return (samples / 2) * 3 + (samples & 1) * 2;
+}
+
+/* 모은 헤더 파싱
+ * 반환값: 1 = 변환 대상 (*data_start: data 청크 시작), 0 = 더 필요, -1 = 변환 대상 아님 */
+static int transcode_parse_header(uint32_t *data_start)
+{
+    const uint8_t *h = transcode.header;
+    uint32_t len = transcode.header_len;
+    uint32_t offset = 12;
+    int fmt_ok = 0;
+
+    if (len < 12) {
+        return 0;
+    }
+    if (memcmp(h, "RIFF", 4) != 0 || memcmp(h + 8, "WAVE", 4) != 0) {
+        return -1;
+    }
+
+    while (1) {
+        if (offset + 8 > len) {
+            return 0;
+        }
+        uint32_t chunk_size = read_le32(h + offset + 4);
+
+        if (memcmp(h + offset, "data", 4) == 0) {
+            /* 크기 미지정 스트림 WAV는 끝을 알 수 없으므로 그대로 저장 */
+            if (!fmt_ok || chunk_size == 0 || chunk_size == 0xFFFFFFFF) {
+                return -1;
+            }
+            transcode.data_remaining = chunk_size & ~1U;
+            *data_start = offset + 8;
+            return 1;
+        }
+
+        if (memcmp(h + offset, "fmt ", 4) == 0) {
+            if (chunk_size < 16) {
+                return -1;
+            }
+            if (offset + 8 + 16 > len) {
+                return 0;
+            }
+            const uint8_t *f = h + offset + 8;
+            /* PCM, 모노, 16비트만 변환 */
+            if (read_le16(f) != 1 || read_le16(f + 2) != 1 || read_le16(f + 14) != 16) {
+                return -1;
+            }
+            transcode.sample_rate = read_le32(f + 4);
+            fmt_ok = 1;
+        }
+
+        /* 다음 청크 (홀수 크기 청크는 패딩 1바이트) */
+        if (chunk_size > WAV_TRANSCODE_HEADER_MAX) {
+            return -1;
+        }
+        offset += 8 + chunk_size + (chunk_size & 1);
+    }
+}
+
+/* 변환한 파일의 44바이트 표준 헤더 출력 */
+static int transcode_emit_header(void)
+{
+    uint8_t h[WAV_CANONICAL_HEADER_SIZE];
+    uint32_t data_size = transcode_data_size(transcode.data_remaining);
+    int packed = (transcode.format == WAV_NATIVE_PACKED12);
+
+    memcpy(h, "RIFF", 4);
+    write_le32(h + 4, 36 + data_size);
+    memcpy(h + 8, "WAVE", 4);
+    memcpy(h + 12, "fmt ", 4);
+    write_le32(h + 16, 16);
+    write_le16(h + 20, 1);                                          // PCM
+    write_le16(h + 22, 1);                                          // 모노
+    write_le32(h + 24, transcode.sample_rate);
+    write_le32(h + 28, packed ? transcode.sample_rate * 3 / 2 : transcode.sample_rate * 2);
+    write_le16(h + 32, packed ? 3 : 2);                             // block_align (PACKED12: 2샘플 3바이트)
+    write_le16(h + 34, 12);
+    memcpy(h + 36, "data", 4);
+    write_le32(h + 40, data_size);
+
+    return transcode_emit(h, sizeof(h));
+}
+
+/* data 청크 샘플 변환 (청크 끝 이후 바이트는 버림) */
+static int transcode_data(const uint8_t *data, uint32_t size)
+{
+    uint8_t out[WAV_TRANSCODE_CHUNK];
+    uint32_t unit = (transcode.format == WAV_NATIVE_PACKED12) ? 4 : 2;
+    uint32_t max_samples = (transcode.format == WAV_NATIVE_PACKED12) ?
+                           (WAV_TRANSCODE_CHUNK / 3) * 2 : WAV_TRANSCODE_CHUNK / 2;
+
+    while (size > 0 && transcode.data_remaining > 0) {
+        uint32_t avail = (size < transcode.data_remaining) ? size : transcode.data_remaining;
+        uint32_t consumed;
+
+        if (transcode.carry_len > 0 || avail < unit) {
+            /* 입력 경계에 걸친 샘플: carry에 모아서 변환 */
+            consumed = unit - transcode.carry_len;
+            if (consumed > avail) {
+                consumed = avail;
+            }
+            memcpy(&transcode.carry[transcode.carry_len], data, consumed);
+            transcode.carry_len += consumed;
+            if (transcode.carry_len == unit) {
+                if (transcode_emit(out, transcode_samples(transcode.carry, unit / 2, out)) < 0) {
+                    return -1;
+                }
+                transcode.carry_len = 0;
+            }
+        } else {
+            uint32_t samples = (avail / unit) * (unit / 2);
+            if (samples > max_samples) {
+                samples = max_samples;
+            }
+            if (transcode_emit(out, transcode_samples(data, samples, out)) < 0) {
+                return -1;
+            }
+            consumed = samples * 2;
+        }
+
+        data += consumed;
+        size -= consumed;
+        transcode.data_remaining -= consumed;
+    }
+
+    if (transcode.state == TRANSCODE_DATA && transcode.data_remaining == 0) {
+        /* PACKED12 홀수 샘플 끝: 마지막 샘플은 2바이트 */
+        if (transcode.format == WAV_NATIVE_PACKED12 && transcode.carry_len == 2) {
+            out[0] = transcode.carry[0];
+            out[1] = transcode.carry[1] & 0x0F;
+            if (transcode_emit(out, 2) < 0) {
+                return -1;
+            }
+        }
+        transcode.carry_len = 0;
+        transcode.state = TRANSCODE_DONE;
+    }
+    return 0;
+}
+
+void wav_transcode_init(WAV_NativeFormat_t format, WAV_TranscodeOutput_t output)
+{
+    transcode.state = (format == WAV_NATIVE_NONE) ? TRANSCODE_PASSTHROUGH : TRANSCODE_HEADER;
+    transcode.format = format;
+    transcode.output = output;
+    transcode.sample_rate = 0;
+    transcode.data_remaining = 0;
+    transcode.output_bytes = 0;
+    transcode.carry_len = 0;
+    transcode.header_len = 0;
+}
+
+int wav_transcode_input(const uint8_t *data, uint32_t size)
+{
+    if (transcode.state == TRANSCODE_HEADER) {
+        uint32_t n = WAV_TRANSCODE_HEADER_MAX - transcode.header_len;
+        if (n > size) {
+            n = size;
+        }
+        memcpy(&transcode.header[transcode.header_len], data, n);
+        transcode.header_len += n;
+        data += n;
+        size -= n;
+
+        uint32_t data_start = 0;
+        int parsed = transcode_parse_header(&data_start);
+        if (parsed == 0 && transcode.header_len < WAV_TRANSCODE_HEADER_MAX) {
+            return 0;
+        }
+
+        if (parsed <= 0) {
+            printf("[WARN] WAV transcode: not 16-bit mono PCM, storing as-is\r\n");
+            transcode.state = TRANSCODE_PASSTHROUGH;
+            if (transcode_emit(transcode.header, transcode.header_len) < 0) {
+                return -1;
+            }
+        } else {
+            printf("[DEBUG] WAV transcode: %lu Hz, %lu samples -> %s\r\n",
+                   transcode.sample_rate, transcode.data_remaining / 2,
+                   (transcode.format == WAV_NATIVE_PACKED12) ? "PACKED12" : "PCM12");
+            transcode.state = TRANSCODE_DATA;
+            if (transcode_emit_header() < 0 ||
+                transcode_data(&transcode.header[data_start], transcode.header_len - data_start) < 0) {
+                return -1;
+            }
+        }
+    }
+
+    if (size == 0) {
+        return 0;
+    }
+
+    switch (transcode.state) {
+    case TRANSCODE_PASSTHROUGH:
+        return transcode_emit(data, size);
+    case TRANSCODE_DATA:
+        return transcode_data(data, size);
+    default:
+        return 0;
+    }
+}
+
+int wav_transcode_finish(void)
+{
+    /* 헤더 크기보다 짧은 파일 */
+    if (transcode.state == TRANSCODE_HEADER) {
+        transcode.state = TRANSCODE_PASSTHROUGH;
+        return transcode_emit(transcode.header, transcode.header_len);
+    }
+    return 0;
+}
+
+uint32_t wav_transcode_output_size(void)
+{
+    if (transcode.state != TRANSCODE_DATA && transcode.state != TRANSCODE_DONE) {
+        return 0;
+    }
+    return transcode.output_bytes;
+}
+
+/* ---------------------------------------------------------------------------
+ * 포맷별 벤치마크 (WAVBENCH)
+ * ------------------------------------------------------------------------- */
+
+#define WAV_BENCH_RATE          32000
+#define WAV_BENCH_WRITE_SIZE    8192                            // sdmmc1_buffer 앞쪽: 기록 누적
+#define WAV_BENCH_SAMPLES       2048                            // sdmmc1_buffer 뒤쪽: 재생 읽기 (AUDIO_BUFFER_SAMPLES)
+#define WAV_BENCH_PATTERN(i)    ((uint16_t)(((i) * 37U) & 0x0FFF))
+
+/* 벤치마크 파일 핸들 (FIL 4KB 이상, .bss 여유가 없어 RAM_D2에 배치) */
+static struct {
+    WAV_FileInfo_t wav;
+    uint32_t fill;              // sdmmc1_buffer에 누적된 기록 데이터
+} bench __attribute__((section(".ram_d2")));
+
+/* 변환 출력 → 8KB씩 f_write (스택 버퍼는 SD DMA 대상이 될 수 없으므로 sdmmc1_buffer에 누적) */
+static int bench_output(const uint8_t *data, uint32_t size)
+{
+    while (size > 0) {
+        uint32_t n = WAV_BENCH_WRITE_SIZE - bench.fill;
+        if (n > size) {
+            n = size;
+        }
+        memcpy(&sdmmc1_buffer[bench.fill], data, n);
+        bench.fill += n;
+        data += n;
+        size -= n;
+
+        if (bench.fill == WAV_BENCH_WRITE_SIZE) {
+            UINT written;
+            if (f_write(&bench.wav.file, sdmmc1_buffer, bench.fill, &written) != FR_OK || written != bench.fill) {
+                return -1;
+            }
+            bench.fill = 0;
+        }
+    }
+    return 0;
+}
+
+/* 합성 16비트 WAV를 format으로 변환해 기록, 반환값: 소요 시간 (ms), 실패 시 0 */
+static uint32_t bench_write(const char *path, WAV_NativeFormat_t format, uint32_t samples)
+{
+    uint8_t chunk[WAV_TRANSCODE_CHUNK];
+    uint32_t start = HAL_GetTick();
+    int result = 0;
+
+    if (f_open(&bench.wav.file, path, FA_CREATE_ALWAYS | FA_WRITE) != FR_OK) {
+        return 0;
+    }
+    bench.fill = 0;
+    wav_transcode_init(format, bench_output);
+
+    /* 업로드와 같은 16비트 PCM 모노 WAV 헤더 */
+    memcpy(chunk, "RIFF", 4);
+    write_le32(chunk + 4, 36 + samples * 2);
+    memcpy(chunk + 8, "WAVEfmt ", 8);
+    write_le32(chunk + 16, 16);
+    write_le16(chunk + 20, 1);
+    write_le16(chunk + 22, 1);
+    write_le32(chunk + 24, WAV_BENCH_RATE);
+    write_le32(chunk + 28, WAV_BENCH_RATE * 2);
+    write_le16(chunk + 32, 2);
+    write_le16(chunk + 34, 16);
+    memcpy(chunk + 36, "data", 4);
+    write_le32(chunk + 40, samples * 2);
+    result = wav_transcode_input(chunk, WAV_CANONICAL_HEADER_SIZE);
+
+    for (uint32_t i = 0; i < samples && result == 0; ) {
+        uint32_t n = samples - i;
+        if (n > sizeof(chunk) / 2) {
+            n = sizeof(chunk) / 2;
+        }
+        for (uint32_t j = 0; j < n; j++) {
+            write_le16(&chunk[2 * j], WAV_BENCH_PATTERN(i + j));
+        }
+        result = wav_transcode_input(chunk, n * 2);
+        i += n;
+    }
+
+    if (result == 0) {
+        result = wav_transcode_finish();
+    }
+    if (result == 0 && bench.fill > 0) {
+        UINT written;
+        if (f_write(&bench.wav.file, sdmmc1_buffer, bench.fill, &written) != FR_OK || written != bench.fill) {
+            result = -1;
+        }
+    }
+    if (f_close(&bench.wav.file) != FR_OK) {
+        result = -1;
+    }
+
+    uint32_t elapsed = HAL_GetTick() - start;
+    return (result == 0) ? (elapsed ? elapsed : 1) : 0;
+}
+
+int wav_benchmark(const char *path, uint32_t seconds, char *report, uint32_t report_size)
+{
+    static const struct {
+        WAV_NativeFormat_t format;
+        const char *name;
+    } formats[] = {
+        { WAV_NATIVE_NONE,     "PCM16" },
+        { WAV_NATIVE_PCM12,    "PCM12" },
+        { WAV_NATIVE_PACKED12, "PACK12" },
+    };
+    uint16_t *samples_buf = (uint16_t *)&sdmmc1_buffer[WAV_BENCH_WRITE_SIZE];
+    uint32_t samples = seconds * WAV_BENCH_RATE;
+    uint32_t len = 0;
+
+    report[0] = '\0';
+
+    for (uint32_t f = 0; f < sizeof(formats) / sizeof(formats[0]); f++) {
+        uint32_t write_ms = bench_write(path, formats[f].format, samples);
+        if (write_ms == 0) {
+            snprintf(&report[len], report_size - len, "%s: write failed\r\n", formats[f].name);
+            f_unlink(path);
+            return -1;
+        }
+
+        /* 재생과 같은 경로: wav_open() + AUDIO_BUFFER_SAMPLES 단위 wav_read_samples() */
+        if (wav_open(&bench.wav, path) != FR_OK) {
+            snprintf(&report[len], report_size - len, "%s: open failed\r\n", formats[f].name);
+            f_unlink(path);
+            return -1;
+        }
+        uint32_t file_size = (uint32_t)f_size(&bench.wav.file);
+        uint32_t start = HAL_GetTick();
+        uint64_t cycles = 0;
+        uint32_t total = 0;
+        uint32_t mismatches = 0;
+        FRESULT res = FR_OK;
+
+        while (res == FR_OK) {
+            uint32_t got = 0;
+            uint32_t t0 = DWT->CYCCNT;
+            res = wav_read_samples(&bench.wav, samples_buf, WAV_BENCH_SAMPLES, &got);
+            cycles += DWT->CYCCNT - t0;
+            if (got == 0) {
+                break;
+            }
+            for (uint32_t i = 0; i < got; i++) {
+                if (samples_buf[i] != WAV_BENCH_PATTERN(total + i)) {
+                    mismatches++;
+                }
+            }
+            total += got;
+        }
+        uint32_t read_ms = HAL_GetTick() - start;
+        wav_close(&bench.wav);
+        f_unlink(path);
+
+        if (res != FR_OK || total != samples || mismatches != 0) {
+            snprintf(&report[len], report_size - len, "%s: read back %lu/%lu samples, %lu mismatches\r\n",
+                     formats[f].name, total, samples, mismatches);
+            return -1;
+        }
+
+        /* SD 바이트/오디오 1초, 읽기(변환 포함) 사이클/샘플, 실시간 대비 읽기 속도 */
+        int n = snprintf(&report[len], report_size - len,
+                         "%-6s %6lu B/s  file %lu B  write %lu ms  read %lu ms  %lu cyc/sample  %lux realtime\r\n",
+                         formats[f].name, (uint32_t)((uint64_t)file_size / seconds), file_size,
+                         write_ms, read_ms, (uint32_t)(cycles / samples),
+                         read_ms ? (seconds * 1000) / read_ms : seconds * 1000);
+        if (n < 0 || (uint32_t)n >= report_size - len) {
+            return 0;
+        }
+        len += n;
+    }
+
+    return 0;
+}
@@ -9,7 +9,12 @@
 #include "ansi_colors.h"
 #include "usbd_cdc_if.h"  // USB CDC 지원
 #include "user_def.h"     // sdmmc1_buffer 사용
-#include "bsp_driver_sd.h"  // BSP_SD_GetCardState() 사용
+#include "fatfs.h"           // SD_SetWriteBehind() (ping-pong 스테이징)
+#include "crc_engine.h"     // CRC-16 (slice-by-8 / HW)
+#include "cdc_rx_crc.h"     // USB 수신 인터럽트의 패킷 경계 추적 + CRC 누적
+#include "lz4_stream.h"     // LZ4 압축 업로드
+#include "wav_parser.h"     // 업로드 시 재생 포맷 변환
+#include "delta_sync.h"     // 차등 업로드 (블록 서명 + 리터럴/블록 참조 스트림)
 #include <string.h>
 
 // SD 카드 쓰기 최적화 설정
@@ -18,562 +23,2893 @@
 // 실제 측정 결과: 8KB가 32KB보다 빠름 (SD 카드 내부 처리 특성)
 #define SD_WRITE_BUFFER_SIZE  8192  // 8KB = 512 * 16
 
-// Y-MODEM 패킷 버퍼 (DMA-safe 메모리에 배치 - SD 카드 MDMA 일관성 보장)
+// Ping-pong 스테이징: sdmmc1_buffer를 8KB 단위 2개로 나눠 사용
+// 한쪽이 SD DMA로 쓰이는 동안 다른 쪽에 수신 패킷을 채움 (SD 프로그래밍 시간을 USB 수신 뒤로 숨김)
+// SD 드라이버 write-behind 모드: f_write()는 DMA 시작 후 반환, 다음 디스크 접근 시 완료 확인
+#define SD_STAGING_COUNT      2
+
+// Y-MODEM 페이로드 버퍼 (DMA-safe 메모리에 배치 - SD 카드 MDMA 일관성 보장)
 // RAM_D2 사용 (SD MDMA 전용 영역, USB DMA와 공유)
+// 기대 블록은 스테이징 버퍼에 직접 수신하고, 블록 0/중복/순서 어긋난 블록만 여기에 수신
+// (착지하지 못한 확장 블록은 1KB씩 여기로 읽어 버림)
 __attribute__((section(".ram_d2")))
 __attribute__((aligned(32)))
-static uint8_t ymodem_packet_buffer[YMODEM_PACKET_SIZE + 5];  // STX + BLK + ~BLK + DATA + CRC
+static uint8_t ymodem_packet_buffer[YMODEM_PACKET_SIZE];
+
+// 수신 패킷 (헤더/CRC는 구조체에, 페이로드는 착지 위치에 직접)
+typedef struct {
+    uint8_t header;         // SOH / STX / LBLK / EOT / CAN
+    uint8_t blk;            // 블록 번호
+    uint8_t blk_inv;        // 블록 번호 보수
+    uint8_t crc[4];         // CRC-16 (2바이트) 또는 CRC-32 (LBLK, 4바이트), MSB 먼저
+    uint16_t data_size;     // 128, 1024 또는 8192
+    uint8_t *payload;       // 페이로드 위치 (스테이징 버퍼 또는 ymodem_packet_buffer, 버린 확장 블록은 NULL)
+} YmodemPacket_t;
+
+// 한 번의 ymodem_poll()에서 처리할 최대 패킷 수 (메인 루프 1회 처리 시간 제한)
+// 8 x 1KB = SD 스테이징 버퍼 1개 (f_write 최대 1회), 확장 블록은 1개 처리 후 반환
+#define YMODEM_POLL_MAX_PACKETS  8
+
+// 수신 상태
+typedef enum {
+    YMODEM_STATE_IDLE = 0,          // 전송 없음
+    YMODEM_STATE_HANDSHAKE,         // 'C'/'G'/'W' 전송, 블록 0 대기
+    YMODEM_STATE_DATA,              // 데이터 패킷 수신
+    YMODEM_STATE_SEND               // 송신 (DOWNLOAD, 단계는 send_phase)
+} YmodemState_t;
+
+// 송신 단계
+typedef enum {
+    SEND_WAIT_START = 0,            // 수신측 'C' 대기 → 블록 0 전송
+    SEND_HEADER,                    // 블록 0 ACK 대기
+    SEND_WAIT_DATA,                 // 데이터 시작 'C' 대기
+    SEND_DATA,                      // 데이터 블록 ACK 대기
+    SEND_EOT,                       // EOT 응답 대기 (NAK → EOT 재전송, ACK → 종료 블록)
+    SEND_WAIT_END,                  // 'C' 대기 → 빈 블록 0 전송
+    SEND_END                        // 빈 블록 0 ACK 대기
+} YmodemSendPhase_t;
+
+// 수신 세션 상태 (프로토콜 + 파일 + SD 스테이징)
+// FIL은 4KB 이상이므로 스택 대신 정적 영역에 배치
+// ymodem_poll() 호출 사이에 유지되어야 하는 모든 상태를 보관
+typedef struct {
+    YmodemState_t state;
+    YmodemResult_t result;          // 마지막 전송 결과 (IDLE 상태에서 반환)
+    UART_HandleTypeDef *huart;      // NULL이면 USB CDC (link가 있으면 link)
+    const YmodemLink_t *link;       // USB CDC 대체 링크 (YSIM), 세션 종료 시 해제
+    bool streaming;                 // Y-MODEM-G
+    bool windowed;                  // 슬라이딩 윈도우
+    bool compressed;                // 데이터 블록이 LZ4 프레임 (해제 후 스테이징)
+    WAV_NativeFormat_t transcode;   // 수신 중 WAV 변환 포맷 (WAV_NATIVE_NONE이면 그대로 스테이징)
+    bool delta;                     // 차등 업로드 (path는 임시 파일 "<대상>.dsy", delta_basis는 기존 파일)
+    bool delta_ack_pending;         // 블록 참조 복사가 남아 마지막 패킷 ACK 보류 중
+    bool large_blocks;              // 확장 블록(LBLK) 허용
+    bool rx_tracked;                // USB 수신 인터럽트가 패킷 경계 추적 (USB CDC, 대체 링크 제외)
+    bool rx_crc;                    // 추적 기록의 CRC-16 사용 (YMODEM_OPT_RX_CRC)
+    uint32_t rx_header_pos;         // 현재 패킷 헤더의 CDC 스트림 위치 (추적 기록 조회)
+    uint8_t handshake;              // 'C' / 'G' / 'W'
+    uint8_t handshake_retries;      // 핸드셰이크 문자 전송 횟수
+    uint32_t handshake_start_tick;  // 핸드셰이크 시작 시각 (YMODEM_HANDSHAKE_TIMEOUT_MS 기준)
+    uint8_t packet_number;          // 기대 블록 번호
+    uint8_t timeout_retries;
+    uint8_t nak_retries;
+    uint32_t wait_start_tick;       // 현재 패킷 대기 시작 시각 (타임아웃 기준)
+    uint32_t holdoff_until;         // 이 시각까지 수신 보류 (HAL_Delay 대체)
+    bool rx_header_pending;         // 헤더만 읽고 나머지 도착 대기 중
+    bool rx_blk_known;              // 재동기화에서 BLK/~BLK까지 읽음
+    uint32_t rx_header_tick;        // 헤더 수신 시각
+    uint32_t rx_header_cycles;      // 헤더 수신 시각 (DWT, PAYLOAD 측정)
+    bool reply_armed;               // 다음 헤더 도착 시 REPLY 측정 (정상 처리 직후만)
+    uint32_t reply_mark;            // REPLY 측정 기준 시각 (DWT, 수신 보류가 끝난 시점)
+    uint32_t rx_last_count;         // 마지막으로 확인한 수신 대기 바이트 수 (USB CDC)
+    uint32_t rx_last_tick;          // 수신 바이트가 마지막으로 늘어난 시각 (링크 조용함 판정)
+    bool resync;                    // 재동기화 중 (헤더 후보를 찾을 때까지 바이트 버림)
+    uint8_t resync_window[3];       // 최근 읽은 3바이트 (헤더 후보)
+    uint8_t resync_fill;            // resync_window에 채워진 바이트 수
+    uint32_t resync_consumed;       // 이번 재동기화에서 읽은 바이트 수
+    uint32_t resync_count;          // 재동기화 횟수 (전송 단위)
+    uint32_t resync_discarded;      // 재동기화로 버린 바이트 수
+    YmodemPacket_t pkt;             // 수신 중인 패킷
+    bool batch;                     // 배치 전송 (블록 0 파일명으로 경로 결정)
+    uint32_t files_received;        // 완료된 파일 수
+    bool file_open;
+    bool preallocated;              // f_expand()로 연속 클러스터 확보됨
+    uint32_t expected_size;         // 블록 0에 명시된 파일 크기 (0이면 미지정)
+    uint32_t resume_offset;         // 재개 시작 위치 (새 파일이면 0)
+    uint32_t synced_offset;         // 마지막 f_sync() 위치 (SD에 확정된 크기)
+    bool progress_enabled;          // 진행 기록 파일 사용 (벤치마크는 사용 안 함)
+    uint32_t digest;                // SD에 쓴 데이터의 CRC-32 (파일 처음부터)
+    bool digest_valid;              // 재개 시 이전 CRC를 알 수 없으면 false (다이제스트 기록 안 함)
+    uint32_t start_tick;            // 데이터 단계 시작 시각 (처리량 측정)
+    char path[YMODEM_PATH_MAX];     // 현재 수신 파일 경로
+    FIL file;                       // 수신 파일
+    uint32_t write_buffer_offset;   // 현재 스테이징 버퍼에 쌓인 데이터 크기
+    uint8_t stage_index;            // 현재 채우는 스테이징 버퍼 (0 ~ SD_STAGING_COUNT-1)
+    uint32_t total_bytes;           // 파일에 반영된 총 데이터 크기
+    uint32_t copy_bytes;            // 페이로드 CPU 복사량 (USB→링 버퍼, 수신 버퍼→착지, 착지→스테이징)
+    uint32_t wire_bytes;            // 링크로 받은 데이터 블록 페이로드 (압축 업로드 비율 계산)
+    YmodemSendPhase_t send_phase;   // 송신 단계
+    uint32_t send_len[SD_STAGING_COUNT];  // 읽기 선행 버퍼별 유효 데이터 (0이면 빈 버퍼)
+    uint8_t send_index;             // 송신 중인 버퍼
+    uint32_t send_pos;              // 송신 중인 버퍼 안의 현재 블록 위치
+    uint16_t send_packet_len;       // 마지막으로 보낸 데이터 블록 크기 (ACK 시 전진)
+    bool send_eof;                  // 파일 끝까지 읽음
+    bool send_timed;                // 마지막 블록이 첫 전송 (재전송이면 ACK 측정 안 함)
+    uint32_t send_mark;             // 데이터 블록 전송 시각 (DWT)
+    uint32_t stat_ready;            // 다음 패킷 수신 준비 시각 (DWT, 헤더 대기 측정 기준)
+    uint32_t stat_header;           // 헤더 도착 시각 (DWT)
+    uint32_t stat_holdoff;          // 수신 보류 시작 시각 (DWT)
+    bool stat_holdoff_active;
+    bool stat_packet_done;          // 이번 poll_data()에서 패킷 1개 처리됨
+} YmodemSession_t;
+
+static YmodemSession_t session;
+
+// 진행 기록 파일 ("<경로>.ymp") 내용
+// 리셋 후 재개 시 committed까지는 SD에 확정된 데이터로 간주
+// (사전 할당 때문에 파일 크기만으로는 수신 위치를 알 수 없음)
+#define YMODEM_PROGRESS_MAGIC  0x504D5959  // "YYMP"
+
+typedef struct {
+    uint32_t magic;
+    uint32_t committed;             // f_sync() 완료된 바이트 수
+    uint32_t declared_size;         // 블록 0에 명시된 파일 크기
+    uint32_t digest;                // committed까지의 CRC-32
+    uint32_t digest_valid;          // 0이면 digest 사용 불가
+} YmodemProgress_t;
+
+// 다이제스트 파일 ("<경로>.crc") 내용
+#define YMODEM_DIGEST_MAGIC  0x53435959    // "YYCS"
+
+typedef struct {
+    uint32_t magic;
+    uint32_t size;                  // 파일 크기
+    uint32_t crc;                   // 파일 전체 CRC-32
+} YmodemDigest_t;
+
+static FIL progress_file;
+
+// 현재 채우는 스테이징 버퍼
+#define STAGING_BUFFER()  (&sdmmc1_buffer[session.stage_index * SD_WRITE_BUFFER_SIZE])
+
+// 송신 읽기 선행 버퍼 (수신 스테이징과 같은 영역, 송신/수신은 동시에 하지 않음)
+#define SEND_BUFFER(i)    (&sdmmc1_buffer[(i) * SD_WRITE_BUFFER_SIZE])
+
+// 차등 업로드 기존 파일 읽기 버퍼 (스테이징 뒤쪽 8KB, 32바이트 정렬 → 멀티 블록 DMA로 바로 읽음)
+#define DELTA_READ_BUFFER (&sdmmc1_buffer[SD_STAGING_COUNT * SD_WRITE_BUFFER_SIZE])
+
+// 차등 업로드 기존 파일 (블록 참조 복사 원본, 서명 생성)
+// FIL은 4KB 이상이고 .bss 여유가 없어 RAM_D2에 배치
+__attribute__((section(".ram_d2")))
+static FIL delta_basis;
+
+// 송신 프레임: [SOH|STX][BLK][~BLK][DATA 128/1024][CRC 2]
+static uint8_t send_frame[3 + YMODEM_PACKET_SIZE + 2];
+
+// 마지막 업로드 처리량 (다운로드 처리량과 비교 출력)
+static uint32_t last_upload_kbps;
+
+// 구간 통계: 최소/평균/최대 + 2의 거듭제곱 us 히스토그램
+// 빈 0: 1us 미만, 빈 k: 2^(k-1) ~ 2^k-1 us, 마지막 빈: 16ms 이상
+#define YMODEM_STATS_BINS  16
+
+typedef struct {
+    uint32_t count;
+    uint32_t min;                   // 사이클
+    uint32_t max;                   // 사이클
+    uint64_t total;                 // 사이클
+    uint32_t hist[YMODEM_STATS_BINS];
+} PhaseStats_t;
+
+static PhaseStats_t phase_stats[YMODEM_PHASE_COUNT];
+static uint32_t stats_cycles_per_us = 1;
+
+static const char *const phase_names[YMODEM_PHASE_COUNT] = {
+    "WAIT_HDR", "PAYLOAD", "CRC", "COPY", "F_WRITE", "SD_READY", "ACK_TX", "DELAY", "LAST2ACK"
+};
+
+// 적응 타임아웃 추정치 (세션 사이에 유지)
+typedef struct {
+    uint32_t samples;
+    uint32_t srtt_us;
+    uint32_t rttvar_us;
+    uint32_t last_us;
+    uint32_t max_us;
+} RttEstimator_t;
+
+static RttEstimator_t estimators[YMODEM_EST_COUNT];
+
+static const char *const estimator_names[YMODEM_EST_COUNT] = {
+    "REPLY", "PAYLOAD", "ACK", "SD"
+};
+
+#if YMODEM_PHASE_STATS
+#define STATS_NOW()                 (DWT->CYCCNT)
+#define STATS_ADD(phase, start)     stats_add((phase), DWT->CYCCNT - (start))
+#else
+#define STATS_NOW()                 0
+#define STATS_ADD(phase, start)     ((void)(start))
+#endif
+
+// 슬라이딩 윈도우 재정렬 슬롯 (기대 블록보다 앞서 도착한 패킷 보관)
+// 슬롯 인덱스 = 블록 번호 % YMODEM_WINDOW_SIZE (윈도우 안에서는 중복 없음)
+typedef struct {
+    bool valid;
+    uint8_t blk;
+    uint16_t size;
+    uint8_t data[YMODEM_PACKET_SIZE];
+} WindowSlot_t;
+
+static WindowSlot_t window_slots[YMODEM_WINDOW_SIZE];
+static uint8_t window_last_acked;     // 마지막으로 누적 ACK한 블록 번호
+static uint8_t window_nak_blk;        // 마지막으로 NAK 요청한 블록 번호
+static bool window_nak_sent;          // 현재 누락 블록에 대해 NAK 전송 여부
 
 // 내부 함수
-static uint16_t crc16(const uint8_t *data, uint16_t length);
-static HAL_StatusTypeDef receive_packet(UART_HandleTypeDef *huart, uint8_t *buffer,
-                                        uint16_t *length, uint32_t timeout);
+static YmodemResult_t poll_handshake(void);
+static YmodemResult_t poll_data(void);
+static YmodemResult_t finish_session(YmodemResult_t result);
+static YmodemResult_t open_file(const char *file_path, uint32_t resume_offset);
+static void close_file(bool complete);
+static void progress_path(const char *file_path, char *path, uint32_t path_size);
+static void save_progress(uint32_t committed);
+static void save_digest(uint32_t size);
+static void digest_update(uint32_t pos, const uint8_t *data, uint32_t size);
+static bool load_progress(const char *file_path, YmodemProgress_t *progress);
+static bool batch_resolve_path(const char *name, char *path, uint32_t path_size);
+static uint32_t parse_file_size(const uint8_t *payload, uint16_t size);
+static void preallocate_file(uint32_t size);
+static HAL_StatusTypeDef try_receive_packet(YmodemPacket_t *pkt, uint8_t landing_blk,
+                                            uint8_t *landing, uint32_t landing_room);
+static HAL_StatusTypeDef receive_bytes(UART_HandleTypeDef *huart, uint8_t *buffer, uint16_t length);
+static bool read_byte_nowait(uint8_t *byte);
+static bool header_data_size(uint8_t header, uint16_t *size);
+static void resync_start(uint8_t first);
+static HAL_StatusTypeDef resync_scan(YmodemPacket_t *pkt);
+static uint32_t link_available(void);
+static uint32_t link_read(uint8_t *data, uint32_t length);
 static HAL_StatusTypeDef transmit_byte(UART_HandleTypeDef *huart, uint8_t data);
-
-// Y-MODEM 수신 (파일 저장)
+static HAL_StatusTypeDef transmit_frame(UART_HandleTypeDef *huart, const uint8_t *data, uint16_t len);
+static void cancel_transfer(UART_HandleTypeDef *huart);
+static YmodemResult_t consume_payload(const uint8_t *data, uint16_t size);
+static int stage_output(const uint8_t *data, uint32_t size);
+static YmodemResult_t delta_open(const char *file_path);
+static YmodemResult_t delta_finish(YmodemResult_t result);
+static int delta_input(const uint8_t *data, uint32_t size);
+static int delta_copy(uint32_t offset, uint32_t size);
+static bool delta_paused(void);
+static YmodemResult_t delta_resume(void);
+static YmodemResult_t poll_delta_copy(void);
+static YmodemResult_t ack_data_packet(const CdcRxPacket_t *rx_record);
+static YmodemResult_t stage_payload(const uint8_t *data, uint16_t size);
+static YmodemResult_t poll_send(void);
+static YmodemResult_t send_next(void);
+static YmodemResult_t send_refill(uint8_t index);
+static HAL_StatusTypeDef send_block(uint8_t blk, const uint8_t *data, uint32_t len, uint8_t pad);
+static HAL_StatusTypeDef send_header(bool last);
+static HAL_StatusTypeDef send_resend(void);
+static bool receive_response(uint8_t *byte);
+static HAL_StatusTypeDef transmit_frame_raw(UART_HandleTypeDef *huart, const uint8_t *data, uint16_t len);
+static void hold_off(uint32_t ms);
+static void stats_add(YmodemPhase_t phase, uint32_t cycles);
+static void stats_write_done(uint32_t write_start);
+static void rtt_sample(YmodemEstimator_t est, uint32_t cycles);
+static uint32_t rtt_timeout_ms(YmodemEstimator_t est, uint32_t scale_bytes, uint8_t backoff);
+static uint32_t rtt_retry_delay_ms(YmodemEstimator_t est, uint8_t backoff);
+static void reply_arm(void);
+static YmodemResult_t flush_staging_final(void);
+static YmodemResult_t truncate_to_exact_size(void);
+static void window_reset(uint8_t last_acked);
+static bool window_has_pending(void);
+static bool window_short_of_declared(void);
+static void window_send_response(UART_HandleTypeDef *huart, uint8_t code, uint8_t blk);
+static YmodemResult_t window_receive(UART_HandleTypeDef *huart, uint8_t blk, const uint8_t *data,
+                                     uint16_t size, uint8_t *expected);
+
+// Y-MODEM 수신 시작 (비차단)
 // huart가 NULL이면 USB CDC 사용
-YmodemResult_t ymodem_receive(UART_HandleTypeDef *huart, const char *file_path)
+// mode가 YMODEM_MODE_G이면 Y-MODEM-G 스트리밍 (USB CDC에서만 허용)
+// mode가 YMODEM_MODE_WINDOW이면 슬라이딩 윈도우 + 누적 ACK (USB CDC에서만 허용)
+// 반환값: YMODEM_BUSY (시작됨, 이후 ymodem_poll() 반복 호출) 또는 에러 코드
+YmodemResult_t ymodem_start(UART_HandleTypeDef *huart, const char *file_path, YmodemMode_t mode)
+{
+    return ymodem_start_ex(huart, file_path, mode, 0, 0);
+}
+
+// Y-MODEM 수신 시작 (재개/압축 옵션, 비차단)
+// offset > 0이면 기존 파일을 열어 offset 위치부터 이어서 기록 (ymodem_resume_offset() 값)
+// YMODEM_OPT_LZ4: 데이터 블록을 LZ4 프레임으로 해제하면서 기록 (파일마다 새 프레임)
+// YMODEM_OPT_LARGE_BLOCKS: 8KB 확장 블록 + CRC-32 수신 (USB CDC, 윈도우/LZ4와 함께 사용 불가)
+// YMODEM_OPT_RX_CRC: CRC-16을 USB 수신 인터럽트에서 미리 계산 (USB CDC)
+// YMODEM_OPT_NATIVE_PCM12/PACKED12: 16비트 WAV를 재생 포맷으로 변환하면서 기록 (재개/확장 블록 불가)
+// YMODEM_OPT_DELTA: 차등 스트림으로 기존 파일과 리터럴에서 새 파일 재구성 (단일 파일, 표준 모드)
+// offset == 0, options == 0이면 ymodem_start()와 동일
+YmodemResult_t ymodem_start_ex(UART_HandleTypeDef *huart, const char *file_path,
+                               YmodemMode_t mode, uint32_t offset, uint32_t options)
 {
-    FIL file;
-    FRESULT fres;
-    uint8_t *packet_buffer = ymodem_packet_buffer;  // DMA-safe 글로벌 버퍼 사용
-    uint16_t packet_length;
-    uint8_t packet_number = 0;
-    uint32_t total_bytes = 0;
-    YmodemResult_t result = YMODEM_OK;
     bool using_cdc = (huart == NULL);
 
-    // SD 카드 쓰기 버퍼링 (sdmmc1_buffer 재사용, 32KB 크기)
-    uint32_t write_buffer_offset = 0;  // 현재 버퍼에 쌓인 데이터 크기
+    if (session.state != YMODEM_STATE_IDLE) {
+        printf("[ERROR] Y-MODEM: transfer already in progress\r\n");
+        return YMODEM_ERROR;
+    }
+
+    // Y-MODEM-G는 에러 복구가 없으므로 무손실 링크(USB CDC)에서만 사용
+    // 윈도우 모드는 ACK 대기 중에도 수신이 계속되어야 하므로 링 버퍼가 있는 USB CDC 필요
+    if (mode != YMODEM_MODE_STANDARD && !using_cdc) {
+        printf("[WARN] Y-MODEM mode %d requires USB CDC, falling back to standard mode\r\n", mode);
+        mode = YMODEM_MODE_STANDARD;
+    }
+    session.huart = huart;
+    session.streaming = (mode == YMODEM_MODE_G);
+    session.windowed = (mode == YMODEM_MODE_WINDOW);
+    session.handshake = session.streaming ? YMODEM_G : (session.windowed ? YMODEM_WINDOW : YMODEM_CRC16);
+
+    session.compressed = (options & YMODEM_OPT_LZ4) != 0;
+    session.large_blocks = (options & YMODEM_OPT_LARGE_BLOCKS) != 0;
+    session.transcode = (options & YMODEM_OPT_NATIVE_PACKED12) ? WAV_NATIVE_PACKED12 :
+                        (options & YMODEM_OPT_NATIVE_PCM12) ? WAV_NATIVE_PCM12 : WAV_NATIVE_NONE;
+    if (session.transcode != WAV_NATIVE_NONE && offset > 0) {
+        // 변환된 파일 위치와 원본 전송 위치가 다르므로 이어받을 수 없음
+        printf("[ERROR] Y-MODEM: transcoding cannot resume\r\n");
+        return YMODEM_ERROR;
+    }
+    // 차등 업로드: 블록 참조 복사 중에는 수신을 처리하지 않으므로 패킷마다 ACK를 기다리는 표준 모드만
+    session.delta = (options & YMODEM_OPT_DELTA) != 0;
+    if (session.delta && (file_path == NULL || offset > 0 || mode != YMODEM_MODE_STANDARD ||
+                          session.transcode != WAV_NATIVE_NONE)) {
+        printf("[ERROR] Y-MODEM: delta upload needs a single file in standard mode\r\n");
+        session.delta = false;
+        return YMODEM_ERROR;
+    }
+    if (session.large_blocks && (!using_cdc || session.windowed || session.compressed ||
+                                 session.transcode != WAV_NATIVE_NONE || session.delta)) {
+        printf("[WARN] Y-MODEM: 8KB blocks need USB CDC without W/LZ4/transcoding/delta, disabled\r\n");
+        session.large_blocks = false;
+    }
+    session.delta_ack_pending = false;
+    session.copy_bytes = 0;
+    session.resync = false;
+    session.resync_count = 0;
+    session.resync_discarded = 0;
+    ymodem_stats_reset();
+    session.batch = (file_path == NULL);
+    session.files_received = 0;
+    session.file_open = false;
+
+    // 단일 파일: 지정된 경로를 미리 생성
+    // 배치: 블록 0의 파일명으로 파일마다 경로 결정
+    // 차등 업로드: 기존 파일은 그대로 두고 임시 파일에 재구성
+    if (session.delta) {
+        if (delta_open(file_path) != YMODEM_OK) {
+            session.delta = false;
+            return YMODEM_ERROR;
+        }
+    } else if (!session.batch && open_file(file_path, offset) != YMODEM_OK) {
+        return YMODEM_ERROR;
+    }
+    if (offset > 0) {
+        printf("[DEBUG] Y-MODEM: resuming %s at %lu bytes\r\n", file_path, offset);
+
+        // 재개 위치가 진행 기록의 확정 위치와 같을 때만 이전 CRC에서 이어서 계산
+        YmodemProgress_t progress;
+        if (load_progress(file_path, &progress) && progress.committed == offset && progress.digest_valid) {
+            session.digest = progress.digest;
+            session.digest_valid = true;
+        } else {
+            printf("[WARN] Y-MODEM: no digest for resumed prefix, %s" YMODEM_DIGEST_SUFFIX " will not be written\r\n",
+                   file_path);
+        }
+    }
 
     // Y-MODEM 처리 시작 (UART TX 타이밍 보존을 위해)
     extern volatile uint8_t g_ymodem_active;
     g_ymodem_active = 1;
 
     // USB CDC 모드 활성화
-    if (using_cdc) {
+    // 패킷 경계 추적은 항상 (마지막 바이트 → ACK 측정), CRC 누적은 옵션일 때만
+    session.rx_tracked = using_cdc && session.link == NULL;
+    session.rx_crc = session.rx_tracked && (options & YMODEM_OPT_RX_CRC) != 0;
+    if (!session.rx_tracked && (options & YMODEM_OPT_RX_CRC)) {
+        printf("[WARN] Y-MODEM: receive-path CRC needs USB CDC, disabled\r\n");
+    }
+    if (session.rx_tracked) {
         CDC_Set_YModem_Mode(true);
+        cdc_rx_crc_configure(session.rx_crc, session.large_blocks);
     }
 
+    // 첫 번째 패킷 (파일 정보) 요청
+    // 표준 Y-MODEM 프로토콜: 'C' 문자를 1초마다 재전송 (최대 60회)
+    // Y-MODEM-G: 'C' 대신 'G'를 보내 스트리밍 모드 협상
+    // 윈도우 모드: 'W'를 보내 슬라이딩 윈도우 협상
+    printf("[DEBUG] Y-MODEM: waiting for sender (sending '%c' every 1 sec)...\r\n", session.handshake);
+
+    session.state = YMODEM_STATE_HANDSHAKE;
+    session.handshake_retries = 0;
+    session.handshake_start_tick = HAL_GetTick();
+    session.rx_header_pending = false;
+    session.reply_armed = false;
+    session.wait_start_tick = HAL_GetTick() - 1000;  // 첫 poll에서 즉시 핸드셰이크 문자 전송
+    session.holdoff_until = HAL_GetTick();
+    session.result = YMODEM_BUSY;
+
+    return YMODEM_BUSY;
+}
+
+// 수신 파일 생성 (상위 디렉토리 포함) 및 스테이징 초기화
+// resume_offset > 0이면 기존 파일을 열고 그 위치로 이동 (재개 전송)
+static YmodemResult_t open_file(const char *file_path, uint32_t resume_offset)
+{
     // 디렉토리 생성 (파일 경로에서 추출)
     // 예: /audio/ch0/file.wav -> /audio 생성, /audio/ch0 생성
-    char dir_path[256];
+    char dir_path[YMODEM_PATH_MAX];
     strncpy(dir_path, file_path, sizeof(dir_path) - 1);
     dir_path[sizeof(dir_path) - 1] = '\0';
 
-    char *last_slash = strrchr(dir_path, '/');
-    if (last_slash != NULL && last_slash != dir_path) {
-        *last_slash = '\0';  // 파일명 제거
-
-        // 상위 디렉토리 먼저 생성 (/audio)
-        char *second_slash = strrchr(dir_path, '/');
-        if (second_slash != NULL && second_slash != dir_path) {
-            char parent_dir[256];
-            strncpy(parent_dir, dir_path, second_slash - dir_path);
-            parent_dir[second_slash - dir_path] = '\0';
-
-            FRESULT mkdir_res = f_mkdir(parent_dir);
-            if (mkdir_res != FR_OK && mkdir_res != FR_EXIST) {
-                printf("[WARN] f_mkdir(%s) failed: fres=%d\r\n", parent_dir, mkdir_res);
-            }
-        }
-
-        // 하위 디렉토리 생성 (/audio/ch0)
+    for (char *slash = strchr(dir_path + 1, '/'); slash != NULL; slash = strchr(slash + 1, '/')) {
+        *slash = '\0';
         FRESULT mkdir_res = f_mkdir(dir_path);
         if (mkdir_res != FR_OK && mkdir_res != FR_EXIST) {
             printf("[WARN] f_mkdir(%s) failed: fres=%d\r\n", dir_path, mkdir_res);
         }
+        *slash = '/';
     }
 
     // 파일 열기
-    fres = f_open(&file, file_path, FA_CREATE_ALWAYS | FA_WRITE);
+    FRESULT fres = f_open(&session.file, file_path,
+                          (resume_offset > 0) ? (FA_OPEN_EXISTING | FA_WRITE) : (FA_CREATE_ALWAYS | FA_WRITE));
     if (fres != FR_OK) {
         printf("[ERROR] f_open(%s) failed: fres=%d\r\n", file_path, fres);
         uart_send_error(405, "Failed to create file");
-        g_ymodem_active = 0;
-        if (using_cdc) CDC_Set_YModem_Mode(false);
         return YMODEM_ERROR;
     }
 
-    // 첫 번째 패킷 (파일 정보) 요청
-    // 표준 Y-MODEM 프로토콜: 'C' 문자를 1초마다 재전송 (최대 60회)
-    printf("[DEBUG] Y-MODEM: waiting for sender (sending 'C' every 1 sec)...\r\n");
-
-    HAL_StatusTypeDef status = HAL_ERROR;
-    for (int retry = 0; retry < 60; retry++) {
-        // 'C' 문자 전송
-        if (transmit_byte(huart, YMODEM_CRC16) != HAL_OK) {
-            printf("[WARN] Y-MODEM: transmit_byte('C') failed, retry=%d\r\n", retry);
+    // 재개: 확정된 위치로 이동 (이후 기록은 512 정렬 위치에서 시작)
+    if (resume_offset > 0) {
+        fres = (f_size(&session.file) >= resume_offset) ? f_lseek(&session.file, resume_offset) : FR_INVALID_PARAMETER;
+        if (fres != FR_OK) {
+            printf("[ERROR] Resume seek to %lu failed: fres=%d (size=%lu)\r\n",
+                   resume_offset, fres, (uint32_t)f_size(&session.file));
+            f_close(&session.file);
+            uart_send_error(405, "Failed to resume file");
+            return YMODEM_ERROR;
         }
+    }
 
-        // USB 호스트가 'C'를 읽을 시간 제공
-        HAL_Delay(10);
+    strncpy(session.path, file_path, sizeof(session.path) - 1);
+    session.path[sizeof(session.path) - 1] = '\0';
+    session.file_open = true;
+    session.preallocated = false;
+    session.expected_size = 0;
+    session.resume_offset = resume_offset;
+    session.synced_offset = resume_offset;
+    session.progress_enabled = false;
+
+    // 내용이 바뀌므로 이전 다이제스트 삭제 (재개 시 이전 CRC는 ymodem_start_ex()에서 진행 기록으로 복원)
+    char digest_path[YMODEM_PATH_MAX + sizeof(YMODEM_DIGEST_SUFFIX)];
+    snprintf(digest_path, sizeof(digest_path), "%s" YMODEM_DIGEST_SUFFIX, file_path);
+    f_unlink(digest_path);
+    session.digest = 0;
+    session.digest_valid = (resume_offset == 0);
+
+    // SD 카드 쓰기 버퍼링 (sdmmc1_buffer 재사용, 8KB x 2 ping-pong)
+    session.write_buffer_offset = 0;
+    session.stage_index = 0;
+    session.total_bytes = resume_offset;
+    session.wire_bytes = 0;
+
+    return YMODEM_OK;
+}
+
+// 파일 닫기: f_sync() 후 f_close() (SD 카드 데이터 무결성 보장)
+// complete이면 진행 기록 삭제, 아니면 실제 기록된 위치를 진행 기록에 남김 (재개 가능)
+static void close_file(bool complete)
+{
+    FRESULT fres;
+
+    if (!session.file_open) {
+        return;
+    }
 
-        // 1초 동안 패킷 대기
-        status = receive_packet(huart, packet_buffer, &packet_length, 1000);
-        if (status == HAL_OK) {
-            printf("[DEBUG] Y-MODEM: first packet received after %d retries\r\n", retry);
-            break;  // 패킷 받음
+    // 미리 할당한 영역 중 쓰지 않은 부분 제거 (중단된 전송도 실제 기록된 크기로)
+    if (f_size(&session.file) > f_tell(&session.file)) {
+        fres = f_truncate(&session.file);
+        if (fres != FR_OK) {
+            printf("[WARN] f_truncate at %lu failed: fres=%d\r\n", (uint32_t)f_tell(&session.file), fres);
         }
     }
 
-    // 60초 타임아웃 체크
-    if (status != HAL_OK) {
-        f_close(&file);
-        transmit_byte(huart, YMODEM_CAN);
-        uart_send_error(501, "Y-MODEM timeout waiting for sender");
-        g_ymodem_active = 0;
-        if (using_cdc) CDC_Set_YModem_Mode(false);
-        return YMODEM_TIMEOUT;
+    fres = f_sync(&session.file);
+    if (fres != FR_OK) {
+        printf("[WARN] f_sync before close failed: fres=%d\r\n", fres);
     }
 
-    // 첫 번째 패킷 처리 (파일 정보 패킷)
-    uint8_t header = packet_buffer[0];
+    if (fres == FR_OK && session.progress_enabled && !complete) {
+        save_progress(f_tell(&session.file));
+    }
 
-    if (header == YMODEM_SOH || header == YMODEM_STX) {
-        // 파일 정보 패킷 검증
-        uint16_t data_size = (header == YMODEM_SOH) ? 128 : 1024;
-        uint8_t blk_num = packet_buffer[1];
-        uint8_t blk_num_inv = packet_buffer[2];
+    uint32_t final_size = (uint32_t)f_size(&session.file);
+    bool digest_ok = (fres == FR_OK && session.progress_enabled && complete && session.digest_valid);
 
-        // 블록 번호 확인 (첫 번째 패킷은 블록 0)
-        if (blk_num != 0 || blk_num != (uint8_t)(~blk_num_inv)) {
-            f_close(&file);
-            transmit_byte(huart, YMODEM_CAN);
-            uart_send_error(501, "Y-MODEM invalid file info packet");
-            g_ymodem_active = 0;
-            if (using_cdc) CDC_Set_YModem_Mode(false);
-            return YMODEM_ERROR;
-        }
+    fres = f_close(&session.file);
+    if (fres != FR_OK) {
+        printf("[ERROR] f_close failed: fres=%d\r\n", fres);
+    } else {
+        printf("[DEBUG] File closed successfully\r\n");
+    }
 
-        // CRC 확인
-        uint16_t crc_received = (packet_buffer[3 + data_size] << 8) |
-                                 packet_buffer[4 + data_size];
-        uint16_t crc_calculated = crc16(&packet_buffer[3], data_size);
+    if (session.progress_enabled && complete) {
+        char path[YMODEM_PATH_MAX + sizeof(YMODEM_PROGRESS_SUFFIX)];
+        progress_path(session.path, path, sizeof(path));
+        f_unlink(path);
+    }
 
-        if (crc_received != crc_calculated) {
-            f_close(&file);
-            transmit_byte(huart, YMODEM_CAN);
-            uart_send_error(501, "Y-MODEM CRC error in file info packet");
-            g_ymodem_active = 0;
-            if (using_cdc) CDC_Set_YModem_Mode(false);
-            return YMODEM_CRC_ERROR;
+    if (digest_ok && fres == FR_OK) {
+        save_digest(final_size);
+    }
+
+    session.file_open = false;
+    session.progress_enabled = false;
+}
+
+// 진행 기록 파일 경로: "<파일 경로>.ymp"
+static void progress_path(const char *file_path, char *path, uint32_t path_size)
+{
+    snprintf(path, path_size, "%s" YMODEM_PROGRESS_SUFFIX, file_path);
+}
+
+// 진행 기록 저장 (committed 바이트까지 SD에 확정됨)
+// 단일 섹터 쓰기이므로 write-behind 모드에서도 동기 처리됨
+static void save_progress(uint32_t committed)
+{
+    char path[YMODEM_PATH_MAX + sizeof(YMODEM_PROGRESS_SUFFIX)];
+    YmodemProgress_t progress = {
+        .magic = YMODEM_PROGRESS_MAGIC,
+        .committed = (session.transcode != WAV_NATIVE_NONE) ? 0 : committed,  // 변환 파일은 처음부터 다시
+        .declared_size = session.expected_size,
+        .digest = session.digest,
+        .digest_valid = session.digest_valid
+    };
+    UINT bytes_written = 0;
+
+    progress_path(session.path, path, sizeof(path));
+    FRESULT fres = f_open(&progress_file, path, FA_CREATE_ALWAYS | FA_WRITE);
+    if (fres == FR_OK) {
+        fres = f_write(&progress_file, &progress, sizeof(progress), &bytes_written);
+        FRESULT close_res = f_close(&progress_file);
+        if (fres == FR_OK) {
+            fres = close_res;
         }
+    }
 
-        // 파일 정보 패킷 ACK
-        transmit_byte(huart, YMODEM_ACK);
-        printf("[DEBUG] Y-MODEM: file info packet ACKed\r\n");
+    if (fres != FR_OK || bytes_written != sizeof(progress)) {
+        printf("[WARN] Progress save (%s, %lu) failed: fres=%d\r\n", path, committed, fres);
+    }
+}
 
-        // 주의: 표준 Y-MODEM에서는 여기서 'C'를 보내야 하지만,
-        // Python 구현이 'C'를 기다리지 않고 즉시 데이터 패킷을 보내므로
-        // 'C'를 보내면 Python이 ACK 대기 시 'C'를 읽어서 타임아웃됨
-        // 따라서 'C'를 보내지 않고 ACK만 보냄 (비표준이지만 Python 호환)
+// 다이제스트 저장 (수신 완료 후, 파일은 이미 닫힌 상태)
+static void save_digest(uint32_t size)
+{
+    char path[YMODEM_PATH_MAX + sizeof(YMODEM_DIGEST_SUFFIX)];
+    YmodemDigest_t digest = {
+        .magic = YMODEM_DIGEST_MAGIC,
+        .size = size,
+        .crc = session.digest
+    };
+    UINT bytes_written = 0;
+
+    snprintf(path, sizeof(path), "%s" YMODEM_DIGEST_SUFFIX, session.path);
+    FRESULT fres = f_open(&progress_file, path, FA_CREATE_ALWAYS | FA_WRITE);
+    if (fres == FR_OK) {
+        fres = f_write(&progress_file, &digest, sizeof(digest), &bytes_written);
+        FRESULT close_res = f_close(&progress_file);
+        if (fres == FR_OK) {
+            fres = close_res;
+        }
+    }
 
-        // Python이 ACK를 읽자마자 패킷 1을 보내므로 지연 없이 즉시 수신 시작
-        // 지연하면 패킷 1을 놓칠 수 있음!
-        printf("[DEBUG] Y-MODEM: starting data reception...\r\n");
-        packet_number = 1;
+    if (fres != FR_OK || bytes_written != sizeof(digest)) {
+        printf("[WARN] Digest save (%s) failed: fres=%d\r\n", path, fres);
     } else {
-        f_close(&file);
-        transmit_byte(huart, YMODEM_CAN);
-        uart_send_error(501, "Y-MODEM expected file info packet");
-        g_ymodem_active = 0;
-        if (using_cdc) CDC_Set_YModem_Mode(false);
-        return YMODEM_ERROR;
+        printf("[DEBUG] Y-MODEM: %s CRC-32 %08lX (%lu bytes)\r\n", session.path, session.digest, size);
     }
+}
 
-    // 재시도 카운터 초기화
-    uint8_t timeout_retries = 0;
-    uint8_t nak_retries = 0;
+// 다이제스트 읽기 (VERIFY 명령)
+bool ymodem_read_digest(const char *file_path, uint32_t *size, uint32_t *crc)
+{
+    char path[YMODEM_PATH_MAX + sizeof(YMODEM_DIGEST_SUFFIX)];
+    YmodemDigest_t digest;
+    UINT bytes_read = 0;
 
-    // 데이터 패킷 수신 루프
-    while (1) {
-        // 패킷 수신
-        status = receive_packet(huart, packet_buffer,
-                                &packet_length, YMODEM_TIMEOUT_MS);
+    snprintf(path, sizeof(path), "%s" YMODEM_DIGEST_SUFFIX, file_path);
+    if (f_open(&progress_file, path, FA_READ) != FR_OK) {
+        return false;
+    }
+    FRESULT fres = f_read(&progress_file, &digest, sizeof(digest), &bytes_read);
+    f_close(&progress_file);
 
-        if (status != HAL_OK) {
-            // 타임아웃 또는 에러 - 재시도
-            timeout_retries++;
-            if (timeout_retries >= YMODEM_MAX_TIMEOUT_RETRIES) {
-                // 최대 재시도 횟수 초과
-                transmit_byte(huart, YMODEM_CAN);
-                uart_send_error(501, "Y-MODEM timeout after retries");
-                printf("[ERROR] Y-MODEM: timeout after %d retries\r\n", timeout_retries);
-                result = YMODEM_TIMEOUT;
-                break;
-            }
-            // 재시도
-            printf("[WARN] Packet timeout, retry %d/%d\r\n",
-                   timeout_retries, YMODEM_MAX_TIMEOUT_RETRIES);
-            uart_send_response(ANSI_YELLOW "INFO:" ANSI_RESET " Timeout, retrying...\r\n");
-            HAL_Delay(100);  // 100ms 대기 후 재시도
-            continue;
+    if (fres != FR_OK || bytes_read != sizeof(digest) || digest.magic != YMODEM_DIGEST_MAGIC) {
+        return false;
+    }
+    *size = digest.size;
+    *crc = digest.crc;
+    return true;
+}
+
+// 파일 전체 CRC-32 재계산 (VERIFY 명령)
+// 32KB 단위 순차 읽기 (FatFs가 클러스터 정렬 구간을 멀티 블록 DMA로 바로 읽음)
+// 수신 세션의 FIL과 sdmmc1_buffer를 빌려 쓰므로 전송 중에는 FR_LOCKED
+FRESULT ymodem_file_crc32(const char *file_path, uint32_t *size, uint32_t *crc)
+{
+    if (session.state != YMODEM_STATE_IDLE) {
+        return FR_LOCKED;
+    }
+
+    FRESULT fres = f_open(&session.file, file_path, FA_READ);
+    if (fres != FR_OK) {
+        return fres;
+    }
+
+    uint32_t total = 0;
+    uint32_t value = 0;
+    uint32_t start = HAL_GetTick();
+    UINT bytes_read;
+
+    do {
+        fres = f_read(&session.file, sdmmc1_buffer, sizeof(sdmmc1_buffer), &bytes_read);
+        if (fres != FR_OK) {
+            break;
         }
+        value = crc32_update(value, sdmmc1_buffer, bytes_read);
+        total += bytes_read;
+    } while (bytes_read == sizeof(sdmmc1_buffer));
 
-        // 수신 성공 시 타임아웃 카운터 리셋
-        timeout_retries = 0;
+    f_close(&session.file);
 
-        uint8_t header = packet_buffer[0];
+    uint32_t elapsed = HAL_GetTick() - start;
+    printf("[DEBUG] CRC-32 %s: %lu bytes in %lu ms, %lu KB/s\r\n", file_path, total, elapsed,
+           elapsed ? (total / elapsed) * 1000 / 1024 : 0);
 
-        if (header == YMODEM_EOT) {
-            // 전송 완료 - 남은 버퍼 데이터를 512 배수로 패딩하여 쓰기
-            if (write_buffer_offset > 0) {
-                // 512 배수로 올림 (SD 카드 최적화)
-                uint32_t padded_size = ((write_buffer_offset + 511) / 512) * 512;
+    *size = total;
+    *crc = value;
+    return fres;
+}
 
-                // 패딩 영역을 0으로 채움
-                if (padded_size > write_buffer_offset) {
-                    memset(&sdmmc1_buffer[write_buffer_offset], 0, padded_size - write_buffer_offset);
-                }
+// 진행 기록 읽기 (없거나 손상되면 false)
+static bool load_progress(const char *file_path, YmodemProgress_t *progress)
+{
+    char path[YMODEM_PATH_MAX + sizeof(YMODEM_PROGRESS_SUFFIX)];
+    UINT bytes_read = 0;
 
-                // SD 카드에 마지막 데이터 쓰기
-                UINT bytes_written;
-                fres = f_write(&file, sdmmc1_buffer, padded_size, &bytes_written);
-
-                if (fres != FR_OK) {
-                    printf("[ERROR] Final SD write failed: fres=%d, written=%u/%lu\r\n",
-                           fres, bytes_written, padded_size);
-                    transmit_byte(huart, YMODEM_CAN);
-                    uart_send_error(405, "Final SD write error");
-                    result = YMODEM_ERROR;
-                    break;
-                }
+    progress_path(file_path, path, sizeof(path));
+    if (f_open(&progress_file, path, FA_READ) != FR_OK) {
+        return false;
+    }
+    FRESULT fres = f_read(&progress_file, progress, sizeof(*progress), &bytes_read);
+    f_close(&progress_file);
 
-                printf("[DEBUG] Final write: %lu bytes data + %lu bytes padding = %u bytes written\r\n",
-                       write_buffer_offset, padded_size - write_buffer_offset, bytes_written);
-                write_buffer_offset = 0;
-            }
+    return (fres == FR_OK && bytes_read == sizeof(*progress) && progress->magic == YMODEM_PROGRESS_MAGIC);
+}
 
-            transmit_byte(huart, YMODEM_ACK);
-            uart_send_response(ANSI_GREEN "INFO:" ANSI_RESET " Transfer complete (%lu bytes)\r\n", total_bytes);
-            result = YMODEM_OK;
-            break;
-        }
-        else if (header == YMODEM_CAN) {
-            // 전송 취소
-            uart_send_response(ANSI_YELLOW "INFO:" ANSI_RESET " Transfer cancelled by sender\r\n");
-            result = YMODEM_CANCELLED;
-            break;
-        }
-        else if (header == YMODEM_SOH || header == YMODEM_STX) {
-            // 데이터 패킷
-            uint16_t data_size = (header == YMODEM_SOH) ? 128 : 1024;
-            uint8_t blk_num = packet_buffer[1];
-            uint8_t blk_num_inv = packet_buffer[2];
-
-            // 블록 번호 확인
-            if (blk_num != (uint8_t)(~blk_num_inv)) {
-                // 블록 번호 오류 - NAK 재시도
-                nak_retries++;
-                if (nak_retries >= YMODEM_MAX_NAK_RETRIES) {
-                    // 최대 NAK 재시도 횟수 초과
-                    transmit_byte(huart, YMODEM_CAN);
-                    uart_send_error(501, "Too many NAK retries (block number)");
-                    printf("[ERROR] Y-MODEM: NAK retries exceeded (%d) - block number mismatch\r\n", nak_retries);
-                    result = YMODEM_ERROR;
-                    break;
-                }
-                printf("[ERROR] Block number mismatch: blk=%u, ~blk=%u (NAK retry %d/%d)\r\n",
-                       blk_num, blk_num_inv, nak_retries, YMODEM_MAX_NAK_RETRIES);
-                transmit_byte(huart, YMODEM_NAK);
-                continue;
-            }
+// 재개 위치 조회 (RESUME 명령)
+// 진행 기록이 있으면 확정 위치, 없으면 파일 크기 (이전 방식으로 중단된 파일)
+// 블록 단위로 이어받도록 YMODEM_PACKET_SIZE 경계로 내림, 파일이 없으면 0
+uint32_t ymodem_resume_offset(const char *file_path)
+{
+    FILINFO fno;
+    YmodemProgress_t progress;
 
-            // CRC 확인
-            uint16_t crc_received = (packet_buffer[3 + data_size] << 8) |
-                                     packet_buffer[4 + data_size];
-            uint16_t crc_calculated = crc16(&packet_buffer[3], data_size);
-
-            if (crc_received != crc_calculated) {
-                // CRC 오류 - NAK 재시도
-                nak_retries++;
-                if (nak_retries >= YMODEM_MAX_NAK_RETRIES) {
-                    // 최대 NAK 재시도 횟수 초과
-                    transmit_byte(huart, YMODEM_CAN);
-                    uart_send_error(501, "Too many NAK retries (CRC error)");
-                    printf("[ERROR] Y-MODEM: NAK retries exceeded (%d) - CRC mismatch\r\n", nak_retries);
-                    result = YMODEM_ERROR;
-                    break;
-                }
-                printf("[ERROR] CRC mismatch! received=0x%04X, calculated=0x%04X (NAK retry %d/%d)\r\n",
-                       crc_received, crc_calculated, nak_retries, YMODEM_MAX_NAK_RETRIES);
-                transmit_byte(huart, YMODEM_NAK);
-                uart_send_response(ANSI_YELLOW "INFO:" ANSI_RESET " CRC error, retrying...\r\n");
-                continue;
-            }
+    if (session.state != YMODEM_STATE_IDLE || f_stat(file_path, &fno) != FR_OK) {
+        return 0;
+    }
 
-            // 패킷 데이터를 버퍼에 추가 (8KB 버퍼링으로 SD 카드 수명 보호)
-            // Python은 Stop-and-Wait ARQ로 ACK를 30초 대기하므로 안전
-            memcpy(&sdmmc1_buffer[write_buffer_offset], &packet_buffer[3], data_size);
-            write_buffer_offset += data_size;
-            total_bytes += data_size;
-            packet_number++;
-
-            // 패킷 성공 시 NAK 카운터 리셋
-            nak_retries = 0;
-
-            // 버퍼가 8KB 이상 차면 SD 카드에 쓰기 (512 * 16 = 최적 블록 크기)
-            uint8_t sd_write_done = 0;
-            if (write_buffer_offset >= SD_WRITE_BUFFER_SIZE) {
-                UINT bytes_written;
-                fres = f_write(&file, sdmmc1_buffer, write_buffer_offset, &bytes_written);
-
-                if (fres != FR_OK || bytes_written != write_buffer_offset) {
-                    // 쓰기 에러
-                    printf("[ERROR] SD write failed: fres=%d, written=%u/%lu\r\n",
-                           fres, bytes_written, write_buffer_offset);
-                    transmit_byte(huart, YMODEM_CAN);
-                    uart_send_error(405, "SD write error");
-                    result = YMODEM_ERROR;
-                    break;
-                }
+    uint32_t committed = fno.fsize;
+    if (load_progress(file_path, &progress) && progress.committed < committed) {
+        committed = progress.committed;
+    }
 
-                // 버퍼 리셋
-                write_buffer_offset = 0;
-                sd_write_done = 1;  // SD 쓰기 완료 플래그
+    return committed - (committed % YMODEM_PACKET_SIZE);
+}
 
-                // 1MB마다 f_sync() 호출 (SD 카드 데이터 무결성 보장)
-                if (total_bytes % (1024 * 1024) == 0) {
-                    fres = f_sync(&file);
-                    if (fres != FR_OK) {
-                        printf("[WARN] f_sync failed at %lu bytes: fres=%d\r\n", total_bytes, fres);
-                    }
-                }
-            }
+// 배치 전송: 블록 0 파일명 -> 저장 경로 (YMODEM_BATCH_ROOT 아래로 제한)
+// 예: "ch0/test.wav" 또는 "/audio/ch0/test.wav" -> "/audio/ch0/test.wav"
+static bool batch_resolve_path(const char *name, char *path, uint32_t path_size)
+{
+    const char *root = YMODEM_BATCH_ROOT;
+    uint32_t root_len = strlen(root);
 
-            // ACK 전송
-            // 패킷 1-7: 버퍼에만 추가 후 즉시 ACK (빠름)
-            // 패킷 8: 8KB SD 쓰기 후 상태 확인 + ACK
-            HAL_StatusTypeDef ack_status = transmit_byte(huart, YMODEM_ACK);
+    // 선행 '/' 및 루트 디렉토리 이름 제거
+    while (*name == '/') {
+        name++;
+    }
+    if (strncmp(name, root + 1, root_len - 1) == 0 && name[root_len - 1] == '/') {
+        name += root_len;
+    }
 
-            // ACK 전송 실패 시에만 로그
-            if (ack_status != HAL_OK) {
-                printf("[WARN] ACK send failed for packet %d, status=%d\r\n", packet_number, ack_status);
-            }
+    // 빈 이름 또는 상위 디렉토리 참조 거부
+    if (*name == '\0' || strstr(name, "..") != NULL) {
+        return false;
+    }
 
-            // SD 쓰기 직후에만 상태 기반 대기
-            if (sd_write_done) {
-                // SD 카드가 준비될 때까지 대기 (최대 100ms)
-                uint32_t wait_start = HAL_GetTick();
-                while (BSP_SD_GetCardState() != SD_TRANSFER_OK) {
-                    if (HAL_GetTick() - wait_start > 100) {
-                        printf("[WARN] SD not ready after 100ms at packet %d\r\n", packet_number);
-                        break;
-                    }
-                    HAL_Delay(1);  // 1ms 폴링
-                }
-            }
+    int len = snprintf(path, path_size, "%s/%s", root, name);
+    return (len > 0 && (uint32_t)len < path_size);
+}
 
-            // 추가 안정화 지연 (USB CDC 핸드셰이킹)
-            // 모든 패킷에서 필수 (제거 시 ACK 손실로 타임아웃 발생)
-            HAL_Delay(8);
+// 블록 0에서 파일 크기 추출: "파일명\0크기 [수정시각 모드 ...]" (크기는 10진수 ASCII)
+static uint32_t parse_file_size(const uint8_t *payload, uint16_t size)
+{
+    uint16_t i = 0;
 
-            // 진행 상황 로그 제거 (printf 오버헤드로 인한 타임아웃 방지)
-            // if (packet_number % 500 == 0) {
-            //     printf("[DEBUG] Progress: packet %d, total=%lu bytes\r\n", packet_number, total_bytes);
-            // }
+    // 파일명 건너뛰기
+    while (i < size && payload[i] != '\0') {
+        i++;
+    }
+    i++;
 
-            // 진행률 출력 비활성화 (USB CDC 모드에서 링 버퍼 오염 방지)
-            // if (packet_number % 100 == 0) {
-            //     uart_send_response(ANSI_CYAN "INFO:" ANSI_RESET " Receiving... %lu bytes\r\n", total_bytes);
-            // }
-        }
+    uint32_t file_size = 0;
+    while (i < size && payload[i] >= '0' && payload[i] <= '9') {
+        file_size = file_size * 10 + (payload[i] - '0');
+        i++;
+    }
+
+    return file_size;
+}
+
+// 연속 클러스터 사전 할당 (f_expand)
+// 전송 중 FAT 갱신 없이 순차 섹터로 기록, 실패 시 기존처럼 클러스터 단위로 확장
+static void preallocate_file(uint32_t size)
+{
+    session.expected_size = size;
+    session.preallocated = false;
+
+    if (size == 0) {
+        return;
     }
 
-    // 파일 정상 종료: f_sync() 후 f_close() (SD 카드 데이터 무결성 보장)
-    fres = f_sync(&file);
+    FRESULT fres = f_expand(&session.file, size, 1);
     if (fres != FR_OK) {
-        printf("[WARN] f_sync before close failed: fres=%d\r\n", fres);
+        printf("[WARN] f_expand(%lu) failed: fres=%d, growing file on demand\r\n", size, fres);
+        return;
+    }
+
+    session.preallocated = true;
+    printf("[DEBUG] Y-MODEM: preallocated %lu bytes (contiguous)\r\n", size);
+}
+
+// 차등 업로드 서명 생성 (SIGS 명령)
+// 16KB 단위 순차 읽기 (sdmmc1_buffer 앞쪽), 서명은 뒤쪽 16KB에 모아서 "<경로>.sig"에 기록
+// 기존 파일은 delta_basis, 서명 파일은 수신 세션의 FIL을 빌려 쓰므로 전송 중에는 FR_LOCKED
+FRESULT ymodem_delta_signatures(const char *file_path, uint32_t block_size, uint32_t *block_count)
+{
+    const uint32_t chunk = sizeof(sdmmc1_buffer) / 2;
+    uint8_t *sig = &sdmmc1_buffer[chunk];
+    char sig_path[YMODEM_PATH_MAX + sizeof(DELTA_SIG_SUFFIX)];
+    UINT bytes;
+
+    if (session.state != YMODEM_STATE_IDLE) {
+        return FR_LOCKED;
     }
 
-    fres = f_close(&file);
+    FRESULT fres = f_open(&delta_basis, file_path, FA_READ);
     if (fres != FR_OK) {
-        printf("[ERROR] f_close failed: fres=%d\r\n", fres);
-    } else {
-        printf("[DEBUG] File closed successfully\r\n");
+        return fres;
+    }
+    snprintf(sig_path, sizeof(sig_path), "%s" DELTA_SIG_SUFFIX, file_path);
+    fres = f_open(&session.file, sig_path, FA_CREATE_ALWAYS | FA_WRITE);
+    if (fres != FR_OK) {
+        f_close(&delta_basis);
+        return fres;
     }
 
-    // Y-MODEM 처리 종료
-    g_ymodem_active = 0;
+    uint32_t start = HAL_GetTick();
+    DeltaSigHeader_t header = {
+        .magic = DELTA_SIG_MAGIC,
+        .block_size = block_size,
+        .file_size = (uint32_t)f_size(&delta_basis),
+        .block_count = ((uint32_t)f_size(&delta_basis) + block_size - 1) / block_size
+    };
+    memcpy(sig, &header, sizeof(header));
+    uint32_t fill = sizeof(header);
+
+    // chunk는 block_size의 배수이므로 블록이 읽기 단위에 걸치지 않음
+    do {
+        fres = f_read(&delta_basis, sdmmc1_buffer, chunk, &bytes);
+        for (uint32_t pos = 0; fres == FR_OK && pos < bytes; pos += block_size) {
+            uint32_t len = (bytes - pos < block_size) ? bytes - pos : block_size;
+            DeltaSigEntry_t entry = {
+                .weak = delta_weak_checksum(&sdmmc1_buffer[pos], len),
+                .strong = crc32_update(0, &sdmmc1_buffer[pos], len)
+            };
+            memcpy(&sig[fill], &entry, sizeof(entry));
+            fill += sizeof(entry);
+            if (fill == chunk) {
+                UINT written;
+                fres = f_write(&session.file, sig, fill, &written);
+                if (fres == FR_OK && written != fill) {
+                    fres = FR_DISK_ERR;
+                }
+                fill = 0;
+            }
+        }
+    } while (fres == FR_OK && bytes == chunk);
 
-    // USB CDC 모드 해제
-    if (using_cdc) {
-        CDC_Set_YModem_Mode(false);
+    UINT written = fill;
+    if (fres == FR_OK && fill > 0) {
+        fres = f_write(&session.file, sig, fill, &written);
+    }
+    FRESULT close_res = f_close(&session.file);
+    f_close(&delta_basis);
+    if (fres == FR_OK && (close_res != FR_OK || written != fill)) {
+        fres = (close_res != FR_OK) ? close_res : FR_DISK_ERR;
+    }
+    if (fres != FR_OK) {
+        f_unlink(sig_path);
+        return fres;
     }
 
-    return result;
+    uint32_t elapsed = HAL_GetTick() - start;
+    printf("[DEBUG] Y-MODEM delta: %s %lu blocks of %lu bytes signed in %lu ms\r\n",
+           file_path, header.block_count, block_size, elapsed);
+    *block_count = header.block_count;
+    return FR_OK;
 }
 
-// 패킷 수신
-static HAL_StatusTypeDef receive_packet(UART_HandleTypeDef *huart, uint8_t *buffer,
-                                         uint16_t *length, uint32_t timeout)
+// 마지막 차등 업로드 결과
+void ymodem_delta_result(uint32_t *literal_bytes, uint32_t *copied_bytes, uint32_t *wire_bytes)
 {
-    uint32_t start_tick = HAL_GetTick();
+    *literal_bytes = delta_stream_literal_bytes();
+    *copied_bytes = delta_stream_copied_bytes();
+    *wire_bytes = session.wire_bytes;
+}
 
-    if (huart == NULL) {
-        // USB CDC 모드: 링 버퍼에서 읽기
-        // 헤더 수신
-        uint32_t read = CDC_Read_Data(buffer, 1, timeout);
+// SD 기록 경로 벤치마크 (SDBENCH 명령)
+// Y-MODEM 수신과 같은 스테이징/write-behind 경로로 size 바이트 기록 후 삭제
+// 반환값: 소요 시간 (ms, 파일 생성~닫기), 실패 시 0
+uint32_t ymodem_sd_benchmark(const char *path, uint32_t size, bool prealloc)
+{
+    if (session.state != YMODEM_STATE_IDLE) {
+        return 0;
+    }
 
-        if (read == 0) {
-            return HAL_TIMEOUT;
-        }
+    for (uint32_t i = 0; i < YMODEM_PACKET_SIZE; i++) {
+        ymodem_packet_buffer[i] = (uint8_t)i;
+    }
 
-        uint8_t header = buffer[0];
+    uint32_t start = HAL_GetTick();
+    session.compressed = false;
+    session.transcode = WAV_NATIVE_NONE;
+    session.delta = false;
+    session.large_blocks = false;
+    if (open_file(path, 0) != YMODEM_OK) {
+        return 0;
+    }
+    if (prealloc) {
+        preallocate_file(size);
+    }
 
-        if (header == YMODEM_EOT || header == YMODEM_CAN) {
-            *length = 1;
-            return HAL_OK;
-        }
+    YmodemResult_t result = YMODEM_OK;
+    SD_SetWriteBehind(1);
+    session.start_tick = start;
 
-        // 데이터 크기 결정
-        uint16_t data_size;
-        if (header == YMODEM_SOH) {
-            data_size = 128;
-        } else if (header == YMODEM_STX) {
-            data_size = 1024;
-        } else {
-            printf("[ERROR] receive_packet: invalid header 0x%02X\r\n", header);
-            return HAL_ERROR;
-        }
+    for (uint32_t written = 0; written < size && result == YMODEM_OK; written += YMODEM_PACKET_SIZE) {
+        result = stage_payload(ymodem_packet_buffer, YMODEM_PACKET_SIZE);
+    }
+    if (result == YMODEM_OK) {
+        result = flush_staging_final();
+    }
+    if (result == YMODEM_OK) {
+        result = truncate_to_exact_size();
+    }
 
-        // 나머지 수신: BLK(1) + ~BLK(1) + DATA(128/1024) + CRC(2)
-        uint16_t remaining = 1 + 1 + data_size + 2;
+    close_file(result == YMODEM_OK);
+    SD_SetWriteBehind(0);
+    uint32_t elapsed = HAL_GetTick() - start;
 
-        // USB CDC는 64바이트 청크로 전송되므로 충분한 타임아웃 필요
-        // 1028바이트 = 약 17개 USB 패킷, SD 쓰기 지연 고려
-        uint32_t data_timeout = 5000;  // 5초 (SD 쓰기 지연 + 여유)
+    f_unlink(path);
+    return (result == YMODEM_OK) ? elapsed : 0;
+}
 
-        read = CDC_Read_Data(&buffer[1], remaining, data_timeout);
+// 받은 파일 수 (배치 전송)
+uint32_t ymodem_files_received(void)
+{
+    return session.files_received;
+}
 
-        if (read != remaining) {
-            printf("[ERROR] receive_packet: data read failed (expected=%u, got=%lu)\r\n",
-                   remaining, read);
-            return HAL_TIMEOUT;
-        }
+// Y-MODEM 수신 진행 (메인 루프에서 반복 호출)
+// 한 번 호출에 최대 YMODEM_POLL_MAX_PACKETS개 패킷만 처리하고 반환 (대기 없음)
+// 반환값: YMODEM_BUSY (진행 중) 또는 최종 결과 (전송 종료, 파일 닫힘)
+YmodemResult_t ymodem_poll(void)
+{
+    if (session.state == YMODEM_STATE_IDLE) {
+        return session.result;
+    }
 
-        *length = 1 + remaining;
-        return HAL_OK;
-    } else {
-        // UART 모드: 기존 코드
-        // 헤더 수신
-        if (HAL_UART_Receive(huart, buffer, 1, timeout) != HAL_OK) {
-            return HAL_TIMEOUT;
+    // 안정화 지연 중 (HAL_Delay 대신 틱 기반 대기)
+    if ((int32_t)(HAL_GetTick() - session.holdoff_until) < 0) {
+        return YMODEM_BUSY;
+    }
+    if (session.stat_holdoff_active) {
+        STATS_ADD(YMODEM_PHASE_FIXED_DELAY, session.stat_holdoff);
+        session.stat_holdoff_active = false;
+        session.stat_ready = STATS_NOW();
+        if (session.reply_armed) {
+            session.reply_mark = DWT->CYCCNT;
         }
+    }
+
+    if (session.state == YMODEM_STATE_HANDSHAKE) {
+        return poll_handshake();
+    }
+    if (session.state == YMODEM_STATE_SEND) {
+        return poll_send();
+    }
 
-        uint8_t header = buffer[0];
+    // 차등 업로드: 이전 패킷의 블록 참조 복사를 이어서 진행 (끝나야 ACK 후 다음 패킷 수신)
+    if (session.delta_ack_pending) {
+        return poll_delta_copy();
+    }
 
-        if (header == YMODEM_EOT || header == YMODEM_CAN) {
-            *length = 1;
-            return HAL_OK;
+    for (int i = 0; i < YMODEM_POLL_MAX_PACKETS; i++) {
+        YmodemResult_t result = poll_data();
+        // 패킷 처리 완료 = 다음 패킷 수신 준비 (보류 중이면 보류가 끝난 시점부터)
+        if (session.stat_packet_done) {
+            session.stat_packet_done = false;
+            if (!session.stat_holdoff_active) {
+                session.stat_ready = STATS_NOW();
+            }
         }
-
-        // 데이터 크기 결정
-        uint16_t data_size;
-        if (header == YMODEM_SOH) {
-            data_size = 128;
-        } else if (header == YMODEM_STX) {
-            data_size = 1024;
-        } else {
-            return HAL_ERROR;
+        if (result != YMODEM_BUSY || session.rx_header_pending || session.resync || session.delta_ack_pending ||
+            (int32_t)(HAL_GetTick() - session.holdoff_until) < 0 ||
+            session.pkt.data_size > YMODEM_PACKET_SIZE) {
+            return result;
         }
-
-        // 나머지 수신: BLK(1) + ~BLK(1) + DATA(128/1024) + CRC(2)
-        uint16_t remaining = 1 + 1 + data_size + 2;
-        uint32_t elapsed = HAL_GetTick() - start_tick;
-        uint32_t remaining_timeout = (timeout > elapsed) ? (timeout - elapsed) : 0;
-
-        if (HAL_UART_Receive(huart, &buffer[1], remaining, remaining_timeout) != HAL_OK) {
-            return HAL_TIMEOUT;
+        // 다음 패킷이 아직 도착하지 않았으면 반환
+        if (session.huart == NULL && link_available() == 0) {
+            return YMODEM_BUSY;
         }
+    }
 
-        *length = 1 + remaining;
-        return HAL_OK;
+    return YMODEM_BUSY;
+}
+
+// 다음 세션의 USB CDC 대체 링크 지정 (huart == NULL로 시작할 때만 사용)
+void ymodem_set_link(const YmodemLink_t *link)
+{
+    if (session.state == YMODEM_STATE_IDLE) {
+        session.link = link;
     }
 }
 
-// CRC-16 계산
-static uint16_t crc16(const uint8_t *data, uint16_t length)
+// 진행 중 여부
+bool ymodem_is_active(void)
 {
-    uint16_t crc = 0;
+    return (session.state != YMODEM_STATE_IDLE);
+}
 
-    for (uint16_t i = 0; i < length; i++) {
-        crc ^= (uint16_t)data[i] << 8;
+// Y-MODEM 수신 (차단형, 전송 완료까지 반환하지 않음)
+YmodemResult_t ymodem_receive(UART_HandleTypeDef *huart, const char *file_path, YmodemMode_t mode)
+{
+    YmodemResult_t result = ymodem_start(huart, file_path, mode);
 
-        for (uint8_t j = 0; j < 8; j++) {
-            if (crc & 0x8000) {
-                crc = (crc << 1) ^ 0x1021;
-            } else {
-                crc = crc << 1;
-            }
-        }
+    while (result == YMODEM_BUSY) {
+        result = ymodem_poll();
     }
 
-    return crc;
+    return result;
 }
 
-// 단일 바이트 전송 (UART 또는 USB CDC)
-static HAL_StatusTypeDef transmit_byte(UART_HandleTypeDef *huart, uint8_t data)
+// 핸드셰이크 단계: 1초마다 'C'/'G'/'W' 전송, 블록 0 (파일 정보) 대기
+// 배치의 다음 파일은 송신측이 이미 연결되어 있으므로 측정한 응답 시간 간격으로 재전송 (최대 1초)
+static YmodemResult_t poll_handshake(void)
 {
-    if (huart == NULL) {
-        // USB CDC 모드 - 이전 전송 완료 대기 후 전송
-        extern USBD_HandleTypeDef hUsbDeviceHS;
-        extern uint8_t UserTxBufferHS[APP_TX_DATA_SIZE];
-        USBD_CDC_HandleTypeDef *hcdc = (USBD_CDC_HandleTypeDef*)hUsbDeviceHS.pClassData;
-
-        // TxState가 0이 될 때까지 대기 (이전 전송 완료 대기)
-        // 메인 컨텍스트이므로 USB 인터럽트가 정상 처리됨
-        uint32_t retry = 0;
-        const uint32_t max_retries = 200;  // 최대 2초 대기
-        while (hcdc->TxState != 0 && retry < max_retries) {
-            retry++;
-            HAL_Delay(10);  // 10ms 대기 (USB 콜백이 실행될 시간 제공)
-        }
-
-        if (hcdc->TxState != 0) {
-            printf("[ERROR] transmit_byte: TX timeout (TxState=%lu after %lums)\r\n",
-                   hcdc->TxState, retry * 10);
-            return HAL_ERROR;
-        }
-
-        // UserTxBufferHS에 복사 (버퍼 수명 문제 해결)
-        UserTxBufferHS[0] = data;
+    UART_HandleTypeDef *huart = session.huart;
+    YmodemPacket_t *pkt = &session.pkt;
 
-        uint8_t result = CDC_Transmit_HS(UserTxBufferHS, 1);
+    HAL_StatusTypeDef status = try_receive_packet(pkt, 0, NULL, 0);
 
-        if (result == USBD_BUSY) {
-            printf("[ERROR] transmit_byte: CDC still BUSY (should not happen)\r\n");
-            return HAL_ERROR;
+    if (status != HAL_OK) {
+        uint32_t interval = 1000;
+        if (session.files_received > 0) {
+            interval = rtt_timeout_ms(YMODEM_EST_REPLY, 0, 0);
+            if (interval > 1000) {
+                interval = 1000;
+            }
         }
 
-        if (result != USBD_OK) {
-            printf("[ERROR] transmit_byte: CDC_Transmit_HS failed, result=%d\r\n", result);
-            return HAL_ERROR;
+        // 재동기화 실패 (잡음 후 링크 조용함) - 간격을 기다리지 않고 바로 핸드셰이크 문자 재전송
+        if (status == HAL_ERROR) {
+            session.wait_start_tick = HAL_GetTick() - interval;
         }
 
-        // 전송 완료 대기 (USB는 비동기이므로 완료까지 기다려야 함)
-        retry = 0;
-        while (hcdc->TxState != 0 && retry < max_retries) {
-            retry++;
-            HAL_Delay(1);  // 1ms 대기 (USB 전송 완료 확인)
+        // 간격 동안 패킷 없음 - 핸드셰이크 문자 재전송
+        if (session.rx_header_pending || session.resync || HAL_GetTick() - session.wait_start_tick < interval) {
+            return YMODEM_BUSY;
         }
 
-        // USB 전송이 Python까지 도착하는 최소 시간 확보
-        // 너무 짧으면 타이밍 이슈, 너무 길면 속도 저하
-        if (hcdc->TxState == 0) {
-            HAL_Delay(2);  // 2ms 안정화 지연 (USB 전송 완료 확인)
+        // 60초 타임아웃 체크
+        if (HAL_GetTick() - session.handshake_start_tick >= YMODEM_HANDSHAKE_TIMEOUT_MS) {
+            transmit_byte(huart, YMODEM_CAN);
+            uart_send_error(501, "Y-MODEM timeout waiting for sender");
+            return finish_session(YMODEM_TIMEOUT);
         }
 
-        if (hcdc->TxState != 0) {
-            printf("[ERROR] transmit_byte: TX complete timeout (TxState=%lu after %lums)\r\n",
-                   hcdc->TxState, retry);
-            return HAL_ERROR;
+        if (transmit_byte(huart, session.handshake) != HAL_OK) {
+            printf("[WARN] Y-MODEM: transmit_byte('%c') failed, retry=%d\r\n",
+                   session.handshake, session.handshake_retries);
         }
+        if (session.handshake_retries < UINT8_MAX) {
+            session.handshake_retries++;
+        }
+        session.wait_start_tick = HAL_GetTick();
 
-        return HAL_OK;
-    } else {
-        // UART 모드
-        return HAL_UART_Transmit(huart, &data, 1, 500);  // 100 → 500ms
+        // USB 호스트가 'C'를 읽을 시간 제공
+        hold_off(10);
+        return YMODEM_BUSY;
+    }
+
+    printf("[DEBUG] Y-MODEM: first packet received after %d retries\r\n", session.handshake_retries - 1);
+
+    // 첫 번째 패킷 처리 (파일 정보 패킷)
+    if (pkt->header != YMODEM_SOH && pkt->header != YMODEM_STX) {
+        transmit_byte(huart, YMODEM_CAN);
+        uart_send_error(501, "Y-MODEM expected file info packet");
+        return finish_session(YMODEM_ERROR);
+    }
+
+    // 블록 번호 확인 (첫 번째 패킷은 블록 0)
+    if (pkt->blk != 0 || pkt->blk != (uint8_t)(~pkt->blk_inv)) {
+        transmit_byte(huart, YMODEM_CAN);
+        uart_send_error(501, "Y-MODEM invalid file info packet");
+        return finish_session(YMODEM_ERROR);
+    }
+
+    // CRC 확인
+    uint16_t crc_received = (pkt->crc[0] << 8) | pkt->crc[1];
+    uint16_t crc_calculated = crc16_ccitt(pkt->payload, pkt->data_size);
+
+    if (crc_received != crc_calculated) {
+        transmit_byte(huart, YMODEM_CAN);
+        uart_send_error(501, "Y-MODEM CRC error in file info packet");
+        return finish_session(YMODEM_CRC_ERROR);
+    }
+
+    // 배치 전송: 파일명이 비어 있는 블록 0 = 세션 종료, 아니면 파일명으로 저장 경로 결정
+    if (session.batch) {
+        if (pkt->payload[0] == '\0') {
+            transmit_byte(huart, YMODEM_ACK);
+            printf("[DEBUG] Y-MODEM batch: end of session (%lu files)\r\n", session.files_received);
+            return finish_session(YMODEM_OK);
+        }
+
+        char path[YMODEM_PATH_MAX];
+        pkt->payload[pkt->data_size - 1] = '\0';
+        if (!batch_resolve_path((const char *)pkt->payload, path, sizeof(path))) {
+            printf("[ERROR] Y-MODEM batch: invalid file name '%s'\r\n", (const char *)pkt->payload);
+            cancel_transfer(huart);
+            uart_send_error(401, "Invalid file name in batch");
+            return finish_session(YMODEM_ERROR);
+        }
+
+        if (open_file(path, 0) != YMODEM_OK) {
+            cancel_transfer(huart);
+            return finish_session(YMODEM_ERROR);
+        }
+        printf("[DEBUG] Y-MODEM batch: receiving %s\r\n", path);
+    }
+
+    // 블록 0의 파일 크기로 연속 영역 사전 할당 (EOT에서 정확한 크기로 자름)
+    // 재개 전송은 기존 파일을 이어 쓰므로 크기만 기록
+    uint32_t declared_size = parse_file_size(pkt->payload, pkt->data_size);
+    if (session.resume_offset > 0) {
+        session.expected_size = declared_size;
+    } else {
+        preallocate_file(declared_size);
+    }
+
+    // 진행 기록 시작 (리셋 시 이 기록으로 재개 위치 결정)
+    session.progress_enabled = true;
+    save_progress(session.synced_offset);
+
+    if (session.streaming) {
+        // Y-MODEM-G: 블록 0에는 ACK 없이 'G'를 다시 보내 데이터 스트리밍 시작
+        // 이후 송신측은 ACK를 기다리지 않고 패킷을 연속 전송
+        transmit_byte(huart, YMODEM_G);
+        printf("[DEBUG] Y-MODEM-G: file info packet accepted, streaming...\r\n");
+    } else {
+        // 파일 정보 패킷 ACK
+        transmit_byte(huart, YMODEM_ACK);
+        printf("[DEBUG] Y-MODEM: file info packet ACKed\r\n");
+
+        // 주의: 표준 Y-MODEM에서는 여기서 'C'를 보내야 하지만,
+        // Python 구현이 'C'를 기다리지 않고 즉시 데이터 패킷을 보내므로
+        // 'C'를 보내면 Python이 ACK 대기 시 'C'를 읽어서 타임아웃됨
+        // 따라서 'C'를 보내지 않고 ACK만 보냄 (비표준이지만 Python 호환)
+
+        // Python이 ACK를 읽자마자 패킷 1을 보내므로 지연 없이 즉시 수신 시작
+        // 지연하면 패킷 1을 놓칠 수 있음!
+        // 윈도우 모드도 블록 0은 단일 ACK, 이후 데이터 단계부터 [ACK|NAK][블록] 응답
+        printf("[DEBUG] Y-MODEM: starting data reception...\r\n");
+    }
+
+    // 데이터 단계 진입
+    session.start_tick = HAL_GetTick();
+    session.packet_number = 1;
+    session.timeout_retries = 0;
+    session.nak_retries = 0;
+    session.wait_start_tick = HAL_GetTick();
+
+    // 슬라이딩 윈도우 상태 초기화 (블록 0은 이미 ACK됨)
+    window_reset(0);
+
+    // 압축 업로드: 파일마다 새 LZ4 프레임
+    // WAV 변환: 파일마다 헤더부터 다시 파싱 (LZ4와 함께면 해제 결과를 변환)
+    if (session.transcode != WAV_NATIVE_NONE) {
+        wav_transcode_init(session.transcode, stage_output);
+    }
+    if (session.compressed) {
+        lz4_stream_init(session.delta ? delta_input :
+                        session.transcode != WAV_NATIVE_NONE ? wav_transcode_input : stage_output);
+    }
+
+    // SD 쓰기를 수신과 겹치기 위해 write-behind 활성화
+    SD_SetWriteBehind(1);
+    SD_TakeWaitCycles();
+    session.stat_ready = STATS_NOW();
+
+    session.state = YMODEM_STATE_DATA;
+    return YMODEM_BUSY;
+}
+
+// 데이터 단계: 패킷 1개 처리
+static YmodemResult_t poll_data(void)
+{
+    UART_HandleTypeDef *huart = session.huart;
+    YmodemPacket_t *pkt = &session.pkt;
+
+    // 패킷 수신 (기대 블록의 페이로드는 스테이징 버퍼의 다음 위치에 직접 착지)
+    // 압축/변환/차등 업로드는 해제·변환·재구성 결과가 스테이징 버퍼로 가므로 ymodem_packet_buffer에 수신
+    bool landing = !session.compressed && session.transcode == WAV_NATIVE_NONE && !session.delta;
+    HAL_StatusTypeDef status = try_receive_packet(pkt, session.packet_number,
+                                                  landing ? &STAGING_BUFFER()[session.write_buffer_offset] : NULL,
+                                                  SD_WRITE_BUFFER_SIZE - session.write_buffer_offset);
+
+    if (status == HAL_BUSY) {
+        // 패킷 대기 중 - 타임아웃 확인 (측정한 응답 시간 기준, 연속 타임아웃마다 2배)
+        if (HAL_GetTick() - session.wait_start_tick <= rtt_timeout_ms(YMODEM_EST_REPLY, 0, session.timeout_retries)) {
+            return YMODEM_BUSY;
+        }
+        status = HAL_TIMEOUT;
+    }
+
+    if (status == HAL_ERROR) {
+        // Y-MODEM-G: 재전송이 없으므로 스트림이 어긋나면 취소
+        if (session.streaming) {
+            cancel_transfer(huart);
+            uart_send_error(501, "Y-MODEM-G stream corrupted");
+            return finish_session(YMODEM_ERROR);
+        }
+
+        // 재동기화 실패 (헤더 후보 없이 링크 조용함, 또는 패킷 중간에 멈춤) = 송신측이 응답 대기 중
+        // 타임아웃/수신 보류 없이 바로 NAK
+        session.nak_retries++;
+        if (session.nak_retries >= YMODEM_MAX_NAK_RETRIES) {
+            transmit_byte(huart, YMODEM_CAN);
+            uart_send_error(501, "Too many NAK retries (resync)");
+            printf("[ERROR] Y-MODEM: NAK retries exceeded (%d) - resync\r\n", session.nak_retries);
+            return finish_session(YMODEM_ERROR);
+        }
+        printf("[WARN] Y-MODEM: resync dropped %lu bytes, NAK block %u (retry %d/%d)\r\n",
+               session.resync_consumed, session.packet_number, session.nak_retries, YMODEM_MAX_NAK_RETRIES);
+        if (session.windowed) {
+            window_send_response(huart, YMODEM_NAK, session.packet_number);
+        } else {
+            transmit_byte(huart, YMODEM_NAK);
+        }
+        session.wait_start_tick = HAL_GetTick();
+        return YMODEM_BUSY;
+    }
+
+    if (status != HAL_OK) {
+        // 타임아웃 - 재시도
+        session.timeout_retries++;
+        if (session.timeout_retries >= YMODEM_MAX_TIMEOUT_RETRIES) {
+            // 최대 재시도 횟수 초과
+            transmit_byte(huart, YMODEM_CAN);
+            uart_send_error(501, "Y-MODEM timeout after retries");
+            printf("[ERROR] Y-MODEM: timeout after %d retries\r\n", session.timeout_retries);
+            return finish_session(YMODEM_TIMEOUT);
+        }
+        // 재시도
+        uint32_t rto = rtt_timeout_ms(YMODEM_EST_REPLY, 0, 0);
+        uint32_t retry_delay = rtt_retry_delay_ms(YMODEM_EST_REPLY, session.timeout_retries - 1);
+        printf("[WARN] Packet timeout, retry %d/%d (rto %lu ms, hold-off %lu ms)\r\n",
+               session.timeout_retries, YMODEM_MAX_TIMEOUT_RETRIES, rto, retry_delay);
+        session.reply_armed = false;
+        if (session.windowed) {
+            // 윈도우 모드: ACK 손실 가능성 - 기대 블록을 NAK으로 재요청
+            window_send_response(huart, YMODEM_NAK, session.packet_number);
+        } else {
+            // 표준 모드: 패킷 또는 ACK 손실 - NAK으로 재전송 요청 (중복 블록이면 다시 ACK)
+            if (!session.streaming) {
+                transmit_byte(huart, YMODEM_NAK);
+            }
+            uart_send_response(ANSI_YELLOW "INFO:" ANSI_RESET " Timeout, retrying...\r\n");
+        }
+        // 응답 간격 추정값만큼 대기 후 재시도 (연속 타임아웃마다 상한 2배)
+        session.rx_header_pending = false;
+        hold_off(retry_delay);
+        session.wait_start_tick = session.holdoff_until;
+        return YMODEM_BUSY;
+    }
+
+    // 수신 성공 시 타임아웃 카운터 리셋
+    session.timeout_retries = 0;
+    session.wait_start_tick = HAL_GetTick();
+
+    if (pkt->header == YMODEM_EOT) {
+        // 윈도우 모드: 누락 블록이 남아 있거나 (재정렬 슬롯에 보관 중)
+        // 마지막 블록들이 오지 않아 블록 0 크기에 못 미치면 EOT 거부 (기대 블록 재요청)
+        if (session.windowed && (window_has_pending() || window_short_of_declared())) {
+            printf("[WARN] Y-MODEM-W: EOT with missing block %u, NAK\r\n", session.packet_number);
+            window_send_response(huart, YMODEM_NAK, session.packet_number);
+            return YMODEM_BUSY;
+        }
+
+        // 압축 업로드: 프레임 종료 마크까지 받아야 완전한 파일
+        if (session.compressed && lz4_stream_status() != LZ4_STREAM_DONE) {
+            printf("[ERROR] Y-MODEM: LZ4 frame incomplete at EOT (%lu bytes decoded)\r\n",
+                   lz4_stream_output_bytes());
+            cancel_transfer(huart);
+            uart_send_error(501, "Incomplete LZ4 stream");
+            return finish_session(YMODEM_ERROR);
+        }
+
+        // 차등 업로드: 종료 명령(새 파일 CRC-32)까지 받아야 완전한 파일
+        if (session.delta && delta_stream_status() != DELTA_STREAM_DONE) {
+            printf("[ERROR] Y-MODEM: delta stream incomplete at EOT (%lu bytes rebuilt)\r\n", session.total_bytes);
+            cancel_transfer(huart);
+            uart_send_error(501, "Incomplete delta stream");
+            return finish_session(YMODEM_ERROR);
+        }
+
+        // WAV 변환: 변환된 크기로 자름 (블록 0 크기는 원본 크기, 변환 안 한 파일은 그대로)
+        if (session.transcode != WAV_NATIVE_NONE) {
+            if (wav_transcode_finish() != 0) {
+                transmit_byte(huart, YMODEM_CAN);
+                uart_send_error(405, "Final SD write error");
+                return finish_session(YMODEM_ERROR);
+            }
+            if (wav_transcode_output_size() != 0) {
+                session.expected_size = wav_transcode_output_size();
+            }
+        }
+
+        // 전송 완료 - 남은 버퍼 데이터를 512 배수로 패딩하여 쓰기 후 정확한 크기로 자름
+        if (flush_staging_final() != YMODEM_OK || truncate_to_exact_size() != YMODEM_OK) {
+            transmit_byte(huart, YMODEM_CAN);
+            uart_send_error(405, "Final SD write error");
+            return finish_session(YMODEM_ERROR);
+        }
+
+        // 차등 업로드: 재구성한 파일의 다이제스트가 송신측 CRC-32와 같아야 기존 파일 교체
+        if (session.delta && (!session.digest_valid || session.digest != delta_stream_expected_crc())) {
+            printf("[ERROR] Y-MODEM delta: rebuilt CRC-32 %08lX, expected %08lX\r\n",
+                   session.digest, delta_stream_expected_crc());
+            cancel_transfer(huart);
+            uart_send_error(501, "Delta sync verification failed");
+            return finish_session(YMODEM_ERROR);
+        }
+
+        if (session.windowed) {
+            window_send_response(huart, YMODEM_ACK, (uint8_t)(session.packet_number - 1));
+        } else {
+            transmit_byte(huart, YMODEM_ACK);
+        }
+
+        // 배치 전송: 파일을 닫고 다음 블록 0 요청 (송신측은 다음 파일 또는 빈 블록 0 전송)
+        if (session.batch) {
+            close_file(true);
+            session.files_received++;
+            printf("[DEBUG] Y-MODEM batch: %s complete (%lu bytes)\r\n", session.path, session.total_bytes);
+
+            transmit_byte(huart, session.handshake);
+            session.state = YMODEM_STATE_HANDSHAKE;
+            session.handshake_retries = 1;
+            session.handshake_start_tick = HAL_GetTick();
+            session.wait_start_tick = HAL_GetTick();
+            return YMODEM_BUSY;
+        }
+
+        session.files_received++;
+        uart_send_response(ANSI_GREEN "INFO:" ANSI_RESET " Transfer complete (%lu bytes)\r\n", session.total_bytes);
+        if (session.total_bytes > session.resume_offset) {
+            // 페이로드 1바이트당 CPU 복사 횟수 (x100)
+            uint32_t copy_ratio = (uint32_t)(((uint64_t)session.copy_bytes * 100) /
+                                             (session.total_bytes - session.resume_offset));
+            printf("[DEBUG] Y-MODEM: %lu.%02lu bytes copied per payload byte\r\n",
+                   copy_ratio / 100, copy_ratio % 100);
+        }
+        if (session.resync_count > 0) {
+            printf("[DEBUG] Y-MODEM: %lu resyncs, %lu bytes discarded\r\n",
+                   session.resync_count, session.resync_discarded);
+        }
+        return finish_session(YMODEM_OK);
+    }
+
+    if (pkt->header == YMODEM_CAN) {
+        // 전송 취소
+        uart_send_response(ANSI_YELLOW "INFO:" ANSI_RESET " Transfer cancelled by sender\r\n");
+        return finish_session(YMODEM_CANCELLED);
+    }
+
+    // 데이터 패킷
+    uint16_t data_size = pkt->data_size;
+    uint8_t blk_num = pkt->blk;
+    uint8_t blk_num_inv = pkt->blk_inv;
+
+    // 블록 번호 확인
+    if (blk_num != (uint8_t)(~blk_num_inv)) {
+        if (session.streaming) {
+            // Y-MODEM-G: 재전송이 없으므로 즉시 취소
+            printf("[ERROR] Y-MODEM-G: block number corrupted (blk=%u, ~blk=%u)\r\n",
+                   blk_num, blk_num_inv);
+            cancel_transfer(huart);
+            uart_send_error(501, "Y-MODEM-G block number error");
+            return finish_session(YMODEM_ERROR);
+        }
+        // 블록 번호 오류 - NAK 재시도
+        session.nak_retries++;
+        if (session.nak_retries >= YMODEM_MAX_NAK_RETRIES) {
+            // 최대 NAK 재시도 횟수 초과
+            transmit_byte(huart, YMODEM_CAN);
+            uart_send_error(501, "Too many NAK retries (block number)");
+            printf("[ERROR] Y-MODEM: NAK retries exceeded (%d) - block number mismatch\r\n", session.nak_retries);
+            return finish_session(YMODEM_ERROR);
+        }
+        printf("[ERROR] Block number mismatch: blk=%u, ~blk=%u (NAK retry %d/%d)\r\n",
+               blk_num, blk_num_inv, session.nak_retries, YMODEM_MAX_NAK_RETRIES);
+        if (session.windowed) {
+            window_send_response(huart, YMODEM_NAK, session.packet_number);
+        } else {
+            transmit_byte(huart, YMODEM_NAK);
+        }
+        return YMODEM_BUSY;
+    }
+
+    // 버린 확장 블록: 직전 블록 재전송(ACK 손실)이면 ACK만, 아니면 스테이징 경계 불일치로 취소
+    if (pkt->payload == NULL) {
+        if (!session.streaming && blk_num == (uint8_t)(session.packet_number - 1)) {
+            printf("[WARN] Duplicate block %u (ACK lost), re-ACK\r\n", blk_num);
+            transmit_byte(huart, YMODEM_ACK);
+            return YMODEM_BUSY;
+        }
+        printf("[ERROR] Y-MODEM: 8KB block %u (expected %u) at staging offset %lu\r\n",
+               blk_num, session.packet_number, session.write_buffer_offset);
+        cancel_transfer(huart);
+        uart_send_error(501, "Y-MODEM 8KB block not aligned");
+        return finish_session(YMODEM_ERROR);
+    }
+
+    // 수신 인터럽트의 추적 기록 (헤더 위치가 일치할 때만: 마지막 바이트 도착 시각, 누적 CRC)
+    CdcRxPacket_t rx_record;
+    bool rx_recorded = session.rx_tracked && cdc_rx_crc_take(session.rx_header_pos, &rx_record) &&
+                       rx_record.size == data_size;
+
+    // CRC 확인 (확장 블록은 CRC-32)
+    uint32_t crc_received;
+    uint32_t crc_calculated;
+    uint32_t crc_start = STATS_NOW();
+    if (pkt->header == YMODEM_LBLK) {
+        crc_received = ((uint32_t)pkt->crc[0] << 24) | ((uint32_t)pkt->crc[1] << 16) |
+                       ((uint32_t)pkt->crc[2] << 8) | pkt->crc[3];
+        crc_calculated = crc32_update(0, pkt->payload, data_size);
+    } else {
+        crc_received = (pkt->crc[0] << 8) | pkt->crc[1];
+        if (session.rx_crc && rx_recorded && rx_record.crc_valid) {
+            crc_calculated = rx_record.crc;     // 수신 중에 계산 완료: 비교만
+        } else {
+            crc_calculated = crc16_ccitt(pkt->payload, data_size);
+        }
+    }
+    STATS_ADD(YMODEM_PHASE_CRC, crc_start);
+
+    if (crc_received != crc_calculated) {
+        if (session.streaming) {
+            // Y-MODEM-G: 재전송이 없으므로 즉시 취소
+            printf("[ERROR] Y-MODEM-G: CRC mismatch at packet %d (received=0x%04lX, calculated=0x%04lX)\r\n",
+                   session.packet_number, crc_received, crc_calculated);
+            cancel_transfer(huart);
+            uart_send_error(501, "Y-MODEM-G CRC error");
+            return finish_session(YMODEM_CRC_ERROR);
+        }
+        // CRC 오류 - NAK 재시도
+        session.nak_retries++;
+        if (session.nak_retries >= YMODEM_MAX_NAK_RETRIES) {
+            // 최대 NAK 재시도 횟수 초과
+            transmit_byte(huart, YMODEM_CAN);
+            uart_send_error(501, "Too many NAK retries (CRC error)");
+            printf("[ERROR] Y-MODEM: NAK retries exceeded (%d) - CRC mismatch\r\n", session.nak_retries);
+            return finish_session(YMODEM_ERROR);
+        }
+        printf("[ERROR] CRC mismatch! received=0x%04lX, calculated=0x%04lX (NAK retry %d/%d)\r\n",
+               crc_received, crc_calculated, session.nak_retries, YMODEM_MAX_NAK_RETRIES);
+        if (session.windowed) {
+            // 윈도우 모드: 손상된 블록 번호는 신뢰할 수 없으므로 기대 블록만 재요청
+            window_send_response(huart, YMODEM_NAK, session.packet_number);
+        } else {
+            transmit_byte(huart, YMODEM_NAK);
+            uart_send_response(ANSI_YELLOW "INFO:" ANSI_RESET " CRC error, retrying...\r\n");
+        }
+        return YMODEM_BUSY;
+    }
+
+    // 슬라이딩 윈도우: 재정렬/중복 제거/누적 ACK는 별도 처리
+    if (session.windowed) {
+        if (window_receive(huart, blk_num, pkt->payload, data_size, &session.packet_number) != YMODEM_OK) {
+            transmit_byte(huart, YMODEM_CAN);
+            uart_send_error(405, "SD write error");
+            return finish_session(YMODEM_ERROR);
+        }
+        session.nak_retries = 0;
+        reply_arm();
+        return YMODEM_BUSY;
+    }
+
+    // 블록 순서 확인
+    if (blk_num != session.packet_number) {
+        // Y-MODEM-G: 패킷 누락은 복구할 수 없으므로 취소
+        if (session.streaming) {
+            printf("[ERROR] Y-MODEM-G: out of sequence (expected=%u, got=%u)\r\n",
+                   session.packet_number, blk_num);
+            cancel_transfer(huart);
+            uart_send_error(501, "Y-MODEM-G packet lost");
+            return finish_session(YMODEM_ERROR);
+        }
+
+        // 직전 블록 재전송 = ACK 손실: 파일에 다시 쓰지 않고 ACK만 재전송
+        if (blk_num == (uint8_t)(session.packet_number - 1)) {
+            printf("[WARN] Duplicate block %u (ACK lost), re-ACK\r\n", blk_num);
+            transmit_byte(huart, YMODEM_ACK);
+            return YMODEM_BUSY;
+        }
+
+        // 그 외 순서 오류 - NAK 재시도
+        session.nak_retries++;
+        if (session.nak_retries >= YMODEM_MAX_NAK_RETRIES) {
+            transmit_byte(huart, YMODEM_CAN);
+            uart_send_error(501, "Too many NAK retries (sequence)");
+            printf("[ERROR] Y-MODEM: NAK retries exceeded (%d) - out of sequence\r\n", session.nak_retries);
+            return finish_session(YMODEM_ERROR);
+        }
+        printf("[ERROR] Out of sequence: expected=%u, got=%u (NAK retry %d/%d)\r\n",
+               session.packet_number, blk_num, session.nak_retries, YMODEM_MAX_NAK_RETRIES);
+        transmit_byte(huart, YMODEM_NAK);
+        return YMODEM_BUSY;
+    }
+
+    // 패킷 데이터를 버퍼에 추가 (8KB 버퍼링으로 SD 카드 수명 보호)
+    // Python은 Stop-and-Wait ARQ로 ACK를 30초 대기하므로 안전
+    if (consume_payload(pkt->payload, data_size) != YMODEM_OK) {
+        transmit_byte(huart, YMODEM_CAN);
+        uart_send_error(405, "SD write error");
+        return finish_session(YMODEM_ERROR);
+    }
+    session.packet_number++;
+
+    // 패킷 성공 시 NAK 카운터 리셋
+    session.nak_retries = 0;
+
+    // Y-MODEM-G: ACK/안정화 지연 없이 바로 다음 패킷 수신
+    // (SD 쓰기는 write-behind로 진행, 다음 f_write()에서 완료 확인)
+    if (session.streaming) {
+        reply_arm();
+        return YMODEM_BUSY;
+    }
+
+    // 차등 업로드: 블록 참조 복사를 poll마다 나눠 진행하고 끝난 뒤 ACK (표준 모드 전용)
+    if (session.delta) {
+        YmodemResult_t copy = delta_resume();
+        if (copy == YMODEM_ERROR) {
+            transmit_byte(huart, YMODEM_CAN);
+            uart_send_error(405, "SD write error");
+            return finish_session(YMODEM_ERROR);
+        }
+        if (copy == YMODEM_BUSY) {
+            session.delta_ack_pending = true;
+            return YMODEM_BUSY;
+        }
+    }
+
+    return ack_data_packet(rx_recorded ? &rx_record : NULL);
+}
+
+// 데이터 패킷 ACK + 다음 패킷까지 수신 보류
+// rx_record: 수신 인터럽트의 추적 기록 (마지막 바이트 → ACK 측정, 없으면 NULL)
+static YmodemResult_t ack_data_packet(const CdcRxPacket_t *rx_record)
+{
+    UART_HandleTypeDef *huart = session.huart;
+
+    // ACK 전송
+    // 8KB마다 SD DMA 쓰기를 시작만 하고 바로 ACK (완료 대기 없음)
+    // 카드 프로그래밍은 다음 8KB를 수신하는 동안 진행
+    HAL_StatusTypeDef ack_status = transmit_byte(huart, YMODEM_ACK);
+    if (rx_record != NULL) {
+        STATS_ADD(YMODEM_PHASE_LAST_TO_ACK, rx_record->done_cycles);
+    }
+
+    // ACK 전송 실패 시에만 로그
+    if (ack_status != HAL_OK) {
+        printf("[WARN] ACK send failed for packet %d, status=%d\r\n", session.packet_number, ack_status);
+    }
+    reply_arm();
+
+    // 추가 안정화 지연 (USB CDC 핸드셰이킹)
+    // 모든 패킷에서 필수 (제거 시 ACK 손실로 타임아웃 발생)
+    // 메인 루프를 막지 않도록 다음 poll까지 8ms 동안 수신 보류
+    hold_off(8);
+    session.wait_start_tick = session.holdoff_until;
+
+    return YMODEM_BUSY;
+}
+
+// 세션 종료: 파일 닫기, SD/CDC 모드 복구
+static YmodemResult_t finish_session(YmodemResult_t result)
+{
+    // 파일 정상 종료 (실패/취소면 진행 기록을 남겨 재개 가능)
+    // 송신은 읽기 전용이므로 닫기만
+    if (session.state == YMODEM_STATE_SEND) {
+        if (session.file_open) {
+            f_close(&session.file);
+            session.file_open = false;
+        }
+    } else {
+        close_file(result == YMODEM_OK);
+        if (session.delta) {
+            result = delta_finish(result);
+        }
+    }
+
+    // SD 드라이버 동기 쓰기 모드 복귀 (f_close()에서 이미 완료 확인됨)
+    SD_SetWriteBehind(0);
+
+    // Y-MODEM 처리 종료
+    extern volatile uint8_t g_ymodem_active;
+    g_ymodem_active = 0;
+
+    // USB CDC 모드 해제
+    if (session.huart == NULL && session.link == NULL) {
+        CDC_Set_YModem_Mode(false);
+    }
+    session.link = NULL;
+
+    session.state = YMODEM_STATE_IDLE;
+    session.result = result;
+    return result;
+}
+
+// 패킷 수신 시도 (비차단)
+// 헤더(SOH/STX, BLK, ~BLK)와 CRC는 pkt에, 페이로드는 착지 위치에 직접 수신 (scatter)
+// 블록 번호가 landing_blk이고 landing_room에 들어가면 landing에, 아니면 ymodem_packet_buffer에 수신
+// USB CDC: 패킷 전체가 수신 버퍼(링 버퍼/슬롯 풀)에 들어온 뒤에만 읽음 (대기 없음)
+// UART: 헤더 1바이트만 즉시 확인, 이후 나머지는 차단 수신 (최대 1029바이트 전송 시간)
+// 잘못된 헤더는 재동기화(resync_scan)로 다음 헤더 후보까지 버림
+// 반환값: HAL_OK (패킷 완성), HAL_BUSY (대기/재동기화 중), HAL_TIMEOUT (패킷 중간 타임아웃),
+//         HAL_ERROR (재동기화 실패 또는 패킷 중간 멈춤 → 호출측 즉시 NAK, Y-MODEM-G는 잘못된 헤더)
+static HAL_StatusTypeDef try_receive_packet(YmodemPacket_t *pkt, uint8_t landing_blk,
+                                            uint8_t *landing, uint32_t landing_room)
+{
+    UART_HandleTypeDef *huart = session.huart;
+    uint8_t blk[2];
+
+    // 헤더 수신 (재동기화 중이면 바이트를 버리면서 헤더 후보 탐색)
+    if (!session.rx_header_pending) {
+        HAL_StatusTypeDef scan = HAL_OK;
+
+        if (session.resync) {
+            scan = resync_scan(pkt);
+        } else if (!read_byte_nowait(&pkt->header)) {
+            return HAL_BUSY;
+        } else if ((pkt->header == YMODEM_EOT || pkt->header == YMODEM_CAN) &&
+                   (huart != NULL || link_available() == 0)) {
+            // EOT/CAN 뒤에는 송신측이 응답을 기다리므로 이미 도착한 바이트가 있으면 패킷 잔여 바이트로 간주
+            // (CAN CAN은 재동기화에서 취소로 전달)
+            pkt->data_size = 0;
+        } else if (header_data_size(pkt->header, &pkt->data_size)) {
+            session.rx_blk_known = false;
+        } else {
+            if (huart == NULL) {
+                printf("[WARN] receive_packet: invalid header 0x%02X, resync\r\n", pkt->header);
+            }
+            // Y-MODEM-G 데이터 단계는 재전송이 없으므로 재동기화하지 않음 (취소 CAN CAN만 확인)
+            if (session.streaming && session.state == YMODEM_STATE_DATA && pkt->header != YMODEM_CAN) {
+                return HAL_ERROR;
+            }
+            resync_start(pkt->header);
+            scan = resync_scan(pkt);
+        }
+        if (scan != HAL_OK) {
+            return scan;
+        }
+
+        // 응답 시간 측정 (재동기화를 거친 헤더는 resync_start()에서 측정 취소)
+        if (session.reply_armed) {
+            session.reply_armed = false;
+            rtt_sample(YMODEM_EST_REPLY, DWT->CYCCNT - session.reply_mark);
+        }
+
+        if (pkt->data_size == 0) {
+            session.stat_packet_done = true;
+            return HAL_OK;
+        }
+
+        session.rx_header_pending = true;
+        session.rx_header_tick = HAL_GetTick();
+        session.rx_last_tick = session.rx_header_tick;
+        session.rx_last_count = 0;
+        session.rx_header_cycles = DWT->CYCCNT;
+        if (session.rx_tracked) {
+            // 헤더 바이트 위치 (재동기화로 찾은 헤더는 BLK/~BLK까지 읽은 상태)
+            session.rx_header_pos = cdc_rx_crc_position() - (session.rx_blk_known ? 3 : 1);
+        }
+        STATS_ADD(YMODEM_PHASE_WAIT_HEADER, session.stat_ready);
+        session.stat_header = STATS_NOW();
+    }
+
+    // 나머지: BLK(1) + ~BLK(1) + DATA(128/1024/8192) + CRC(2/4)
+    uint16_t crc_size = (pkt->header == YMODEM_LBLK) ? 4 : 2;
+    uint16_t remaining = (session.rx_blk_known ? 0 : 2) + pkt->data_size + crc_size;
+
+    if (huart == NULL) {
+        uint32_t available = link_available();
+        if (available < remaining) {
+            uint32_t now = HAL_GetTick();
+            if (available != session.rx_last_count) {
+                session.rx_last_count = available;
+                session.rx_last_tick = now;
+            }
+
+            // 패킷 중간에 링크가 조용함 = 꼬리 손실 (송신측은 응답 대기 중)
+            // 대기 중인 바이트는 모두 이 패킷의 앞부분이므로 버리고 바로 NAK
+            // (Y-MODEM-G는 복구 불가이므로 타임아웃까지 대기)
+            if (!session.streaming && now - session.rx_last_tick >= YMODEM_RESYNC_QUIET_MS) {
+                printf("[WARN] receive_packet: stalled at %lu/%u bytes, discarding\r\n", available, remaining);
+                session.rx_header_pending = false;
+                session.rx_blk_known = false;
+                for (uint32_t n = available; n > 0; ) {
+                    uint32_t got = link_read(ymodem_packet_buffer, (n > YMODEM_PACKET_SIZE) ? YMODEM_PACKET_SIZE : n);
+                    if (got == 0) {
+                        break;
+                    }
+                    n -= got;
+                }
+                session.resync_consumed = 1 + available;
+                session.resync_count++;
+                session.resync_discarded += session.resync_consumed;
+                return HAL_ERROR;
+            }
+
+            // 패킷 중간 대기 타임아웃: 1KB당 측정한 수신 시간 x 패킷 크기 (측정값이 없으면 5초)
+            // 여기까지 오는 것은 Y-MODEM-G뿐이고 복구할 수 없으므로 백오프 2단계(4배) 여유
+            if (now - session.rx_header_tick > rtt_timeout_ms(YMODEM_EST_PAYLOAD, pkt->data_size, 2)) {
+                printf("[ERROR] receive_packet: data read failed (expected=%u, got=%lu)\r\n",
+                       remaining, available);
+                session.rx_header_pending = false;
+                return HAL_TIMEOUT;
+            }
+            return HAL_BUSY;
+        }
+    }
+    session.rx_header_pending = false;
+
+    if (session.rx_blk_known) {
+        session.rx_blk_known = false;
+    } else {
+        if (receive_bytes(huart, blk, 2) != HAL_OK) {
+            return HAL_TIMEOUT;
+        }
+        pkt->blk = blk[0];
+        pkt->blk_inv = blk[1];
+    }
+
+    // 착지 위치 결정: 기대 블록이면 스테이징 버퍼에 직접 (CRC 실패 시 오프셋을 올리지 않으므로 덮어씀)
+    if (landing != NULL && pkt->blk == landing_blk &&
+        pkt->blk == (uint8_t)(~pkt->blk_inv) && pkt->data_size <= landing_room) {
+        pkt->payload = landing;
+    } else if (pkt->data_size <= YMODEM_PACKET_SIZE) {
+        pkt->payload = ymodem_packet_buffer;
+    } else {
+        // 확장 블록이 스테이징 버퍼에 들어가지 않음 (중복/순서 오류/경계 불일치): 읽어서 버림
+        pkt->payload = NULL;
+        for (uint16_t done = 0; done < pkt->data_size; done += YMODEM_PACKET_SIZE) {
+            if (receive_bytes(huart, ymodem_packet_buffer, YMODEM_PACKET_SIZE) != HAL_OK) {
+                return HAL_TIMEOUT;
+            }
+        }
+    }
+
+    // DATA(128/1024/8192) + CRC(2/4)
+    if ((pkt->payload != NULL && receive_bytes(huart, pkt->payload, pkt->data_size) != HAL_OK) ||
+        receive_bytes(huart, pkt->crc, crc_size) != HAL_OK) {
+        return HAL_TIMEOUT;
+    }
+
+    // 복사량 계측: USB CDC 링 버퍼 방식은 USB 버퍼→링 버퍼(인터럽트) + 링 버퍼→착지 위치,
+    // 수신 슬롯 풀(CDC_RX_ZERO_COPY)은 슬롯→착지 위치만
+    session.copy_bytes += (huart == NULL && !CDC_RX_ZERO_COPY) ? 2 * pkt->data_size : pkt->data_size;
+
+    // 패킷 수신 시간 (1KB당, USB CDC만 - UART는 차단 수신)
+    if (huart == NULL) {
+        rtt_sample(YMODEM_EST_PAYLOAD,
+                   (uint32_t)(((uint64_t)(DWT->CYCCNT - session.rx_header_cycles) * 1024) / pkt->data_size));
+    }
+
+    STATS_ADD(YMODEM_PHASE_PAYLOAD_RX, session.stat_header);
+    session.stat_packet_done = true;
+
+    return HAL_OK;
+}
+
+// 지정 길이 수신 (USB CDC 링 버퍼 또는 UART)
+// USB CDC는 try_receive_packet()에서 데이터 도착을 확인한 뒤 호출하므로 대기 없음
+static HAL_StatusTypeDef receive_bytes(UART_HandleTypeDef *huart, uint8_t *buffer, uint16_t length)
+{
+    if (huart == NULL) {
+        return (link_read(buffer, length) == length) ? HAL_OK : HAL_TIMEOUT;
+    } else {
+        return HAL_UART_Receive(huart, buffer, length, YMODEM_TIMEOUT_MS);
+    }
+}
+
+// USB CDC 수신 데이터 (대체 링크가 있으면 그 링크)
+// 수신 대기 바이트 1개 읽기 (비차단)
+static bool read_byte_nowait(uint8_t *byte)
+{
+    if (session.huart == NULL) {
+        return link_available() > 0 && link_read(byte, 1) == 1;
+    }
+    return HAL_UART_Receive(session.huart, byte, 1, 0) == HAL_OK;
+}
+
+// 헤더 바이트로 데이터 크기 결정 (확장 블록은 협상된 데이터 단계에서만)
+static bool header_data_size(uint8_t header, uint16_t *size)
+{
+    if (header == YMODEM_SOH) {
+        *size = 128;
+    } else if (header == YMODEM_STX) {
+        *size = YMODEM_PACKET_SIZE;
+    } else if (header == YMODEM_LBLK && session.large_blocks && session.state == YMODEM_STATE_DATA) {
+        *size = YMODEM_LARGE_PACKET_SIZE;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// 재동기화 시작: first는 방금 읽은 잘못된 헤더 바이트
+static void resync_start(uint8_t first)
+{
+    session.resync = true;
+    session.resync_window[2] = first;
+    session.resync_fill = 1;
+    session.resync_consumed = 1;
+    session.resync_count++;
+    session.rx_last_tick = HAL_GetTick();
+    session.reply_armed = false;        // 잡음이 섞인 구간은 응답 시간으로 측정하지 않음
+}
+
+// 재동기화: 바이트를 하나씩 버리면서 최근 3바이트가 그럴듯한 헤더인지 확인
+// 후보 = 헤더 + BLK/~BLK 보수 일치 + BLK가 기대 블록 또는 직전 블록 (핸드셰이크는 블록 0, 윈도우는 윈도우 범위)
+// 후보의 CRC가 틀리면 일반 CRC 오류로 NAK, CAN CAN은 취소로 전달
+// 반환값: HAL_OK (후보 발견, pkt에 헤더/BLK 설정), HAL_BUSY (계속 탐색), HAL_ERROR (후보 없이 링크 조용함)
+static HAL_StatusTypeDef resync_scan(YmodemPacket_t *pkt)
+{
+    uint8_t *w = session.resync_window;
+    uint8_t byte;
+
+    for (uint32_t n = 0; n < YMODEM_RESYNC_SCAN_MAX && read_byte_nowait(&byte); n++) {
+        w[0] = w[1];
+        w[1] = w[2];
+        w[2] = byte;
+        if (session.resync_fill < 3) {
+            session.resync_fill++;
+        }
+        session.resync_consumed++;
+        session.rx_last_tick = HAL_GetTick();
+
+        if (w[1] == YMODEM_CAN && w[2] == YMODEM_CAN) {
+            session.resync = false;
+            pkt->header = YMODEM_CAN;
+            pkt->data_size = 0;
+            return HAL_OK;
+        }
+
+        if (session.resync_fill < 3 || w[1] != (uint8_t)~w[2] || !header_data_size(w[0], &pkt->data_size)) {
+            continue;
+        }
+
+        uint8_t expected = (session.state == YMODEM_STATE_DATA) ? session.packet_number : 0;
+        bool plausible = (w[1] == expected) ||
+                         (session.state == YMODEM_STATE_DATA && w[1] == (uint8_t)(expected - 1)) ||
+                         (session.windowed && (uint8_t)(w[1] - expected) < YMODEM_WINDOW_SIZE);
+        if (!plausible) {
+            continue;
+        }
+
+        session.resync = false;
+        session.resync_discarded += session.resync_consumed - 3;
+        pkt->header = w[0];
+        pkt->blk = w[1];
+        pkt->blk_inv = w[2];
+        session.rx_blk_known = true;
+        printf("[WARN] Y-MODEM: resync on block %u after %lu bytes\r\n", w[1], session.resync_consumed - 3);
+        return HAL_OK;
+    }
+
+    if (HAL_GetTick() - session.rx_last_tick < YMODEM_RESYNC_QUIET_MS) {
+        return HAL_BUSY;
+    }
+
+    session.resync = false;
+    session.resync_discarded += session.resync_consumed;
+    return HAL_ERROR;
+}
+
+static uint32_t link_available(void)
+{
+    return (session.link != NULL) ? session.link->available() : CDC_Available_Data();
+}
+
+static uint32_t link_read(uint8_t *data, uint32_t length)
+{
+    return (session.link != NULL) ? session.link->read(data, length) : CDC_Read_Data(data, length, 0);
+}
+
+// 단일 바이트 전송 (UART 또는 USB CDC)
+static HAL_StatusTypeDef transmit_byte(UART_HandleTypeDef *huart, uint8_t data)
+{
+    return transmit_frame(huart, &data, 1);
+}
+
+// 응답 프레임 전송 (윈도우 모드의 [ACK|NAK][블록]처럼 여러 바이트를 한 USB 패킷으로)
+static HAL_StatusTypeDef transmit_frame(UART_HandleTypeDef *huart, const uint8_t *data, uint16_t len)
+{
+    uint32_t start = STATS_NOW();
+    HAL_StatusTypeDef status = transmit_frame_raw(huart, data, len);
+
+    STATS_ADD(YMODEM_PHASE_ACK_TX, start);
+    return status;
+}
+
+static HAL_StatusTypeDef transmit_frame_raw(UART_HandleTypeDef *huart, const uint8_t *data, uint16_t len)
+{
+    if (huart == NULL && session.link != NULL) {
+        return session.link->transmit(data, len);
+    }
+    if (huart == NULL) {
+        // USB CDC 모드 - 전송 큐에 넣고 바로 반환 (응답과 같은 큐이므로 순서 유지)
+        // 전송 완료/ZLP는 CDC_TransmitCplt_HS에서 처리, 큐 적재 → 완료 지연은 YSTATS TX_QUEUE
+        if (!CDC_Queue_Transmit(data, len)) {
+            printf("[ERROR] transmit_byte: CDC TX queue full (%u bytes)\r\n", len);
+            return HAL_ERROR;
+        }
+        return HAL_OK;
+    } else {
+        // UART 모드
+        return HAL_UART_Transmit(huart, (uint8_t*)data, len, 500);  // 100 → 500ms
+    }
+}
+
+// 전송 취소 (CAN 2회 - 송신측이 단일 CAN을 노이즈로 무시하지 않도록)
+static void cancel_transfer(UART_HandleTypeDef *huart)
+{
+    transmit_byte(huart, YMODEM_CAN);
+    transmit_byte(huart, YMODEM_CAN);
+}
+
+// 데이터 블록 페이로드 처리: 압축 업로드면 LZ4 해제 후 (변환/재구성 후) 스테이징
+// 변환 업로드면 변환 후, 차등 업로드면 재구성 후 스테이징
+// LZ4 프레임 종료 이후의 바이트 (마지막 블록의 0x1A 패딩)는 해제기가, WAV data 청크 이후는 변환기가 무시
+static YmodemResult_t consume_payload(const uint8_t *data, uint16_t size)
+{
+    session.wire_bytes += size;
+
+    if (session.compressed) {
+        return (lz4_stream_decode(data, size) == LZ4_STREAM_ERROR) ? YMODEM_ERROR : YMODEM_OK;
+    }
+    if (session.delta) {
+        return (delta_input(data, size) != 0) ? YMODEM_ERROR : YMODEM_OK;
+    }
+    if (session.transcode != WAV_NATIVE_NONE) {
+        return (wav_transcode_input(data, size) != 0) ? YMODEM_ERROR : YMODEM_OK;
+    }
+
+    return stage_payload(data, size);
+}
+
+// LZ4 해제/WAV 변환 출력 콜백 (매치는 최대 64KB까지 한 번에 나오므로 나눠서 스테이징)
+static int stage_output(const uint8_t *data, uint32_t size)
+{
+    while (size > 0) {
+        uint16_t chunk = (size > SD_WRITE_BUFFER_SIZE) ? SD_WRITE_BUFFER_SIZE : (uint16_t)size;
+        if (stage_payload(data, chunk) != YMODEM_OK) {
+            return -1;
+        }
+        data += chunk;
+        size -= chunk;
+    }
+    return 0;
+}
+
+// 차등 업로드 준비: 기존 파일을 블록 참조 원본으로 열고 "<경로>.dsy"에 새 파일 생성
+static YmodemResult_t delta_open(const char *file_path)
+{
+    char tmp_path[YMODEM_PATH_MAX];
+
+    int len = snprintf(tmp_path, sizeof(tmp_path), "%s" YMODEM_DELTA_SUFFIX, file_path);
+    if (len < 0 || (uint32_t)len >= sizeof(tmp_path)) {
+        uart_send_error(401, "Path too long for delta upload");
+        return YMODEM_ERROR;
+    }
+
+    FRESULT fres = f_open(&delta_basis, file_path, FA_READ);
+    if (fres != FR_OK) {
+        printf("[ERROR] Y-MODEM delta: basis %s open failed: fres=%d\r\n", file_path, fres);
+        uart_send_error(404, "No existing file for delta upload");
+        return YMODEM_ERROR;
+    }
+
+    if (open_file(tmp_path, 0) != YMODEM_OK) {
+        f_close(&delta_basis);
+        return YMODEM_ERROR;
+    }
+
+    delta_stream_init((uint32_t)f_size(&delta_basis), stage_output, delta_copy);
+    printf("[DEBUG] Y-MODEM delta: basis %s (%lu bytes), rebuilding into %s\r\n",
+           file_path, (uint32_t)f_size(&delta_basis), tmp_path);
+    return YMODEM_OK;
+}
+
+// 차등 업로드 종료 (파일은 이미 닫힌 상태)
+// 성공: 기존 파일 삭제 후 임시 파일/다이제스트 이름 변경, 이전 서명 삭제
+// 실패/취소: 임시 파일과 진행 기록/다이제스트만 삭제 (기존 파일 유지)
+static YmodemResult_t delta_finish(YmodemResult_t result)
+{
+    char target[YMODEM_PATH_MAX];
+    char from[YMODEM_PATH_MAX + sizeof(YMODEM_PROGRESS_SUFFIX)];
+    char to[YMODEM_PATH_MAX + sizeof(YMODEM_PROGRESS_SUFFIX)];
+    uint32_t target_len = strlen(session.path) - (sizeof(YMODEM_DELTA_SUFFIX) - 1);
+
+    f_close(&delta_basis);
+    session.delta = false;
+    memcpy(target, session.path, target_len);
+    target[target_len] = '\0';
+
+    if (result != YMODEM_OK) {
+        f_unlink(session.path);
+        snprintf(from, sizeof(from), "%s" YMODEM_PROGRESS_SUFFIX, session.path);
+        f_unlink(from);
+        snprintf(from, sizeof(from), "%s" YMODEM_DIGEST_SUFFIX, session.path);
+        f_unlink(from);
+        printf("[WARN] Y-MODEM delta: %s kept unchanged\r\n", target);
+        return result;
+    }
+
+    // f_rename()은 대상이 있으면 실패하므로 기존 파일을 먼저 삭제
+    // (이 사이에 전원이 꺼지면 새 파일은 "<경로>.dsy"로 남음)
+    FRESULT fres = f_unlink(target);
+    if (fres == FR_OK || fres == FR_NO_FILE) {
+        fres = f_rename(session.path, target);
+    }
+    if (fres != FR_OK) {
+        printf("[ERROR] Y-MODEM delta: rename %s -> %s failed: fres=%d\r\n", session.path, target, fres);
+        uart_send_error(405, "Delta sync rename failed");
+        return YMODEM_ERROR;
+    }
+
+    snprintf(from, sizeof(from), "%s" YMODEM_DIGEST_SUFFIX, session.path);
+    snprintf(to, sizeof(to), "%s" YMODEM_DIGEST_SUFFIX, target);
+    f_unlink(to);
+    f_rename(from, to);
+    snprintf(to, sizeof(to), "%s" DELTA_SIG_SUFFIX, target);
+    f_unlink(to);   // 서명은 이전 내용 기준
+
+    printf("[DEBUG] Y-MODEM delta: %s rebuilt, %lu literal + %lu copied bytes, %lu bytes on link\r\n",
+           target, delta_stream_literal_bytes(), delta_stream_copied_bytes(), session.wire_bytes);
+    strcpy(session.path, target);
+    return YMODEM_OK;
+}
+
+// 차등 스트림 입력 (데이터 블록 또는 LZ4 해제 출력)
+// 압축 차등 업로드는 LZ4 출력 콜백: 블록 참조에서 멈추면 LZ4 해제도 멈춤 (남은 출력은 히스토리에 유지)
+static int delta_input(const uint8_t *data, uint32_t size)
+{
+    DeltaStreamStatus_t status = delta_stream_decode(data, size);
+
+    if (status == DELTA_STREAM_ERROR) {
+        return -1;
+    }
+    if (status == DELTA_STREAM_COPY && session.compressed) {
+        lz4_stream_pause();
+    }
+    return 0;
+}
+
+// 차등 해석 또는 (압축 차등 업로드의) LZ4 해제가 블록 참조에서 멈춰 있는지
+static bool delta_paused(void)
+{
+    return delta_stream_status() == DELTA_STREAM_COPY ||
+           (session.compressed && lz4_stream_status() == LZ4_STREAM_PAUSED);
+}
+
+// 멈춘 블록 참조 복사 + 이어서 해석 (poll 1회에 YMODEM_DELTA_COPY_BUDGET까지)
+// 차등 해석이 남은 입력을 다 쓰면 멈춰 있던 LZ4 해제를 이어 감 (다시 블록 참조를 만나면 반복)
+// 반환값: YMODEM_OK (패킷 처리 완료), YMODEM_BUSY (다음 poll에서 계속), YMODEM_ERROR
+static YmodemResult_t delta_resume(void)
+{
+    uint32_t start = delta_stream_copied_bytes();
+
+    while (delta_paused()) {
+        uint32_t used = delta_stream_copied_bytes() - start;
+        if (used >= YMODEM_DELTA_COPY_BUDGET) {
+            return YMODEM_BUSY;
+        }
+        if (delta_stream_status() == DELTA_STREAM_COPY) {
+            if (delta_stream_resume(YMODEM_DELTA_COPY_BUDGET - used) == DELTA_STREAM_ERROR) {
+                return YMODEM_ERROR;
+            }
+        } else if (lz4_stream_resume() == LZ4_STREAM_ERROR) {
+            return YMODEM_ERROR;
+        }
+    }
+    return YMODEM_OK;
+}
+
+// ACK 보류 중인 패킷의 블록 참조 복사 진행, 끝나면 ACK
+static YmodemResult_t poll_delta_copy(void)
+{
+    YmodemResult_t result = delta_resume();
+
+    if (result == YMODEM_BUSY) {
+        return YMODEM_BUSY;
+    }
+    session.delta_ack_pending = false;
+    if (result != YMODEM_OK) {
+        transmit_byte(session.huart, YMODEM_CAN);
+        uart_send_error(405, "SD write error");
+        return finish_session(YMODEM_ERROR);
+    }
+    return ack_data_packet(NULL);
+}
+
+// 블록 참조: 기존 파일 구간을 8KB씩 순차로 읽어 스테이징
+// delta_stream_resume()이 참조 하나를 YMODEM_DELTA_COPY_BUDGET 이하 조각으로 나눠 순차 위치로 호출
+// 스테이징 버퍼의 현재 위치는 정렬되지 않을 수 있어 DELTA_READ_BUFFER로 읽은 뒤 복사
+// (write-behind 중인 f_write()는 SD 드라이버가 다음 읽기 전에 완료 확인)
+static int delta_copy(uint32_t offset, uint32_t size)
+{
+    if (f_tell(&delta_basis) != offset && f_lseek(&delta_basis, offset) != FR_OK) {
+        return -1;
+    }
+
+    while (size > 0) {
+        UINT chunk = (size > SD_WRITE_BUFFER_SIZE) ? SD_WRITE_BUFFER_SIZE : size;
+        UINT bytes_read = 0;
+        FRESULT fres = f_read(&delta_basis, DELTA_READ_BUFFER, chunk, &bytes_read);
+        if (fres != FR_OK || bytes_read != chunk) {
+            printf("[ERROR] Y-MODEM delta: basis read at %lu failed: fres=%d, read=%u/%u\r\n",
+                   (uint32_t)f_tell(&delta_basis), fres, bytes_read, chunk);
+            return -1;
+        }
+        if (stage_payload(DELTA_READ_BUFFER, (uint16_t)chunk) != YMODEM_OK) {
+            return -1;
+        }
+        size -= chunk;
+    }
+    return 0;
+}
+
+// 페이로드를 SD 스테이징 버퍼에 추가
+// receive_packet()이 스테이징 버퍼에 직접 수신한 페이로드는 복사 없이 오프셋만 이동
+// 버퍼가 8KB 차면 f_write()로 DMA 쓰기 시작 후 다른 쪽 버퍼로 전환
+// (이전 버퍼의 DMA 완료는 SD 드라이버가 다음 쓰기 전에 확인하므로 전환한 버퍼는 항상 비어 있음)
+// 128바이트 패킷이 섞여 8KB 경계를 넘는 경우 나머지는 다음 버퍼에 이어서 저장
+static YmodemResult_t stage_payload(const uint8_t *data, uint16_t size)
+{
+    session.total_bytes += size;
+
+    while (size > 0) {
+        uint8_t *dst = &STAGING_BUFFER()[session.write_buffer_offset];
+        uint16_t chunk = SD_WRITE_BUFFER_SIZE - session.write_buffer_offset;
+        if (chunk > size) {
+            chunk = size;
+        }
+
+        if (data != dst) {
+            uint32_t copy_start = STATS_NOW();
+            memcpy(dst, data, chunk);
+            STATS_ADD(YMODEM_PHASE_STAGE_COPY, copy_start);
+            session.copy_bytes += chunk;
+        }
+        session.write_buffer_offset += chunk;
+        data += chunk;
+        size -= chunk;
+
+        if (session.write_buffer_offset < SD_WRITE_BUFFER_SIZE) {
+            continue;
+        }
+
+        // 버퍼가 8KB 차면 SD 카드에 쓰기 (512 * 16 = 최적 블록 크기)
+        UINT bytes_written;
+        uint32_t pos = f_tell(&session.file);
+        uint32_t write_start = DWT->CYCCNT;
+        FRESULT fres = f_write(&session.file, STAGING_BUFFER(), SD_WRITE_BUFFER_SIZE, &bytes_written);
+        rtt_sample(YMODEM_EST_SD, DWT->CYCCNT - write_start);
+        stats_write_done(write_start);
+
+        if (fres != FR_OK || bytes_written != SD_WRITE_BUFFER_SIZE) {
+            printf("[ERROR] SD write failed: fres=%d, written=%u/%u\r\n",
+                   fres, bytes_written, SD_WRITE_BUFFER_SIZE);
+            return YMODEM_ERROR;
+        }
+        digest_update(pos, STAGING_BUFFER(), SD_WRITE_BUFFER_SIZE);
+
+        // 다음 스테이징 버퍼로 전환
+        session.write_buffer_offset = 0;
+        session.stage_index = (session.stage_index + 1) % SD_STAGING_COUNT;
+
+        // 1MB마다 f_sync() 호출 (SD 카드 데이터 무결성 보장)
+        // 동기화된 위치를 진행 기록에 남김 (리셋 후 재개 위치)
+        if (f_tell(&session.file) - session.synced_offset >= YMODEM_SYNC_INTERVAL) {
+            fres = f_sync(&session.file);
+            if (fres != FR_OK) {
+                printf("[WARN] f_sync failed at %lu bytes: fres=%d\r\n", (uint32_t)f_tell(&session.file), fres);
+            } else {
+                session.synced_offset = f_tell(&session.file);
+                if (session.progress_enabled) {
+                    save_progress(session.synced_offset);
+                }
+            }
+        }
+    }
+
+    return YMODEM_OK;
+}
+
+// 남은 스테이징 데이터를 512 배수로 패딩하여 쓰기 (EOT 수신 시)
+static YmodemResult_t flush_staging_final(void)
+{
+    if (session.write_buffer_offset == 0) {
+        return YMODEM_OK;
+    }
+
+    // 512 배수로 올림 (SD 카드 최적화)
+    uint32_t padded_size = ((session.write_buffer_offset + 511) / 512) * 512;
+
+    // 패딩 영역을 0으로 채움
+    if (padded_size > session.write_buffer_offset) {
+        memset(&STAGING_BUFFER()[session.write_buffer_offset], 0, padded_size - session.write_buffer_offset);
+    }
+
+    // SD 카드에 마지막 데이터 쓰기
+    UINT bytes_written;
+    uint32_t pos = f_tell(&session.file);
+    uint32_t write_start = STATS_NOW();
+    FRESULT fres = f_write(&session.file, STAGING_BUFFER(), padded_size, &bytes_written);
+    stats_write_done(write_start);
+
+    if (fres != FR_OK) {
+        printf("[ERROR] Final SD write failed: fres=%d, written=%u/%lu\r\n",
+               fres, bytes_written, padded_size);
+        return YMODEM_ERROR;
+    }
+    digest_update(pos, STAGING_BUFFER(), session.write_buffer_offset);
+
+    printf("[DEBUG] Final write: %lu bytes data + %lu bytes padding = %u bytes written\r\n",
+           session.write_buffer_offset, padded_size - session.write_buffer_offset, bytes_written);
+    session.write_buffer_offset = 0;
+    return YMODEM_OK;
+}
+
+// SD에 쓴 스테이징 버퍼를 다이제스트에 반영 (pos: 파일 내 위치)
+// 쓰기 직후 버퍼는 DMA 완료 전까지 그대로이므로 다시 읽지 않고 바로 계산
+// 블록 0에 크기가 있으면 그 뒤의 송신측 패딩은 제외 (truncate_to_exact_size()와 같은 기준)
+static void digest_update(uint32_t pos, const uint8_t *data, uint32_t size)
+{
+    uint32_t limit = (session.expected_size != 0) ? session.expected_size : UINT32_MAX;
+
+    if (!session.digest_valid || pos >= limit) {
+        return;
+    }
+    if (size > limit - pos) {
+        size = limit - pos;
+    }
+    session.digest = crc32_update(session.digest, data, size);
+}
+
+// 파일을 정확한 크기로 자름 (EOT 수신 시)
+// 블록 0에 크기가 있으면 그 크기 (송신측 0x1A 패딩 제거), 없으면 수신한 데이터 크기 (512 패딩 제거)
+static YmodemResult_t truncate_to_exact_size(void)
+{
+    uint32_t final_size = session.total_bytes;
+    if (session.expected_size != 0 && session.expected_size < final_size) {
+        final_size = session.expected_size;
+    }
+
+    FRESULT fres = f_lseek(&session.file, final_size);
+    if (fres == FR_OK) {
+        fres = f_truncate(&session.file);
+    }
+    if (fres != FR_OK) {
+        printf("[ERROR] Truncate to %lu bytes failed: fres=%d\r\n", final_size, fres);
+        return YMODEM_ERROR;
+    }
+
+    uint32_t elapsed = HAL_GetTick() - session.start_tick;
+    if (session.state != YMODEM_STATE_IDLE) {
+        last_upload_kbps = elapsed ? (final_size / elapsed) * 1000 / 1024 : 0;
+    }
+    printf("[DEBUG] Y-MODEM: %lu bytes (declared %lu) in %lu ms, %lu KB/s, prealloc=%d\r\n",
+           final_size, session.expected_size, elapsed,
+           elapsed ? (final_size / elapsed) * 1000 / 1024 : 0, session.preallocated);
+    if (session.compressed && session.wire_bytes > 0) {
+        // 링크 전송량 대비 해제 크기 (x100)
+        uint32_t ratio = (uint32_t)(((uint64_t)(session.total_bytes - session.resume_offset) * 100) /
+                                    session.wire_bytes);
+        printf("[DEBUG] Y-MODEM LZ4: %lu bytes on link, ratio %lu.%02lu\r\n",
+               session.wire_bytes, ratio / 100, ratio % 100);
+    }
+    return YMODEM_OK;
+}
+
+// 슬라이딩 윈도우 초기화
+static void window_reset(uint8_t last_acked)
+{
+    for (uint8_t i = 0; i < YMODEM_WINDOW_SIZE; i++) {
+        window_slots[i].valid = false;
+    }
+    window_last_acked = last_acked;
+    window_nak_blk = 0;
+    window_nak_sent = false;
+}
+
+// 재정렬 슬롯에 보관 중인 블록이 있는지 (= 누락 블록이 있음)
+static bool window_has_pending(void)
+{
+    for (uint8_t i = 0; i < YMODEM_WINDOW_SIZE; i++) {
+        if (window_slots[i].valid) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 받은 데이터가 블록 0 크기보다 적은지 (뒤쪽 블록 누락)
+// 그대로 기록한 업로드는 파일 크기, 변환 업로드는 링크로 받은 원본 크기로 비교
+// 압축/차등 업로드는 스트림 종료 표시로 따로 확인
+static bool window_short_of_declared(void)
+{
+    if (session.expected_size == 0 || session.compressed || session.delta) {
+        return false;
+    }
+    uint32_t received = (session.transcode != WAV_NATIVE_NONE) ? session.wire_bytes : session.total_bytes;
+    return received < session.expected_size;
+}
+
+// 윈도우 응답 전송: [ACK][마지막 정상 블록] 또는 [NAK][재전송 요청 블록]
+static void window_send_response(UART_HandleTypeDef *huart, uint8_t code, uint8_t blk)
+{
+    uint8_t frame[2] = { code, blk };
+
+    if (transmit_frame(huart, frame, sizeof(frame)) != HAL_OK) {
+        printf("[WARN] Y-MODEM-W: response 0x%02X/%u send failed\r\n", code, blk);
+    }
+
+    if (code == YMODEM_ACK) {
+        window_last_acked = blk;
+    } else if (code == YMODEM_NAK) {
+        window_nak_blk = blk;
+        window_nak_sent = true;
+    }
+}
+
+// 윈도우 모드 데이터 패킷 처리 (CRC 검증 완료된 패킷)
+// - 기대 블록: 스테이징 후 뒤이어 보관된 연속 블록도 함께 반영
+// - 앞선 블록: 슬롯에 보관하고 누락 블록만 NAK (선택적 재전송)
+// - 이미 반영된 블록: ACK 손실로 인한 재전송이므로 버리고 누적 ACK 재전송
+static YmodemResult_t window_receive(UART_HandleTypeDef *huart, uint8_t blk, const uint8_t *data,
+                                     uint16_t size, uint8_t *expected)
+{
+    uint8_t distance = (uint8_t)(blk - *expected);
+
+    if (distance == 0) {
+        if (consume_payload(data, size) != YMODEM_OK) {
+            return YMODEM_ERROR;
+        }
+        (*expected)++;
+
+        // 슬롯에 보관된 다음 블록들을 순서대로 반영
+        WindowSlot_t *slot = &window_slots[*expected % YMODEM_WINDOW_SIZE];
+        while (slot->valid && slot->blk == *expected) {
+            if (consume_payload(slot->data, slot->size) != YMODEM_OK) {
+                return YMODEM_ERROR;
+            }
+            slot->valid = false;
+            (*expected)++;
+            slot = &window_slots[*expected % YMODEM_WINDOW_SIZE];
+        }
+        window_nak_sent = false;
+
+        // 누적 ACK: 윈도우 절반이 쌓였거나 링 버퍼가 비었을 때 (송신측이 ACK 대기 중일 수 있음)
+        uint8_t last_good = (uint8_t)(*expected - 1);
+        if ((uint8_t)(last_good - window_last_acked) >= YMODEM_WINDOW_SIZE / 2 ||
+            link_available() == 0) {
+            window_send_response(huart, YMODEM_ACK, last_good);
+        }
+
+        // 아직 빈 구간이 남아 있으면 다음 누락 블록 요청
+        if (window_has_pending()) {
+            window_send_response(huart, YMODEM_NAK, *expected);
+        }
+    }
+    else if (distance < YMODEM_WINDOW_SIZE) {
+        WindowSlot_t *slot = &window_slots[blk % YMODEM_WINDOW_SIZE];
+        if (!slot->valid || slot->blk != blk) {
+            memcpy(slot->data, data, size);
+            session.copy_bytes += size;
+            slot->size = size;
+            slot->blk = blk;
+            slot->valid = true;
+        }
+
+        // 같은 누락 블록에 대해서는 NAK 1회만 (타임아웃 시 재요청)
+        if (!window_nak_sent || window_nak_blk != *expected) {
+            printf("[WARN] Y-MODEM-W: block %u missing (got %u), NAK\r\n", *expected, blk);
+            window_send_response(huart, YMODEM_NAK, *expected);
+        }
+    }
+    else if ((uint8_t)(*expected - blk) <= YMODEM_WINDOW_SIZE) {
+        // 중복 블록 - 파일에 다시 쓰지 않음
+        printf("[WARN] Y-MODEM-W: duplicate block %u, re-ACK %u\r\n", blk, (uint8_t)(*expected - 1));
+        window_send_response(huart, YMODEM_ACK, (uint8_t)(*expected - 1));
+    }
+    else {
+        // 윈도우 밖의 블록 - 기대 블록 재요청
+        printf("[WARN] Y-MODEM-W: block %u outside window (expected %u)\r\n", blk, *expected);
+        window_send_response(huart, YMODEM_NAK, *expected);
+    }
+
+    return YMODEM_OK;
+}
+
+// ============================================================================
+// Y-MODEM 송신 (SD → 호스트)
+// ============================================================================
+
+// Y-MODEM 송신 시작 (비차단)
+// huart가 NULL이면 USB CDC 사용
+// 반환값: YMODEM_BUSY (시작됨, 이후 ymodem_poll() 반복 호출) 또는 에러 코드
+YmodemResult_t ymodem_send_start(UART_HandleTypeDef *huart, const char *file_path)
+{
+    if (session.state != YMODEM_STATE_IDLE) {
+        printf("[ERROR] Y-MODEM: transfer already in progress\r\n");
+        return YMODEM_ERROR;
+    }
+
+    FRESULT fres = f_open(&session.file, file_path, FA_READ);
+    if (fres != FR_OK) {
+        printf("[ERROR] f_open(%s) failed: fres=%d\r\n", file_path, fres);
+        uart_send_error(404, "File not found");
+        return YMODEM_ERROR;
+    }
+
+    strncpy(session.path, file_path, sizeof(session.path) - 1);
+    session.path[sizeof(session.path) - 1] = '\0';
+    session.file_open = true;
+    session.progress_enabled = false;
+    session.huart = huart;
+    session.expected_size = f_size(&session.file);
+    session.total_bytes = 0;
+    session.packet_number = 1;
+    session.timeout_retries = 0;
+    session.nak_retries = 0;
+
+    // 첫 버퍼는 미리 채우고, 다음 버퍼는 ACK 대기 중에 채움
+    for (uint8_t i = 0; i < SD_STAGING_COUNT; i++) {
+        session.send_len[i] = 0;
+    }
+    session.send_index = 0;
+    session.send_pos = 0;
+    session.send_eof = false;
+    if (send_refill(0) != YMODEM_OK) {
+        f_close(&session.file);
+        session.file_open = false;
+        uart_send_error(405, "SD read error");
+        return YMODEM_ERROR;
+    }
+
+    extern volatile uint8_t g_ymodem_active;
+    g_ymodem_active = 1;
+
+    if (huart == NULL && session.link == NULL) {
+        CDC_Set_YModem_Mode(true);
+    }
+
+    printf("[DEBUG] Y-MODEM send: %s (%lu bytes), waiting for receiver 'C'...\r\n",
+           session.path, session.expected_size);
+
+    session.state = YMODEM_STATE_SEND;
+    session.send_phase = SEND_WAIT_START;
+    session.wait_start_tick = HAL_GetTick();
+    session.holdoff_until = HAL_GetTick();
+    session.result = YMODEM_BUSY;
+
+    return YMODEM_BUSY;
+}
+
+// Y-MODEM 송신 (차단형, 전송 완료까지 반환하지 않음)
+YmodemResult_t ymodem_send(UART_HandleTypeDef *huart, const char *file_path)
+{
+    YmodemResult_t result = ymodem_send_start(huart, file_path);
+
+    while (result == YMODEM_BUSY) {
+        result = ymodem_poll();
+    }
+
+    return result;
+}
+
+// 송신 진행: 수신측 응답 1바이트 처리
+static YmodemResult_t poll_send(void)
+{
+    UART_HandleTypeDef *huart = session.huart;
+    uint8_t response;
+
+    // 읽기 선행: 다음 버퍼가 비어 있으면 ACK를 기다리는 동안 SD에서 채움
+    // (SD 읽기 지연이 호스트 왕복 시간 뒤로 숨음)
+    if (session.send_phase == SEND_DATA && !session.send_eof &&
+        session.send_len[(session.send_index + 1) % SD_STAGING_COUNT] == 0) {
+        if (send_refill((session.send_index + 1) % SD_STAGING_COUNT) != YMODEM_OK) {
+            cancel_transfer(huart);
+            uart_send_error(405, "SD read error");
+            return finish_session(YMODEM_ERROR);
+        }
+    }
+
+    if (!receive_response(&response)) {
+        // 데이터 블록/EOT 응답은 측정한 ACK 시간 기준 (연속 타임아웃마다 2배)
+        uint32_t limit = YMODEM_TIMEOUT_MS;
+        if (session.send_phase == SEND_WAIT_START) {
+            limit = 60000;
+        } else if (session.send_phase == SEND_DATA || session.send_phase == SEND_EOT) {
+            limit = rtt_timeout_ms(YMODEM_EST_ACK, 0, session.timeout_retries);
+        }
+        if (HAL_GetTick() - session.wait_start_tick <= limit) {
+            return YMODEM_BUSY;
+        }
+        session.wait_start_tick = HAL_GetTick();
+
+        switch (session.send_phase) {
+        case SEND_WAIT_START:
+            transmit_byte(huart, YMODEM_CAN);
+            uart_send_error(501, "Y-MODEM timeout waiting for receiver");
+            return finish_session(YMODEM_TIMEOUT);
+
+        case SEND_WAIT_DATA:
+            // 일부 수신측은 블록 0 ACK 뒤 'C'를 생략 - 그대로 데이터 시작
+            printf("[WARN] Y-MODEM send: no 'C' after file info, starting data\r\n");
+            session.start_tick = HAL_GetTick();
+            return send_next();
+
+        case SEND_WAIT_END:
+        case SEND_END:
+            // 데이터는 모두 ACK됨 - 종료 블록 응답이 없어도 완료
+            break;
+
+        default:
+            session.timeout_retries++;
+            if (session.timeout_retries >= YMODEM_MAX_TIMEOUT_RETRIES) {
+                cancel_transfer(huart);
+                uart_send_error(501, "Y-MODEM timeout after retries");
+                return finish_session(YMODEM_TIMEOUT);
+            }
+            printf("[WARN] Y-MODEM send: response timeout, resend (%d/%d)\r\n",
+                   session.timeout_retries, YMODEM_MAX_TIMEOUT_RETRIES);
+            session.send_timed = false;
+            send_resend();
+            return YMODEM_BUSY;
+        }
+    } else {
+        if (response == YMODEM_CAN) {
+            uart_send_response(ANSI_YELLOW "INFO:" ANSI_RESET " Transfer cancelled by receiver\r\n");
+            return finish_session(YMODEM_CANCELLED);
+        }
+
+        if (response == YMODEM_NAK && session.send_phase != SEND_WAIT_START &&
+            session.send_phase != SEND_WAIT_DATA && session.send_phase != SEND_WAIT_END) {
+            session.nak_retries++;
+            if (session.nak_retries >= YMODEM_MAX_NAK_RETRIES) {
+                cancel_transfer(huart);
+                uart_send_error(501, "Too many NAK retries");
+                return finish_session(YMODEM_ERROR);
+            }
+            // 표준 수신측은 첫 EOT에 NAK으로 응답 - EOT 재전송
+            session.send_timed = false;
+            send_resend();
+            return YMODEM_BUSY;
+        }
+
+        switch (session.send_phase) {
+        case SEND_WAIT_START:
+            if (response == YMODEM_CRC16) {
+                send_header(false);
+                session.send_phase = SEND_HEADER;
+            }
+            return YMODEM_BUSY;
+
+        case SEND_HEADER:
+            if (response == YMODEM_ACK) {
+                session.send_phase = SEND_WAIT_DATA;
+                session.nak_retries = 0;
+            } else if (response == YMODEM_CRC16) {
+                // 블록 0을 받지 못함 (수신측이 아직 'C' 전송 중)
+                send_header(false);
+            }
+            return YMODEM_BUSY;
+
+        case SEND_WAIT_DATA:
+            if (response != YMODEM_CRC16) {
+                return YMODEM_BUSY;
+            }
+            session.start_tick = HAL_GetTick();
+            return send_next();
+
+        case SEND_DATA:
+            if (response != YMODEM_ACK) {
+                return YMODEM_BUSY;  // 늦게 도착한 'C' 등은 무시
+            }
+            // 재전송 없이 ACK된 블록만 응답 시간 측정
+            if (session.send_timed) {
+                session.send_timed = false;
+                rtt_sample(YMODEM_EST_ACK, DWT->CYCCNT - session.send_mark);
+            }
+
+            // ACK된 블록만큼 전진, 버퍼를 다 보냈으면 읽기 선행 버퍼로 전환
+            session.total_bytes += session.send_packet_len;
+            session.send_pos += session.send_packet_len;
+            session.packet_number++;
+            session.timeout_retries = 0;
+            session.nak_retries = 0;
+            if (session.send_pos >= session.send_len[session.send_index]) {
+                session.send_len[session.send_index] = 0;
+                session.send_index = (session.send_index + 1) % SD_STAGING_COUNT;
+                session.send_pos = 0;
+            }
+            return send_next();
+
+        case SEND_EOT:
+            if (response == YMODEM_ACK) {
+                session.send_phase = SEND_WAIT_END;
+                session.wait_start_tick = HAL_GetTick();
+            }
+            return YMODEM_BUSY;
+
+        case SEND_WAIT_END:
+            if (response == YMODEM_CRC16) {
+                send_header(true);
+                session.send_phase = SEND_END;
+            }
+            return YMODEM_BUSY;
+
+        case SEND_END:
+            if (response != YMODEM_ACK) {
+                return YMODEM_BUSY;
+            }
+            break;
+        }
+    }
+
+    // 전송 완료: 처리량 보고 (업로드 경로와 비교)
+    uint32_t elapsed = HAL_GetTick() - session.start_tick;
+    uint32_t kbps = elapsed ? (session.total_bytes / elapsed) * 1000 / 1024 : 0;
+    printf("[DEBUG] Y-MODEM send: %lu bytes in %lu ms, %lu KB/s (last upload %lu KB/s)\r\n",
+           session.total_bytes, elapsed, kbps, last_upload_kbps);
+    uart_send_response(ANSI_GREEN "INFO:" ANSI_RESET " Sent %lu bytes in %lu ms (%lu KB/s, upload %lu KB/s)\r\n",
+                       session.total_bytes, elapsed, kbps, last_upload_kbps);
+    return finish_session(YMODEM_OK);
+}
+
+// 다음 데이터 블록 전송, 남은 데이터가 없으면 EOT
+static YmodemResult_t send_next(void)
+{
+    session.wait_start_tick = HAL_GetTick();
+
+    // 읽기 선행 버퍼가 아직 비어 있으면 (ACK가 읽기보다 빨리 옴) 여기서 채움
+    if (session.send_len[session.send_index] == 0 && !session.send_eof &&
+        send_refill(session.send_index) != YMODEM_OK) {
+        cancel_transfer(session.huart);
+        uart_send_error(405, "SD read error");
+        return finish_session(YMODEM_ERROR);
+    }
+
+    uint32_t remaining = session.send_len[session.send_index] - session.send_pos;
+    if (remaining == 0) {
+        session.send_phase = SEND_EOT;
+        transmit_byte(session.huart, YMODEM_EOT);
+        return YMODEM_BUSY;
+    }
+
+    session.send_packet_len = (remaining > YMODEM_PACKET_SIZE) ? YMODEM_PACKET_SIZE : (uint16_t)remaining;
+    session.send_phase = SEND_DATA;
+    session.send_timed = true;
+    session.send_mark = DWT->CYCCNT;
+    send_resend();
+    return YMODEM_BUSY;
+}
+
+// 현재 단계의 마지막 전송 다시 보내기 (NAK 또는 타임아웃)
+static HAL_StatusTypeDef send_resend(void)
+{
+    session.wait_start_tick = HAL_GetTick();
+
+    switch (session.send_phase) {
+    case SEND_HEADER:
+        return send_header(false);
+    case SEND_END:
+        return send_header(true);
+    case SEND_EOT:
+        return transmit_byte(session.huart, YMODEM_EOT);
+    case SEND_DATA:
+        return send_block(session.packet_number,
+                          &SEND_BUFFER(session.send_index)[session.send_pos],
+                          session.send_packet_len, 0x1A);
+    default:
+        return HAL_OK;
+    }
+}
+
+// SD에서 읽기 선행 버퍼 1개 채우기 (8KB, 마지막 버퍼는 짧을 수 있음)
+static YmodemResult_t send_refill(uint8_t index)
+{
+    UINT bytes_read = 0;
+    FRESULT fres = f_read(&session.file, SEND_BUFFER(index), SD_WRITE_BUFFER_SIZE, &bytes_read);
+
+    if (fres != FR_OK) {
+        printf("[ERROR] SD read failed at %lu: fres=%d\r\n", (uint32_t)f_tell(&session.file), fres);
+        return YMODEM_ERROR;
+    }
+
+    session.send_len[index] = bytes_read;
+    if (bytes_read < SD_WRITE_BUFFER_SIZE) {
+        session.send_eof = true;
+    }
+    return YMODEM_OK;
+}
+
+// 블록 전송: len이 128 이하면 SOH(128), 아니면 STX(1024), 남는 부분은 pad로 채움
+static HAL_StatusTypeDef send_block(uint8_t blk, const uint8_t *data, uint32_t len, uint8_t pad)
+{
+    uint16_t size = (len <= 128) ? 128 : YMODEM_PACKET_SIZE;
+
+    send_frame[0] = (size == 128) ? YMODEM_SOH : YMODEM_STX;
+    send_frame[1] = blk;
+    send_frame[2] = (uint8_t)~blk;
+    memcpy(&send_frame[3], data, len);
+    memset(&send_frame[3 + len], pad, size - len);
+
+    uint16_t crc = crc16_ccitt(&send_frame[3], size);
+    send_frame[3 + size] = (uint8_t)(crc >> 8);
+    send_frame[4 + size] = (uint8_t)crc;
+
+    HAL_StatusTypeDef status = transmit_frame(session.huart, send_frame, 5 + size);
+    if (status != HAL_OK) {
+        printf("[WARN] Y-MODEM send: block %u transmit failed\r\n", blk);
+    }
+    return status;
+}
+
+// 블록 0 전송: "파일명\0크기" (last이면 빈 블록 0 = 세션 종료)
+static HAL_StatusTypeDef send_header(bool last)
+{
+    uint8_t info[YMODEM_PATH_MAX + 16];
+    uint32_t len = 0;
+
+    if (!last) {
+        // 경로 대신 파일명만 전송
+        const char *name = strrchr(session.path, '/');
+        name = (name != NULL) ? name + 1 : session.path;
+        len = snprintf((char *)info, sizeof(info), "%s", name) + 1;
+        len += snprintf((char *)&info[len], sizeof(info) - len, "%lu", session.expected_size) + 1;
+    }
+
+    return send_block(0, info, len, 0x00);
+}
+
+// 수신측 응답 1바이트 (대기 없음)
+static bool receive_response(uint8_t *byte)
+{
+    if (session.huart == NULL) {
+        if (link_available() == 0) {
+            return false;
+        }
+        return (link_read(byte, 1) == 1);
+    }
+    return (HAL_UART_Receive(session.huart, byte, 1, 0) == HAL_OK);
+}
+
+// 수신 보류 (ACK 후 안정화, 타임아웃 후 대기): 메인 루프를 막지 않고 ms 동안 poll 무시
+static void hold_off(uint32_t ms)
+{
+    session.holdoff_until = HAL_GetTick() + ms;
+    session.stat_holdoff = STATS_NOW();
+    session.stat_holdoff_active = true;
+}
+
+// 구간 1회 기록 (사이클 → us 히스토그램 빈)
+// 데이터 수신 단계만 집계 (핸드셰이크, 송신, SDBENCH 경로 제외)
+static void stats_add(YmodemPhase_t phase, uint32_t cycles)
+{
+    if (session.state != YMODEM_STATE_DATA) {
+        return;
+    }
+
+    PhaseStats_t *st = &phase_stats[phase];
+
+    if (st->count == 0 || cycles < st->min) {
+        st->min = cycles;
+    }
+    if (cycles > st->max) {
+        st->max = cycles;
+    }
+    st->count++;
+    st->total += cycles;
+
+    uint32_t us = cycles / stats_cycles_per_us;
+    uint32_t bin = (us == 0) ? 0 : 32 - __CLZ(us);
+    if (bin >= YMODEM_STATS_BINS) {
+        bin = YMODEM_STATS_BINS - 1;
+    }
+    st->hist[bin]++;
+}
+
+// f_write() 구간 기록 + 그 안에서 이전 write-behind 완료를 기다린 시간 (SD 드라이버 계측)
+static void stats_write_done(uint32_t write_start)
+{
+#if YMODEM_PHASE_STATS
+    STATS_ADD(YMODEM_PHASE_F_WRITE, write_start);
+    uint32_t wait = SD_TakeWaitCycles();
+    if (wait != 0) {
+        stats_add(YMODEM_PHASE_SD_READY, wait);
+    }
+#else
+    (void)write_start;
+#endif
+}
+
+// 구간 통계 초기화 (ymodem_start_ex()에서 자동 호출)
+void ymodem_stats_reset(void)
+{
+    memset(phase_stats, 0, sizeof(phase_stats));
+    stats_cycles_per_us = HAL_RCC_GetSysClockFreq() / 1000000;
+    if (stats_cycles_per_us == 0) {
+        stats_cycles_per_us = 1;
+    }
+}
+
+// 구간 통계 한 줄: "이름 n=횟수 min/avg/max us | 히스토그램 16칸"
+// 반환값: false이면 phase 범위 밖
+bool ymodem_stats_format(YmodemPhase_t phase, char *line, uint32_t line_size)
+{
+    if (phase >= YMODEM_PHASE_COUNT) {
+        return false;
+    }
+
+    const PhaseStats_t *st = &phase_stats[phase];
+    uint32_t avg = (st->count != 0) ? (uint32_t)(st->total / st->count) : 0;
+    int len = snprintf(line, line_size, "%-8s n=%lu min=%lu avg=%lu max=%lu us |",
+                       phase_names[phase], st->count,
+                       st->min / stats_cycles_per_us, avg / stats_cycles_per_us,
+                       st->max / stats_cycles_per_us);
+
+    for (int i = 0; i < YMODEM_STATS_BINS && len > 0 && (uint32_t)len < line_size; i++) {
+        len += snprintf(&line[len], line_size - len, " %lu", st->hist[i]);
+    }
+    return true;
+}
+
+// 적응 타임아웃 측정값 추가 (RFC 6298: 첫 측정은 SRTT = R, RTTVAR = R/2)
+static void rtt_sample(YmodemEstimator_t est, uint32_t cycles)
+{
+    RttEstimator_t *e = &estimators[est];
+    uint32_t cycles_per_us = SystemCoreClock / 1000000;
+    uint32_t us = cycles / (cycles_per_us ? cycles_per_us : 1);
+
+    if (e->samples == 0) {
+        e->srtt_us = us;
+        e->rttvar_us = us / 2;
+    } else {
+        uint32_t err = (us > e->srtt_us) ? us - e->srtt_us : e->srtt_us - us;
+        e->rttvar_us = e->rttvar_us - e->rttvar_us / 4 + err / 4;
+        e->srtt_us = e->srtt_us - e->srtt_us / 8 + us / 8;
+    }
+    e->samples++;
+    e->last_us = us;
+    if (us > e->max_us) {
+        e->max_us = us;
+    }
+}
+
+// 구간 타임아웃 (ms): SRTT + 4 x RTTVAR, scale_bytes는 1KB당 측정값(PAYLOAD)의 배율 (0이면 그대로)
+// 측정값이 없으면 YMODEM_TIMEOUT_MS, 연속 타임아웃 횟수만큼 2배 (상한 YMODEM_TIMEOUT_MS)
+static uint32_t rtt_timeout_ms(YmodemEstimator_t est, uint32_t scale_bytes, uint8_t backoff)
+{
+    const RttEstimator_t *e = &estimators[est];
+    if (e->samples == 0) {
+        return YMODEM_TIMEOUT_MS;
+    }
+
+    uint64_t us = (uint64_t)e->srtt_us + 4ULL * e->rttvar_us;
+    if (scale_bytes != 0) {
+        us = us * scale_bytes / 1024;
+    }
+    uint32_t ms = (us >= (uint64_t)YMODEM_TIMEOUT_MS * 1000) ? YMODEM_TIMEOUT_MS : (uint32_t)((us + 999) / 1000);
+    if (ms < YMODEM_RTO_MIN_MS) {
+        ms = YMODEM_RTO_MIN_MS;
+    }
+    while (backoff-- > 0 && ms < YMODEM_TIMEOUT_MS) {
+        ms *= 2;
+    }
+    return (ms > YMODEM_TIMEOUT_MS) ? YMODEM_TIMEOUT_MS : ms;
+}
+
+// 타임아웃 후 수신 보류 (ms): SRTT + 2 x RTTVAR (송신측이 보내던 바이트가 도착해 정리될 시간)
+// [YMODEM_RETRY_DELAY_MIN_MS, YMODEM_RETRY_DELAY_MAX_MS x 2^backoff]로 제한, 측정값이 없으면 상한
+static uint32_t rtt_retry_delay_ms(YmodemEstimator_t est, uint8_t backoff)
+{
+    const RttEstimator_t *e = &estimators[est];
+    uint32_t cap = YMODEM_RETRY_DELAY_MAX_MS;
+    while (backoff-- > 0 && cap < YMODEM_TIMEOUT_MS) {
+        cap *= 2;
+    }
+    if (cap > YMODEM_TIMEOUT_MS) {
+        cap = YMODEM_TIMEOUT_MS;
+    }
+    if (e->samples == 0) {
+        return cap;
+    }
+
+    uint64_t us = (uint64_t)e->srtt_us + 2ULL * e->rttvar_us;
+    uint32_t ms = (us >= (uint64_t)cap * 1000) ? cap : (uint32_t)((us + 999) / 1000);
+    return (ms < YMODEM_RETRY_DELAY_MIN_MS) ? YMODEM_RETRY_DELAY_MIN_MS : ms;
+}
+
+// 패킷을 정상 처리한 직후: 다음 헤더까지 REPLY 측정 시작 (수신 보류 중이면 보류가 끝난 시점부터)
+static void reply_arm(void)
+{
+    session.reply_armed = true;
+    session.reply_mark = DWT->CYCCNT;
+}
+
+void ymodem_timing_reset(void)
+{
+    memset(estimators, 0, sizeof(estimators));
+}
+
+// 측정 구간 한 줄: "이름 n=횟수 srtt=.. rttvar=.. last=.. max=.. us rto=.. ms"
+// REPLY는 첫 타임아웃 후 수신 보류 " retry=.. ms" 추가
+// 반환값: false이면 est 범위 밖
+bool ymodem_timing_format(YmodemEstimator_t est, char *line, uint32_t line_size)
+{
+    if (est >= YMODEM_EST_COUNT) {
+        return false;
+    }
+
+    const RttEstimator_t *e = &estimators[est];
+    int len = snprintf(line, line_size, "%-8s n=%lu srtt=%lu rttvar=%lu last=%lu max=%lu us rto=%lu ms",
+                       estimator_names[est], e->samples, e->srtt_us, e->rttvar_us, e->last_us, e->max_us,
+                       rtt_timeout_ms(est, (est == YMODEM_EST_PAYLOAD) ? YMODEM_PACKET_SIZE : 0, 0));
+    if (est == YMODEM_EST_REPLY && len > 0 && (uint32_t)len < line_size) {
+        snprintf(&line[len], line_size - len, " retry=%lu ms", rtt_retry_delay_ms(est, 0));
     }
+    return true;
 }
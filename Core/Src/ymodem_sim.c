@@ -0,0 +1,664 @@
+/*
+ * ymodem_sim.c
+ *
+ *  Y-MODEM 온보드 시뮬레이션 구현
+ *  - 송신기는 수신기의 응답(transmit)에 반응해 다음 프레임을 준비하고,
+ *    수신기의 읽기(available/read)에 링크 모델에 따라 도착한 만큼만 내줌
+ *  - 링크 모델: 응답 후 link_delay_us 뒤부터 link_kbps 속도로 도착 (0이면 즉시 전체)
+ *  - SD 모델: SD_SetWriteLatency()로 write-behind 완료 시점을 늦춤
+ *  - 장애 모델: fault_interval번째 데이터 블록마다 첫 전송을 손상 (NAK 재전송은 정상)
+ *    잡음 선행(이전 패킷 잔여 바이트) → 꼬리 손실 → 헤더 손실 순서로 반복
+ *  - 차등 모델: 패턴 파일을 기존 파일로 기록하고 서명 생성(SIGS 경로)까지 측정한 뒤,
+ *    중간 EDIT_KB를 바꾼 새 파일을 [앞쪽 COPY][LITERAL][뒤쪽 COPY][END] 스트림으로 전송
+ *    (송신기는 바뀐 위치를 알고 있으므로 호스트의 롤링 체크섬 탐색은 생략)
+ *  - 수신기는 실제 ymodem.c 경로 그대로 (CRC, 스테이징, f_write, 8ms 수신 보류 포함)
+ */
+
+#include "ymodem_sim.h"
+#include "crc_engine.h"
+#include "delta_sync.h"
+#include "user_def.h"        // sdmmc1_buffer (차등 모델의 기존 파일 기록)
+#include "fatfs.h"           // SD_SetWriteLatency()
+#include <string.h>
+#include <stdio.h>
+
+#define SIM_FILE_NAME           "ysim.bin"
+
+// 송신 단계
+typedef enum {
+    SIM_WAIT_START = 0,         // 수신측 'C'/'G' 대기
+    SIM_HEADER,                 // 블록 0 전송, ACK(표준) 또는 'G' 대기
+    SIM_DATA,                   // 데이터 블록
+    SIM_EOT,                    // EOT 전송, ACK 대기
+    SIM_DONE,
+    SIM_CANCELLED               // 수신측 CAN
+} SimPhase_t;
+
+// 장애 종류
+typedef enum {
+    SIM_FAULT_GARBAGE = 0,      // 프레임 앞에 잡음 바이트 (재동기화로 헤더 탐색)
+    SIM_FAULT_TRUNCATE,         // 프레임 뒤 절반 손실 (링크 조용함 → NAK)
+    SIM_FAULT_SHIFT,            // 헤더 바이트 손실 (잘못된 헤더 → 재동기화 → NAK)
+    SIM_FAULT_COUNT
+} SimFault_t;
+
+#define SIM_GARBAGE_LEN         24
+
+// 차등 모델: 바뀐 구간은 패턴을 뒤집어 기존 블록과 일치하지 않게 함
+#define SIM_EDIT_XOR            0x5A
+
+// 차등 스트림 구성 (리터럴 앞뒤의 명령 바이트는 미리 만들어 둠)
+typedef struct {
+    uint32_t edit_start;            // 바뀐 구간 [edit_start, edit_end), 블록 경계에서 시작
+    uint32_t edit_end;
+    uint32_t literal_end;           // 리터럴 구간 끝 (블록 경계 또는 파일 끝)
+    uint8_t head[12 + 9 + 5];       // 스트림 헤더 + 앞쪽 COPY + LITERAL 명령
+    uint32_t head_len;
+    uint8_t tail[9 + 5];            // 뒤쪽 COPY + END
+    uint32_t tail_len;
+    uint32_t basis_ms;              // 기존 파일 기록 시간
+    uint32_t sig_ms;                // 서명 생성 시간
+    uint32_t sig_blocks;
+} SimDelta_t;
+
+typedef struct {
+    YmodemSimConfig_t config;
+    SimPhase_t phase;
+    uint32_t frame_len;             // 현재 프레임 길이 (0 = 보낼 프레임 없음)
+    uint32_t frame_pos;             // 수신측이 읽은 위치 (잡음 포함 링크 바이트 기준)
+    uint32_t lead_len;              // 프레임 앞 잡음 바이트 수 (장애 주입)
+    uint32_t frame_start;           // 링크로 보낼 프레임 구간 [frame_start, frame_end)
+    uint32_t frame_end;
+    uint32_t release;               // 프레임 첫 바이트 도착 시각 (DWT)
+    uint32_t stream_size;           // 데이터 블록으로 보낼 총 바이트 (일반 업로드는 파일 크기)
+    uint32_t offset;                // 현재 데이터 블록의 스트림 위치
+    uint32_t next_offset;           // 현재 데이터 블록 다음 위치
+    uint8_t blk;                    // 현재 데이터 블록 번호
+    uint32_t wraps;                 // 블록 번호 255 → 0 횟수 (패킷 수 계산)
+    uint32_t delay_cycles;          // 링크 지연 (사이클)
+    uint32_t cycles_per_byte;       // 링크 속도 (0 = 제한 없음)
+    uint32_t data_start_tick;       // 첫 데이터 블록 준비 시각
+    uint32_t data_end_tick;         // EOT ACK 수신 시각
+    uint32_t retransmits;           // NAK에 의한 재전송 횟수
+    uint32_t lat_count;             // 프레임 도착 → ACK (수신측 패킷 처리 시간)
+    uint32_t lat_min;
+    uint32_t lat_max;
+    uint64_t lat_total;
+    uint32_t faults;                // 주입한 장애 수
+    bool fault_pending;             // 장애 블록이 아직 ACK되지 않음
+    uint32_t fault_start;           // 장애 프레임 도착 시각 (DWT)
+    uint32_t rec_min;               // 장애 프레임 도착 → 해당 블록 ACK (복구 시간)
+    uint32_t rec_max;
+    uint64_t rec_total;
+} SimSender_t;
+
+static SimSender_t sim;
+static uint8_t sim_lead[SIM_GARBAGE_LEN];
+
+// 송신 프레임 (확장 블록 최대 크기, .bss 여유가 없어 RAM_D1_DMA에 배치)
+__attribute__((section(".ram_d1_dma")))
+__attribute__((aligned(32)))
+static uint8_t sim_frame[3 + YMODEM_LARGE_PACKET_SIZE + 4];
+
+__attribute__((section(".ram_d1_dma")))
+static SimDelta_t sim_delta;
+
+static uint32_t sim_available(void);
+static uint32_t sim_read(uint8_t *data, uint32_t length);
+static HAL_StatusTypeDef sim_transmit(const uint8_t *data, uint16_t length);
+
+static const YmodemLink_t sim_link = {
+    .available = sim_available,
+    .read = sim_read,
+    .transmit = sim_transmit,
+};
+
+// 파일 내용 패턴 (위치로 결정, 검증 시 다시 계산)
+static inline uint8_t sim_pattern(uint32_t pos)
+{
+    uint32_t x = pos * 0x9E3779B1u;
+    return (uint8_t)((x >> 24) ^ (pos >> 10));
+}
+
+// 수신 후 기대하는 파일 내용 (차등 모델은 바뀐 구간만 다름, 일반 업로드는 구간이 비어 있음)
+static inline uint8_t sim_content(uint32_t pos)
+{
+    uint8_t b = sim_pattern(pos);
+    return (pos >= sim_delta.edit_start && pos < sim_delta.edit_end) ? (uint8_t)(b ^ SIM_EDIT_XOR) : b;
+}
+
+// 데이터 블록 내용 (스트림 위치 기준)
+static void fill_stream(uint8_t *dst, uint32_t pos, uint32_t len)
+{
+    if (sim.config.delta_edit_kb == 0) {
+        for (uint32_t i = 0; i < len; i++) {
+            dst[i] = sim_pattern(pos + i);
+        }
+        return;
+    }
+
+    uint32_t literal_len = sim_delta.literal_end - sim_delta.edit_start;
+    for (uint32_t i = 0; i < len; i++, pos++) {
+        if (pos < sim_delta.head_len) {
+            dst[i] = sim_delta.head[pos];
+        } else if (pos - sim_delta.head_len < literal_len) {
+            dst[i] = sim_content(sim_delta.edit_start + pos - sim_delta.head_len);
+        } else {
+            dst[i] = sim_delta.tail[pos - sim_delta.head_len - literal_len];
+        }
+    }
+}
+
+// 프레임 준비: 수신측 응답 후 링크 지연만큼 뒤에 도착
+static void queue_frame(uint32_t len)
+{
+    sim.frame_len = len;
+    sim.frame_pos = 0;
+    sim.lead_len = 0;
+    sim.frame_start = 0;
+    sim.frame_end = len;
+    sim.release = DWT->CYCCNT + sim.delay_cycles;
+}
+
+// 이번 프레임의 링크 바이트 수 (잡음 + 보낼 구간)
+static inline uint32_t stream_len(void)
+{
+    return sim.lead_len + sim.frame_end - sim.frame_start;
+}
+
+// 방금 준비한 데이터 프레임의 첫 전송을 손상 (NAK 재전송은 queue_frame()으로 정상 프레임)
+// 헤더 손실 시 BLK가 EOT/CAN이면 단독 제어 문자와 구별할 수 없으므로 잡음 장애로 대체
+static void inject_fault(void)
+{
+    SimFault_t fault = (SimFault_t)(sim.faults % SIM_FAULT_COUNT);
+    if (fault == SIM_FAULT_SHIFT && (sim.blk == YMODEM_EOT || sim.blk == YMODEM_CAN)) {
+        fault = SIM_FAULT_GARBAGE;
+    }
+
+    switch (fault) {
+    case SIM_FAULT_GARBAGE:
+        // 첫 바이트는 헤더가 아닌 값, 나머지는 CAN이 연속되지 않는 잡음
+        for (uint32_t i = 0; i < SIM_GARBAGE_LEN; i++) {
+            uint8_t b = sim_pattern(0x5A5A5u + i * 13);
+            sim_lead[i] = (b == YMODEM_CAN) ? (uint8_t)(b ^ 0x80) : b;
+        }
+        sim_lead[0] = 0xA5;
+        sim.lead_len = SIM_GARBAGE_LEN;
+        break;
+    case SIM_FAULT_TRUNCATE:
+        sim.frame_end = sim.frame_len / 2;
+        break;
+    default:
+        sim.frame_start = 1;
+        break;
+    }
+
+    sim.faults++;
+    sim.fault_pending = true;
+    sim.fault_start = sim.release;
+}
+
+static void build_block(uint8_t blk, const uint8_t *data, uint32_t len, uint32_t size, uint8_t pad)
+{
+    sim_frame[1] = blk;
+    sim_frame[2] = (uint8_t)~blk;
+    if (data != NULL) {
+        memcpy(&sim_frame[3], data, len);
+    }
+    memset(&sim_frame[3 + len], pad, size - len);
+
+    if (size == YMODEM_LARGE_PACKET_SIZE) {
+        uint32_t crc = crc32_update(0, &sim_frame[3], size);
+        sim_frame[0] = YMODEM_LBLK;
+        sim_frame[3 + size] = (uint8_t)(crc >> 24);
+        sim_frame[4 + size] = (uint8_t)(crc >> 16);
+        sim_frame[5 + size] = (uint8_t)(crc >> 8);
+        sim_frame[6 + size] = (uint8_t)crc;
+        queue_frame(7 + size);
+        return;
+    }
+
+    uint16_t crc = crc16_ccitt(&sim_frame[3], size);
+    sim_frame[0] = (size == YMODEM_PACKET_SIZE) ? YMODEM_STX : YMODEM_SOH;
+    sim_frame[3 + size] = (uint8_t)(crc >> 8);
+    sim_frame[4 + size] = (uint8_t)crc;
+    queue_frame(5 + size);
+}
+
+// 블록 0: "파일명\0크기\0" (128바이트)
+static void queue_header(void)
+{
+    uint8_t info[128];
+    uint32_t len = snprintf((char *)info, sizeof(info), "%s", SIM_FILE_NAME) + 1;
+    len += snprintf((char *)&info[len], sizeof(info) - len, "%lu", sim.config.size) + 1;
+    build_block(0, info, len, 128, 0x00);
+}
+
+// 데이터 블록 (마지막 블록은 0x1A 패딩, 수신측이 블록 0 크기로 자름)
+// 확장 블록 모드: 8KB 블록, 남은 데이터가 8KB 미만이면 1KB 블록
+static void queue_data(void)
+{
+    uint32_t len = sim.stream_size - sim.offset;
+    uint32_t size = YMODEM_PACKET_SIZE;
+    if (sim.config.large_blocks && len >= YMODEM_LARGE_PACKET_SIZE) {
+        size = YMODEM_LARGE_PACKET_SIZE;
+    }
+    if (len > size) {
+        len = size;
+    }
+
+    // 페이로드는 프레임 안에서 바로 생성 (build_block()은 헤더/패딩/CRC만)
+    fill_stream(&sim_frame[3], sim.offset, len);
+    build_block(sim.blk, NULL, len, size, 0x1A);
+    sim.next_offset = sim.offset + len;
+
+    if (sim.config.fault_interval != 0 && (sim.wraps * 256 + sim.blk) % sim.config.fault_interval == 0) {
+        inject_fault();
+    }
+}
+
+static void queue_eot(void)
+{
+    sim_frame[0] = YMODEM_EOT;
+    queue_frame(1);
+    sim.phase = SIM_EOT;
+}
+
+// 현재 데이터 블록 완료 → 다음 블록 또는 EOT
+static void advance_data(void)
+{
+    sim.offset = sim.next_offset;
+    if (++sim.blk == 0) {
+        sim.wraps++;
+    }
+    if (sim.offset >= sim.stream_size) {
+        queue_eot();
+    } else {
+        queue_data();
+    }
+}
+
+// 링크에 도착한 바이트 수 (현재 프레임 중 아직 읽지 않은 부분)
+static uint32_t sim_available(void)
+{
+    if (sim.frame_len == 0) {
+        return 0;
+    }
+
+    int32_t elapsed = (int32_t)(DWT->CYCCNT - sim.release);
+    if (elapsed < 0) {
+        return 0;
+    }
+
+    uint32_t arrived = stream_len();
+    if (sim.cycles_per_byte != 0 && (uint32_t)elapsed / sim.cycles_per_byte < arrived) {
+        arrived = (uint32_t)elapsed / sim.cycles_per_byte;
+    }
+    return (arrived > sim.frame_pos) ? arrived - sim.frame_pos : 0;
+}
+
+static uint32_t sim_read(uint8_t *data, uint32_t length)
+{
+    uint32_t available = sim_available();
+    if (length > available) {
+        length = available;
+    }
+
+    for (uint32_t done = 0; done < length; ) {
+        uint32_t chunk;
+        if (sim.frame_pos < sim.lead_len) {
+            chunk = sim.lead_len - sim.frame_pos;
+            chunk = (chunk > length - done) ? length - done : chunk;
+            memcpy(&data[done], &sim_lead[sim.frame_pos], chunk);
+        } else {
+            chunk = length - done;
+            memcpy(&data[done], &sim_frame[sim.frame_start + sim.frame_pos - sim.lead_len], chunk);
+        }
+        done += chunk;
+        sim.frame_pos += chunk;
+    }
+
+    // Y-MODEM-G: ACK 없이 연속 전송 (다음 프레임은 이전 프레임 바로 뒤에 도착)
+    if (sim.frame_pos == stream_len() && sim.phase == SIM_DATA && sim.config.mode == YMODEM_MODE_G) {
+        uint32_t wire_end = sim.release + stream_len() * sim.cycles_per_byte;
+        advance_data();
+        sim.release = wire_end;
+    }
+    return length;
+}
+
+// 수신측 응답 처리
+static HAL_StatusTypeDef sim_transmit(const uint8_t *data, uint16_t length)
+{
+    for (uint16_t i = 0; i < length; i++) {
+        uint8_t c = data[i];
+
+        if (c == YMODEM_CAN) {
+            sim.phase = SIM_CANCELLED;
+            sim.frame_len = 0;
+            continue;
+        }
+
+        switch (sim.phase) {
+        case SIM_WAIT_START:
+            if (c == YMODEM_CRC16 || c == YMODEM_G) {
+                queue_header();
+                sim.phase = SIM_HEADER;
+            }
+            break;
+
+        case SIM_HEADER:
+            // 표준: 블록 0 ACK 후 바로 데이터 (수신측은 'C'를 다시 보내지 않음)
+            // Y-MODEM-G: 블록 0 후 'G'를 받으면 스트리밍 시작
+            if ((c == YMODEM_ACK && sim.config.mode == YMODEM_MODE_STANDARD) ||
+                (c == YMODEM_G && sim.config.mode == YMODEM_MODE_G)) {
+                sim.phase = SIM_DATA;
+                sim.offset = 0;
+                sim.blk = 1;
+                sim.data_start_tick = HAL_GetTick();
+                if (sim.stream_size == 0) {
+                    queue_eot();
+                } else {
+                    queue_data();
+                }
+            } else if (c == YMODEM_NAK) {
+                queue_header();
+            }
+            break;
+
+        case SIM_DATA:
+            if (c == YMODEM_ACK) {
+                uint32_t latency = DWT->CYCCNT - sim.release;
+                if (sim.lat_count == 0 || latency < sim.lat_min) {
+                    sim.lat_min = latency;
+                }
+                if (latency > sim.lat_max) {
+                    sim.lat_max = latency;
+                }
+                sim.lat_count++;
+                sim.lat_total += latency;
+
+                if (sim.fault_pending) {
+                    uint32_t recovery = DWT->CYCCNT - sim.fault_start;
+                    if (sim.rec_max == 0 || recovery < sim.rec_min) {
+                        sim.rec_min = recovery;
+                    }
+                    if (recovery > sim.rec_max) {
+                        sim.rec_max = recovery;
+                    }
+                    sim.rec_total += recovery;
+                    sim.fault_pending = false;
+                }
+                advance_data();
+            } else if (c == YMODEM_NAK) {
+                sim.retransmits++;
+                queue_frame(sim.frame_len);
+            }
+            break;
+
+        case SIM_EOT:
+            if (c == YMODEM_ACK) {
+                sim.data_end_tick = HAL_GetTick();
+                sim.frame_len = 0;
+                sim.phase = SIM_DONE;
+            } else if (c == YMODEM_NAK) {
+                queue_eot();
+            }
+            break;
+
+        default:
+            break;
+        }
+    }
+    return HAL_OK;
+}
+
+static uint32_t put_u32(uint8_t *dst, uint32_t value)
+{
+    dst[0] = (uint8_t)value;
+    dst[1] = (uint8_t)(value >> 8);
+    dst[2] = (uint8_t)(value >> 16);
+    dst[3] = (uint8_t)(value >> 24);
+    return 4;
+}
+
+// 차등 모델 준비: 기존 파일 기록 + 서명 생성 + 스트림 구성
+// 기존 파일은 패턴 그대로, 새 파일은 중간 EDIT_KB만 다름 (크기 동일)
+static YmodemResult_t prepare_delta(void)
+{
+    const uint32_t block = DELTA_BLOCK_DEFAULT;
+    const uint32_t size = sim.config.size;
+    uint32_t edit_len = sim.config.delta_edit_kb * 1024;
+    FIL file;
+    UINT bytes_written;
+    uint32_t crc = 0;
+
+    memset(&sim_delta, 0, sizeof(sim_delta));
+    sim_delta.edit_start = (size / 2) / block * block;
+    if (sim_delta.edit_start + edit_len > size) {
+        sim_delta.edit_start = (size - edit_len) / block * block;
+    }
+    sim_delta.edit_end = sim_delta.edit_start + edit_len;
+    sim_delta.literal_end = (sim_delta.edit_end + block - 1) / block * block;
+    if (sim_delta.literal_end > size) {
+        sim_delta.literal_end = size;
+    }
+
+    // 기존 파일 기록 (32KB 단위), 같은 버퍼에 바뀐 구간을 덮어 새 파일 CRC-32 계산
+    uint32_t start = HAL_GetTick();
+    if (f_open(&file, YMODEM_SIM_PATH, FA_CREATE_ALWAYS | FA_WRITE) != FR_OK) {
+        return YMODEM_ERROR;
+    }
+    for (uint32_t pos = 0; pos < size; pos += sizeof(sdmmc1_buffer)) {
+        uint32_t n = (size - pos < sizeof(sdmmc1_buffer)) ? size - pos : sizeof(sdmmc1_buffer);
+        for (uint32_t i = 0; i < n; i++) {
+            sdmmc1_buffer[i] = sim_pattern(pos + i);
+        }
+        if (f_write(&file, sdmmc1_buffer, n, &bytes_written) != FR_OK || bytes_written != n) {
+            f_close(&file);
+            return YMODEM_ERROR;
+        }
+        for (uint32_t i = 0; i < n; i++) {
+            sdmmc1_buffer[i] = sim_content(pos + i);
+        }
+        crc = crc32_update(crc, sdmmc1_buffer, n);
+    }
+    if (f_close(&file) != FR_OK) {
+        return YMODEM_ERROR;
+    }
+    sim_delta.basis_ms = HAL_GetTick() - start;
+
+    // 장치측 서명 생성 비용 (SIGS 명령과 같은 경로)
+    start = HAL_GetTick();
+    if (ymodem_delta_signatures(YMODEM_SIM_PATH, block, &sim_delta.sig_blocks) != FR_OK) {
+        return YMODEM_ERROR;
+    }
+    sim_delta.sig_ms = HAL_GetTick() - start;
+
+    uint8_t *p = sim_delta.head;
+    p += put_u32(p, DELTA_STREAM_MAGIC);
+    p += put_u32(p, block);
+    p += put_u32(p, size);
+    if (sim_delta.edit_start > 0) {
+        *p++ = DELTA_OP_COPY;
+        p += put_u32(p, 0);
+        p += put_u32(p, sim_delta.edit_start / block);
+    }
+    *p++ = DELTA_OP_LITERAL;
+    p += put_u32(p, sim_delta.literal_end - sim_delta.edit_start);
+    sim_delta.head_len = p - sim_delta.head;
+
+    p = sim_delta.tail;
+    if (sim_delta.literal_end < size) {
+        *p++ = DELTA_OP_COPY;
+        p += put_u32(p, sim_delta.literal_end / block);
+        p += put_u32(p, sim_delta.sig_blocks - sim_delta.literal_end / block);
+    }
+    *p++ = DELTA_OP_END;
+    p += put_u32(p, crc);
+    sim_delta.tail_len = p - sim_delta.tail;
+
+    sim.stream_size = sim_delta.head_len + (sim_delta.literal_end - sim_delta.edit_start) + sim_delta.tail_len;
+    printf("[DEBUG] YSIM: delta basis %lu bytes in %lu ms, edit [%lu, %lu), stream %lu bytes\r\n",
+           size, sim_delta.basis_ms, sim_delta.edit_start, sim_delta.edit_end, sim.stream_size);
+    return YMODEM_OK;
+}
+
+// 시뮬레이션 시작 (수신 파일 YMODEM_SIM_PATH)
+YmodemResult_t ymodem_sim_start(const YmodemSimConfig_t *config)
+{
+    if (config->mode != YMODEM_MODE_STANDARD && config->mode != YMODEM_MODE_G) {
+        printf("[ERROR] YSIM: mode %d not supported\r\n", config->mode);
+        return YMODEM_ERROR;
+    }
+    if (config->fault_interval != 0 && config->mode != YMODEM_MODE_STANDARD) {
+        printf("[ERROR] YSIM: fault injection needs standard mode (no retransmission in G)\r\n");
+        return YMODEM_ERROR;
+    }
+
+    memset(&sim, 0, sizeof(sim));
+    memset(&sim_delta, 0, sizeof(sim_delta));
+    sim.config = *config;
+    sim.phase = SIM_WAIT_START;
+    sim.stream_size = config->size;
+
+    if (config->delta_edit_kb != 0) {
+        if (config->mode != YMODEM_MODE_STANDARD || config->large_blocks ||
+            config->delta_edit_kb * 1024 > config->size) {
+            printf("[ERROR] YSIM: delta needs standard mode, 1 KB blocks and edit within file\r\n");
+            return YMODEM_ERROR;
+        }
+        if (prepare_delta() != YMODEM_OK) {
+            printf("[ERROR] YSIM: delta basis/signature preparation failed\r\n");
+            f_unlink(YMODEM_SIM_PATH);
+            return YMODEM_ERROR;
+        }
+    }
+
+    uint32_t cycles_per_us = SystemCoreClock / 1000000;
+    sim.delay_cycles = config->link_delay_us * cycles_per_us;
+    sim.cycles_per_byte = (config->link_kbps != 0) ? SystemCoreClock / (config->link_kbps * 1024) : 0;
+
+    SD_SetWriteLatency(config->sd_latency_us);
+    ymodem_set_link(&sim_link);
+
+    uint32_t options = config->large_blocks ? YMODEM_OPT_LARGE_BLOCKS : 0;
+    if (config->delta_edit_kb != 0) {
+        options |= YMODEM_OPT_DELTA;
+    }
+    YmodemResult_t result = ymodem_start_ex(NULL, YMODEM_SIM_PATH, config->mode, 0, options);
+    if (result != YMODEM_BUSY) {
+        ymodem_set_link(NULL);
+        SD_SetWriteLatency(0);
+    }
+    return result;
+}
+
+// 수신 파일을 패턴(차등 모델은 바뀐 내용)과 비교 + 수신 중 기록한 다이제스트 확인
+static bool verify_file(void)
+{
+    FIL file;
+    uint8_t buffer[512];
+    UINT bytes_read;
+    uint32_t pos = 0;
+    uint32_t crc = 0;
+    bool ok = true;
+
+    if (f_open(&file, YMODEM_SIM_PATH, FA_READ) != FR_OK) {
+        return false;
+    }
+    if (f_size(&file) != sim.config.size) {
+        printf("[ERROR] YSIM: size %lu, expected %lu\r\n", (uint32_t)f_size(&file), sim.config.size);
+        ok = false;
+    }
+
+    while (ok && pos < sim.config.size) {
+        if (f_read(&file, buffer, sizeof(buffer), &bytes_read) != FR_OK || bytes_read == 0) {
+            ok = false;
+            break;
+        }
+        for (UINT i = 0; i < bytes_read; i++) {
+            if (buffer[i] != sim_content(pos + i)) {
+                printf("[ERROR] YSIM: mismatch at %lu\r\n", pos + i);
+                ok = false;
+                break;
+            }
+        }
+        crc = crc32_update(crc, buffer, bytes_read);
+        pos += bytes_read;
+    }
+
+    f_close(&file);
+
+    uint32_t stored_size;
+    uint32_t stored_crc;
+    if (ok && (!ymodem_read_digest(YMODEM_SIM_PATH, &stored_size, &stored_crc) ||
+               stored_size != pos || stored_crc != crc)) {
+        printf("[ERROR] YSIM: digest missing or wrong (read %08lX)\r\n", crc);
+        ok = false;
+    }
+    return ok;
+}
+
+int ymodem_sim_finish(YmodemResult_t result, char *report, uint32_t report_size)
+{
+    int offset = 0;
+
+    SD_SetWriteLatency(0);
+
+    bool transferred = (result == YMODEM_OK && sim.phase == SIM_DONE);
+    bool verified = transferred && verify_file();
+    f_unlink(YMODEM_SIM_PATH);
+    f_unlink(YMODEM_SIM_PATH YMODEM_PROGRESS_SUFFIX);   // 실패 시 남는 진행 기록
+    f_unlink(YMODEM_SIM_PATH YMODEM_DIGEST_SUFFIX);
+    if (sim.config.delta_edit_kb != 0) {
+        // 실패 시 남는 차등 임시 파일 + 서명
+        f_unlink(YMODEM_SIM_PATH YMODEM_DELTA_SUFFIX);
+        f_unlink(YMODEM_SIM_PATH YMODEM_DELTA_SUFFIX YMODEM_PROGRESS_SUFFIX);
+        f_unlink(YMODEM_SIM_PATH YMODEM_DELTA_SUFFIX YMODEM_DIGEST_SUFFIX);
+        f_unlink(YMODEM_SIM_PATH DELTA_SIG_SUFFIX);
+    }
+
+    uint32_t cycles_per_us = SystemCoreClock / 1000000;
+    uint32_t ms = sim.data_end_tick - sim.data_start_tick;
+    uint32_t kbps = (transferred && ms != 0) ? (uint32_t)(((uint64_t)sim.config.size * 1000) / ms / 1024) : 0;
+    uint32_t lat_avg = sim.lat_count ? (uint32_t)(sim.lat_total / sim.lat_count) : 0;
+    uint32_t packets = sim.blk - 1 + sim.wraps * 256;
+    uint32_t pps = (transferred && ms != 0) ? (uint32_t)(((uint64_t)packets * 1000) / ms) : 0;
+
+    offset += snprintf(report + offset, report_size - offset,
+                       "transfer %s: %lu bytes in %lu ms, %lu KB/s, %lu packets/s (%u B blocks)\r\n",
+                       transferred ? "OK" : "FAIL", sim.config.size, transferred ? ms : 0, kbps, pps,
+                       sim.config.large_blocks ? YMODEM_LARGE_PACKET_SIZE : YMODEM_PACKET_SIZE);
+    offset += snprintf(report + offset, report_size - offset,
+                       "packet rx->ACK min/avg/max %lu/%lu/%lu us, %lu acks, %lu retransmits\r\n",
+                       sim.lat_min / cycles_per_us, lat_avg / cycles_per_us, sim.lat_max / cycles_per_us,
+                       sim.lat_count, sim.retransmits);
+    if (sim.faults > 0) {
+        uint32_t recovered = sim.faults - (sim.fault_pending ? 1 : 0);
+        uint32_t rec_avg = recovered ? (uint32_t)(sim.rec_total / recovered) : 0;
+        offset += snprintf(report + offset, report_size - offset,
+                           "faults %lu (garbage/truncate/shift), recovery min/avg/max %lu/%lu/%lu us\r\n",
+                           sim.faults, sim.rec_min / cycles_per_us, rec_avg / cycles_per_us,
+                           sim.rec_max / cycles_per_us);
+    }
+    if (sim.config.delta_edit_kb != 0) {
+        uint32_t literal_bytes;
+        uint32_t copied_bytes;
+        uint32_t wire_bytes;
+        ymodem_delta_result(&literal_bytes, &copied_bytes, &wire_bytes);
+        uint32_t sig_bytes = sizeof(DeltaSigHeader_t) + sim_delta.sig_blocks * sizeof(DeltaSigEntry_t);
+        offset += snprintf(report + offset, report_size - offset,
+                           "delta on link %lu of %lu bytes (%lu%%), literal %lu, copied %lu\r\n",
+                           wire_bytes, sim.config.size,
+                           sim.config.size ? (uint32_t)(((uint64_t)wire_bytes * 100) / sim.config.size) : 0,
+                           literal_bytes, copied_bytes);
+        offset += snprintf(report + offset, report_size - offset,
+                           "signatures %lu blocks (%lu bytes) in %lu ms, basis write %lu ms\r\n",
+                           sim_delta.sig_blocks, sig_bytes, sim_delta.sig_ms, sim_delta.basis_ms);
+    }
+    offset += snprintf(report + offset, report_size - offset,
+                       "verify %s\r\n", verified ? "PASS" : "FAIL");
+
+    return verified ? 0 : 1;
+}
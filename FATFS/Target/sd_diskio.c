@@ -23,6 +23,9 @@
 /* USER CODE BEGIN firstSection */
 /* can be used to modify / undefine following code or add new definitions */
 #define SD_DEBUG_LOG 1  // SD 카드 디버그 로그 활성화
+/* 생성 코드의 드라이버 표는 다른 이름으로 두고, beforeFunctionSection에서 write-behind 래퍼로
+   SD_Driver를 정의 (생성 함수 본문은 CubeMX 재생성 시에도 그대로) */
+#define SD_Driver SD_Driver_Generated
 /* USER CODE END firstSection*/
 
 /* Includes ------------------------------------------------------------------*/
@@ -113,6 +116,196 @@ const Diskio_drvTypeDef  SD_Driver =
 
 /* USER CODE BEGIN beforeFunctionSection */
 /* can be used to modify / undefine following code or add new code */
+
+/*
+ * Write-behind 모드 (Y-MODEM 수신 중 사용)
+ * 다중 섹터 SD_write()가 DMA 시작 직후 반환하고, 완료 확인(BSP_SD_WriteCpltCallback + 카드 프로그래밍 종료)은
+ * 다음 디스크 접근 시 수행. 호출자는 완료 전까지 버퍼를 수정하면 안 됨 (ping-pong 버퍼 사용)
+ * 지연된 쓰기의 실패는 다음 SD_write() 또는 CTRL_SYNC에서 RES_ERROR로 보고
+ */
+static volatile uint8_t WriteBehind = 0;
+static volatile uint8_t WritePending = 0;
+static uint8_t WriteBehindError = 0;
+static uint32_t WaitCycles = 0;    /* write-behind 완료 대기 누적 사이클 (Y-MODEM 구간 통계) */
+static uint32_t WriteStartCycles = 0;
+static uint32_t WriteLatencyCycles = 0;  /* 느린 카드 모델: write-behind 최소 완료 시간 (YSIM) */
+
+static int SD_CheckStatusWithTimeout(uint32_t timeout);
+
+/* 진행 중인 write-behind 전송 완료 대기 */
+static void SD_WaitPendingWrite(void)
+{
+  uint32_t timeout;
+
+  if (!WritePending)
+  {
+    return;
+  }
+
+  uint32_t start = DWT->CYCCNT;
+  timeout = HAL_GetTick();
+  while((WriteStatus == 0) && ((HAL_GetTick() - timeout) < SD_TIMEOUT))
+  {
+  }
+
+  if ((WriteStatus == 0) || (SD_CheckStatusWithTimeout(SD_TIMEOUT) < 0))
+  {
+    WriteBehindError = 1;
+  }
+  while ((DWT->CYCCNT - WriteStartCycles) < WriteLatencyCycles)
+  {
+  }
+  WaitCycles += DWT->CYCCNT - start;
+
+  WriteStatus = 0;
+  WritePending = 0;
+}
+
+/* 진행 중인 전송 완료 대기 후 결과 반환 (에러 플래그 해제) */
+static DRESULT SD_TakeWriteBehindResult(void)
+{
+  SD_WaitPendingWrite();
+
+  if (WriteBehindError)
+  {
+    WriteBehindError = 0;
+    return RES_ERROR;
+  }
+
+  return RES_OK;
+}
+
+/**
+  * @brief  Write-behind 모드 설정
+  * @param  enable: 1 = DMA 시작 후 즉시 반환, 0 = 완료까지 대기 (기본)
+  * @retval DRESULT: 비활성화 시 진행 중이던 쓰기의 결과
+  */
+DRESULT SD_SetWriteBehind(uint8_t enable)
+{
+  DRESULT res = SD_TakeWriteBehindResult();
+
+  WriteBehind = enable;
+  return res;
+}
+
+/**
+  * @brief  누적된 write-behind 완료 대기 시간 (DWT 사이클), 읽은 뒤 0으로 초기화
+  */
+uint32_t SD_TakeWaitCycles(void)
+{
+  uint32_t cycles = WaitCycles;
+  WaitCycles = 0;
+  return cycles;
+}
+
+/**
+  * @brief  Write-behind 최소 완료 시간 설정 (느린 카드 모델, YSIM 벤치마크)
+  * @param  us: DMA 시작부터 완료로 보기까지 최소 시간 (0 = 실제 카드 그대로)
+  */
+void SD_SetWriteLatency(uint32_t us)
+{
+  SD_WaitPendingWrite();
+  WriteLatencyCycles = us * (HAL_RCC_GetSysClockFreq() / 1000000);
+}
+
+/**
+  * @brief  Write-behind 전송 진행 중 여부 (DMA 완료 콜백 전)
+  */
+uint8_t SD_IsWriteBusy(void)
+{
+  return (WritePending &&
+          ((WriteStatus == 0) || ((DWT->CYCCNT - WriteStartCycles) < WriteLatencyCycles)));
+}
+
+/*
+ * write-behind 래퍼: 모든 디스크 접근 전에 진행 중인 전송을 마무리한 뒤 생성 함수 호출
+ * 다중 섹터 쓰기만 DMA 시작 후 바로 반환 (단일 섹터는 FatFs 윈도우(FAT/디렉토리)이므로 DMA 중
+ * 수정될 수 있어 생성 코드의 동기 경로 그대로)
+ */
+static DSTATUS SD_StatusWB(BYTE lun)
+{
+  /* DMA 진행 중에는 카드가 BUSY이므로 완료 후 상태 확인 */
+  SD_WaitPendingWrite();
+  return SD_status(lun);
+}
+
+static DRESULT SD_ReadWB(BYTE lun, BYTE *buff, DWORD sector, UINT count)
+{
+  SD_WaitPendingWrite();
+  return SD_read(lun, buff, sector, count);
+}
+
+#if _USE_WRITE == 1
+static DRESULT SD_WriteWB(BYTE lun, const BYTE *buff, DWORD sector, UINT count)
+{
+#if (ENABLE_SD_DMA_CACHE_MAINTENANCE == 1)
+  uint32_t alignedAddr;
+#endif
+
+  /* 이전 write-behind 전송 완료 확인 (실패했다면 이번 쓰기에서 보고) */
+  if (SD_TakeWriteBehindResult() != RES_OK)
+  {
+    return RES_ERROR;
+  }
+
+  if (!WriteBehind || (count <= 1)
+#if defined(ENABLE_SCRATCH_BUFFER)
+      || ((uint32_t)buff & 0x3)
+#endif
+     )
+  {
+    return SD_write(lun, buff, sector, count);
+  }
+
+  if (SD_CheckStatusWithTimeout(SD_TIMEOUT) < 0)
+  {
+    return RES_ERROR;
+  }
+
+  /* SD_write()와 같은 캐시 정리 후 DMA 시작, 완료는 BSP_SD_WriteCpltCallback()에서 표시하고
+     확인은 다음 디스크 접근 시 */
+#if (ENABLE_SD_DMA_CACHE_MAINTENANCE == 1)
+  alignedAddr = (uint32_t)buff & ~0x1F;
+  SCB_CleanDCache_by_Addr((uint32_t*)alignedAddr, count*BLOCKSIZE + ((uint32_t)buff - alignedAddr));
+#endif
+
+  WriteStatus = 0;
+  if (BSP_SD_WriteBlocks_DMA((uint32_t*)buff, (uint32_t)(sector), count) != MSD_OK)
+  {
+    return RES_ERROR;
+  }
+  WriteStartCycles = DWT->CYCCNT;
+  WritePending = 1;
+  return RES_OK;
+}
+#endif /* _USE_WRITE == 1 */
+
+#if _USE_IOCTL == 1
+static DRESULT SD_IoctlWB(BYTE lun, BYTE cmd, void *buff)
+{
+  /* CTRL_SYNC: 진행 중인 write-behind 전송까지 끝나야 동기화 완료 */
+  if ((cmd == CTRL_SYNC) && (SD_TakeWriteBehindResult() != RES_OK))
+  {
+    return RES_ERROR;
+  }
+  return SD_ioctl(lun, cmd, buff);
+}
+#endif /* _USE_IOCTL == 1 */
+
+#undef SD_Driver
+const Diskio_drvTypeDef  SD_Driver =
+{
+  SD_initialize,
+  SD_StatusWB,
+  SD_ReadWB,
+#if  _USE_WRITE == 1
+  SD_WriteWB,
+#endif /* _USE_WRITE == 1 */
+
+#if  _USE_IOCTL == 1
+  SD_IoctlWB,
+#endif /* _USE_IOCTL == 1 */
+};
 /* USER CODE END beforeFunctionSection */
 
 /* Private functions ---------------------------------------------------------*/
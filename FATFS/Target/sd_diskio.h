@@ -36,6 +36,11 @@ extern const Diskio_drvTypeDef  SD_Driver;
 
 /* USER CODE BEGIN lastSection */
 /* can be used to modify / undefine previous code or add new definitions */
+/* Write-behind: SD_write()가 DMA 완료를 기다리지 않고 반환 (Y-MODEM ping-pong 스테이징) */
+DRESULT SD_SetWriteBehind(uint8_t enable);
+uint8_t SD_IsWriteBusy(void);
+uint32_t SD_TakeWaitCycles(void);
+void SD_SetWriteLatency(uint32_t us);
 /* USER CODE END lastSection */
 
 #endif /* __SD_DISKIO_H */
@@ -27,7 +27,11 @@
 #include "usbd_cdc_if.h"
 
 /* USER CODE BEGIN Includes */
-
+#if USBD_MSC_ENABLE
+#include "usbd_msc.h"
+#include "usbd_storage_if.h"
+#endif
+#include <stdio.h>
 /* USER CODE END Includes */
 
 /* USER CODE BEGIN PV */
@@ -48,6 +52,11 @@ USBD_HandleTypeDef hUsbDeviceHS;
  */
 /* USER CODE BEGIN 0 */
 
+#define USBD_PID_CDC_HS     22336       // usbd_desc.c의 USBD_PID_HS
+#define USBD_PID_MSC_HS     22314       // ST Mass Storage 기본 PID
+
+static UsbDeviceMode_t usb_mode = USB_DEVICE_MODE_CDC;
+
 /* USER CODE END 0 */
 
 /*
@@ -91,6 +100,82 @@ void MX_USB_DEVICE_Init(void)
   /* USER CODE END USB_DEVICE_Init_PostTreatment */
 }
 
+/* USER CODE BEGIN 2 */
+
+/**
+  * CDC <-> MSC 클래스 전환 (재열거)
+  * 메인 루프에서만 호출 (CDC 수신 ISR 안에서 호출하면 자기 자신의 클래스를 해제하게 됨)
+  * @retval 0 성공, -1 MSC 클래스가 빌드되지 않았거나 USB 스택 초기화 실패
+  */
+int USB_Device_Set_Mode(UsbDeviceMode_t mode)
+{
+#if USBD_MSC_ENABLE
+  extern uint8_t USBD_HS_DeviceDesc[];
+  USBD_StatusTypeDef res;
+
+  if (mode == usb_mode)
+  {
+    return 0;
+  }
+
+  // 호스트에 분리로 보이도록 정지 후 클래스 해제 (CDC_DeInit_HS / MSC DeInit 호출됨)
+  USBD_Stop(&hUsbDeviceHS);
+  USBD_DeInit(&hUsbDeviceHS);
+  HAL_Delay(100);
+
+  // 장치 디스크립터: MSC는 인터페이스에서 클래스 지정 (0x00), PID를 바꿔 호스트 드라이버 캐시 분리
+  uint16_t pid = (mode == USB_DEVICE_MODE_MSC) ? USBD_PID_MSC_HS : USBD_PID_CDC_HS;
+  USBD_HS_DeviceDesc[4] = (mode == USB_DEVICE_MODE_MSC) ? 0x00 : 0x02;
+  USBD_HS_DeviceDesc[5] = (mode == USB_DEVICE_MODE_MSC) ? 0x00 : 0x02;
+  USBD_HS_DeviceDesc[10] = LOBYTE(pid);
+  USBD_HS_DeviceDesc[11] = HIBYTE(pid);
+
+  res = USBD_Init(&hUsbDeviceHS, &HS_Desc, DEVICE_HS);
+  if (res == USBD_OK)
+  {
+    if (mode == USB_DEVICE_MODE_MSC)
+    {
+      res = USBD_RegisterClass(&hUsbDeviceHS, &USBD_MSC);
+      if (res == USBD_OK)
+      {
+        res = USBD_MSC_RegisterStorage(&hUsbDeviceHS, &USBD_Storage_Interface_fops_HS);
+      }
+    }
+    else
+    {
+      res = USBD_RegisterClass(&hUsbDeviceHS, &USBD_CDC);
+      if (res == USBD_OK)
+      {
+        res = USBD_CDC_RegisterInterface(&hUsbDeviceHS, &USBD_Interface_fops_HS);
+      }
+    }
+  }
+  if (res == USBD_OK)
+  {
+    res = USBD_Start(&hUsbDeviceHS);
+  }
+  if (res != USBD_OK)
+  {
+    printf("[ERROR] USB: class switch failed (error %d)\r\n", res);
+    return -1;
+  }
+
+  usb_mode = mode;
+  printf("[DEBUG] USB: re-enumerated as %s\r\n", (mode == USB_DEVICE_MODE_MSC) ? "MSC" : "CDC");
+  return 0;
+#else
+  UNUSED(mode);
+  return -1;
+#endif
+}
+
+UsbDeviceMode_t USB_Device_Get_Mode(void)
+{
+  return usb_mode;
+}
+
+/* USER CODE END 2 */
+
 /**
   * @}
   */
@@ -64,6 +64,12 @@
  */
 /* USER CODE BEGIN VARIABLES */
 
+// USB 장치 클래스 (MSC는 USBD_MSC_ENABLE 빌드에서만)
+typedef enum {
+  USB_DEVICE_MODE_CDC = 0,
+  USB_DEVICE_MODE_MSC
+} UsbDeviceMode_t;
+
 /* USER CODE END VARIABLES */
 /**
   * @}
@@ -82,6 +88,10 @@ void MX_USB_DEVICE_Init(void);
  */
 /* USER CODE BEGIN FD */
 
+// CDC <-> MSC 재열거 (메인 루프 전용, 0 = 성공)
+int USB_Device_Set_Mode(UsbDeviceMode_t mode);
+UsbDeviceMode_t USB_Device_Get_Mode(void);
+
 /* USER CODE END FD */
 /**
   * @}
@@ -24,6 +24,8 @@
 /* USER CODE BEGIN INCLUDE */
 #include "uart_command.h"  // 명령 파싱 함수 사용
 #include "ring_buffer.h"   // Y-MODEM용 링 버퍼
+#include "cdc_rx_crc.h"    // Y-MODEM 패킷 경계 추적 + CRC 누적
+#include "cdc_rx_pool.h"   // Y-MODEM 무복사 수신 슬롯 풀
 #include <string.h>
 #include <stdio.h>  // printf for debug
 /* USER CODE END INCLUDE */
@@ -39,11 +41,32 @@
 static char cdc_cmd_buffer[UART_CMD_MAX_LENGTH];
 static uint16_t cdc_cmd_index = 0;
 
+// Y-MODEM 모드 수신 흐름 제어: 수신 버퍼 여유가 다음 USB 패킷보다 작으면 OUT 엔드포인트를 다시
+// 열지 않음 (호스트는 NAK를 받고 대기) → 메인 루프가 CDC_RX_RESUME_FREE 이상 비우면 CDC_Resume_Receive()로 재개
+static volatile bool cdc_rx_paused = false;
+static uint32_t cdc_rx_pause_cycles;   // 보류 시작 시각 (DWT)
+static uint32_t cdc_rx_pause_tick;     // 보류 시작 시각 (ms, DWT 카운터 한 바퀴보다 긴 보류용)
+static CdcRxFlowStats_t cdc_rx_flow;   // Y-MODEM 모드 진입 시 초기화
+
+#if !CDC_RX_ZERO_COPY
 // Y-MODEM용 링 버퍼 (일반 RAM에 배치)
 // 링 버퍼는 DMA를 사용하지 않으므로 캐시 사용 가능
+// 생산자는 CDC_Receive_HS(인터럽트), 소비자는 메인 루프의 Y-MODEM 수신 (SPSC)
+static uint8_t cdc_ring_storage[RING_BUFFER_SIZE];
 static RingBuffer_t cdc_ring_buffer;
+#endif
 
 static volatile bool cdc_ymodem_mode = false;  // Y-MODEM 모드 플래그
+static volatile bool cdc_active = false;       // CDC 클래스 동작 중 (MSC 모드/연결 해제 시 false)
+
+// 전송 큐: 응답/ACK를 쌓아 두고 이전 전송이 끝나면 (CDC_TransmitCplt_HS) 모아서 UserTxBufferHS로 전송
+// 생산자는 메인 루프와 인터럽트(명령 처리) 모두이므로 큐 조작은 인터럽트 금지 구간에서
+static uint8_t cdc_tx_storage[CDC_TX_QUEUE_SIZE];
+static RingBuffer_t cdc_tx_queue;
+static uint32_t cdc_tx_oldest_cycles;  // 큐에서 가장 오래된 바이트의 적재 시각 (DWT)
+static uint32_t cdc_tx_queued_cycles;  // 전송 중인 패킷의 가장 오래된 바이트 적재 시각
+static uint32_t cdc_tx_start_cycles;   // 전송 중인 패킷의 전송 시작 시각
+static CdcTxStats_t cdc_tx_stats;      // Y-MODEM 모드 진입 시 초기화
 
 /* USER CODE END PV */
 
@@ -143,6 +166,11 @@ static int8_t CDC_TransmitCplt_HS(uint8_t *pbuf, uint32_t *Len, uint8_t epnum);
 
 /* USER CODE BEGIN PRIVATE_FUNCTIONS_DECLARATION */
 
+static uint32_t CDC_Rx_Room(void);
+static void CDC_Pause_Receive(void);
+static void CDC_Resume_Receive(void);
+static void CDC_Process_TX_Queue(void);
+
 /* USER CODE END PRIVATE_FUNCTIONS_DECLARATION */
 
 /**
@@ -171,11 +199,22 @@ static int8_t CDC_Init_HS(void)
 
   /* Set Application Buffers */
   USBD_CDC_SetTxBuffer(&hUsbDeviceHS, UserTxBufferHS, 0);
+
+  /* 전송 큐 초기화 (연결 전에 쌓인 응답은 버림) */
+  ring_buffer_init(&cdc_tx_queue, cdc_tx_storage, sizeof(cdc_tx_storage));
+  cdc_rx_paused = false;
+#if CDC_RX_ZERO_COPY
+  /* 수신 슬롯 풀 초기화: 명령 모드도 슬롯에 수신 (Y-MODEM 모드 전환 시 수신 버퍼 교체 불필요) */
+  cdc_rx_pool_init();
+  USBD_CDC_SetRxBuffer(&hUsbDeviceHS, cdc_rx_pool_next());
+#else
   USBD_CDC_SetRxBuffer(&hUsbDeviceHS, UserRxBufferHS);
 
   /* 링 버퍼 초기화 */
-  ring_buffer_init(&cdc_ring_buffer);
+  ring_buffer_init(&cdc_ring_buffer, cdc_ring_storage, sizeof(cdc_ring_storage));
+#endif
   cdc_ymodem_mode = false;
+  cdc_active = true;
 
   /* 수신 시작 - 이것이 없으면 데이터를 받을 수 없음 */
   USBD_CDC_ReceivePacket(&hUsbDeviceHS);
@@ -194,6 +233,8 @@ static int8_t CDC_Init_HS(void)
 static int8_t CDC_DeInit_HS(void)
 {
   /* USER CODE BEGIN 9 */
+  /* 이후 pClassData는 CDC 핸들이 아닐 수 있음 (MSC 모드 전환) → 전송 큐 처리 중지 */
+  cdc_active = false;
   return (USBD_OK);
   /* USER CODE END 9 */
 }
@@ -290,13 +331,40 @@ static int8_t CDC_Receive_HS(uint8_t* Buf, uint32_t *Len)
 {
   /* USER CODE BEGIN 11 */
 
+#if CDC_RX_ZERO_COPY
+  // Y-MODEM 모드: 패킷이 들어온 슬롯을 그대로 큐에 넘기고 다음 빈 슬롯으로 수신 (복사 없음)
+  // 빈 슬롯이 없으면 수신을 시작하지 않음 → 호스트는 NAK를 받고 메인 루프가 슬롯을 반환할 때까지 대기
+  if (cdc_ymodem_mode) {
+    cdc_rx_pool_push(*Len);
+    cdc_rx_crc_feed(Buf, *Len);
+
+    uint8_t *next = cdc_rx_pool_next();
+    if (next == NULL) {
+      CDC_Pause_Receive();
+      return (USBD_OK);
+    }
+    USBD_CDC_SetRxBuffer(&hUsbDeviceHS, next);
+    USBD_CDC_ReceivePacket(&hUsbDeviceHS);
+    return (USBD_OK);
+  }
+#else
   // Y-MODEM 모드: 링 버퍼에 raw 데이터 저장 (디버그 로그 최소화)
   if (cdc_ymodem_mode) {
     if (!ring_buffer_write_array(&cdc_ring_buffer, Buf, *Len)) {
-      printf("[ERROR] CDC: ring buffer overflow\r\n");
+      printf("[ERROR] CDC: ring buffer overflow\r\n");   // 흐름 제어로 발생하지 않아야 함
+    } else {
+      // 링 버퍼에 들어간 바이트만 추적 (버린 청크는 수신측도 보지 못함)
+      cdc_rx_crc_feed(Buf, *Len);
+    }
+    // 다음 패킷(최대 512바이트)이 들어갈 공간이 없으면 수신 보류 → 호스트는 NAK를 받고 대기
+    if (CDC_Rx_Room() < CDC_DATA_HS_MAX_PACKET_SIZE) {
+      CDC_Pause_Receive();
+      return (USBD_OK);
     }
   }
+#endif
   // 일반 명령 모드: 명령 파싱
+  // (슬롯 풀 사용 시 같은 슬롯으로 다시 수신: 명령 모드에서는 슬롯을 큐에 넣지 않음)
   else {
     // 수신한 데이터를 문자별로 처리
     for (uint32_t i = 0; i < *Len; i++) {
@@ -373,14 +441,183 @@ static int8_t CDC_TransmitCplt_HS(uint8_t *Buf, uint32_t *Len, uint8_t epnum)
   uint8_t result = USBD_OK;
   /* USER CODE BEGIN 14 */
   UNUSED(Buf);
-  UNUSED(Len);
   UNUSED(epnum);
+
+  // 큐 적재 → 전송 완료 지연 (512 배수 길이면 ZLP까지 끝난 뒤 호출됨)
+  uint32_t now = DWT->CYCCNT;
+  uint32_t cycles_per_us = SystemCoreClock / 1000000;
+  uint32_t latency_us = (now - cdc_tx_queued_cycles) / cycles_per_us;
+  cdc_tx_stats.packets++;
+  cdc_tx_stats.bytes += *Len;
+  cdc_tx_stats.busy_us += (now - cdc_tx_start_cycles) / cycles_per_us;
+  cdc_tx_stats.latency_us += latency_us;
+  if (latency_us > cdc_tx_stats.max_latency_us) {
+    cdc_tx_stats.max_latency_us = latency_us;
+  }
+
+  // 다음 묶음 전송 (인터럽트 안: 다른 생산자와 겹치지 않도록 큐 조작은 인터럽트 금지 구간에서)
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  CDC_Process_TX_Queue();
+  __set_PRIMASK(primask);
   /* USER CODE END 14 */
   return result;
 }
 
 /* USER CODE BEGIN PRIVATE_FUNCTIONS_IMPLEMENTATION */
 
+/**
+ * @brief Y-MODEM 수신 버퍼의 여유 공간 (바이트, 슬롯 풀은 빈 슬롯 x 슬롯 크기)
+ */
+static uint32_t CDC_Rx_Room(void)
+{
+#if CDC_RX_ZERO_COPY
+  return cdc_rx_pool_free() * CDC_RX_SLOT_SIZE;
+#else
+  return RING_BUFFER_SIZE - ring_buffer_available(&cdc_ring_buffer);
+#endif
+}
+
+/**
+ * @brief 수신 보류 (CDC_Receive_HS에서 OUT 엔드포인트를 다시 열지 않고 반환할 때)
+ */
+static void CDC_Pause_Receive(void)
+{
+  cdc_rx_pause_cycles = DWT->CYCCNT;
+  cdc_rx_pause_tick = HAL_GetTick();
+  cdc_rx_flow.pauses++;
+  cdc_rx_paused = true;
+}
+
+/**
+ * @brief 수신 보류 해제 (메인 루프에서 수신 버퍼를 비운 뒤)
+ *        여유가 CDC_RX_RESUME_FREE 미만이면 계속 보류 (패킷마다 보류/재개를 반복하지 않도록)
+ *        보류 중에는 수신 인터럽트가 오지 않지만, 재개 직후 인터럽트와 겹치지 않도록 OTG_HS 인터럽트를 잠시 막음
+ */
+static void CDC_Resume_Receive(void)
+{
+  if (!cdc_rx_paused || CDC_Rx_Room() < CDC_RX_RESUME_FREE) {
+    return;
+  }
+
+  // 보류 시간: DWT 카운터는 수 초마다 한 바퀴 돌므로 1초 이상은 ms 단위로
+  uint32_t elapsed_ms = HAL_GetTick() - cdc_rx_pause_tick;
+  uint32_t stall_us = (elapsed_ms >= 1000) ? elapsed_ms * 1000 :
+                      (DWT->CYCCNT - cdc_rx_pause_cycles) / (SystemCoreClock / 1000000);
+
+  HAL_NVIC_DisableIRQ(OTG_HS_IRQn);
+  cdc_rx_paused = false;
+#if CDC_RX_ZERO_COPY
+  USBD_CDC_SetRxBuffer(&hUsbDeviceHS, cdc_rx_pool_next());
+#else
+  USBD_CDC_SetRxBuffer(&hUsbDeviceHS, UserRxBufferHS);
+#endif
+  USBD_CDC_ReceivePacket(&hUsbDeviceHS);
+  HAL_NVIC_EnableIRQ(OTG_HS_IRQn);
+
+  cdc_rx_flow.resumes++;
+  cdc_rx_flow.stall_us += stall_us;
+  if (stall_us > cdc_rx_flow.max_stall_us) {
+    cdc_rx_flow.max_stall_us = stall_us;
+  }
+}
+
+/**
+ * @brief 전송 큐 처리: 이전 전송이 끝났으면 쌓인 데이터를 최대 APP_TX_DATA_SIZE까지 모아 한 번에 전송
+ * @note  인터럽트 금지 상태에서 호출 (CDC_Queue_Transmit, CDC_TransmitCplt_HS)
+ *        길이가 512의 배수면 USB 코어가 ZLP를 덧붙이고, 완료 콜백은 ZLP 이후에 옴
+ */
+static void CDC_Process_TX_Queue(void)
+{
+  USBD_CDC_HandleTypeDef *hcdc = (USBD_CDC_HandleTypeDef*)hUsbDeviceHS.pClassData;
+  if (!cdc_active || hUsbDeviceHS.dev_state != USBD_STATE_CONFIGURED || hcdc == NULL || hcdc->TxState != 0) {
+    return;
+  }
+
+  // 래핑 지점에서 끊긴 두 구간까지 이어 붙임
+  uint32_t len = 0;
+  while (len < APP_TX_DATA_SIZE) {
+    const uint8_t *span;
+    uint32_t n = ring_buffer_read_span(&cdc_tx_queue, &span);
+    if (n == 0) {
+      break;
+    }
+    if (n > APP_TX_DATA_SIZE - len) {
+      n = APP_TX_DATA_SIZE - len;
+    }
+    memcpy(&UserTxBufferHS[len], span, n);
+    ring_buffer_read_commit(&cdc_tx_queue, n);
+    len += n;
+  }
+  if (len == 0) {
+    return;
+  }
+
+  // 지연 계측: 남은 데이터는 지금 적재된 것으로 간주 (메시지별 시각은 기록하지 않음)
+  uint32_t now = DWT->CYCCNT;
+  cdc_tx_queued_cycles = cdc_tx_oldest_cycles;
+  cdc_tx_start_cycles = now;
+  cdc_tx_oldest_cycles = now;
+
+  if (CDC_Transmit_HS(UserTxBufferHS, (uint16_t)len) != USBD_OK) {
+    cdc_tx_stats.drops++;   // TxState를 확인했으므로 발생하지 않아야 함
+  }
+}
+
+/**
+ * @brief 전송 요청 (응답, Y-MODEM ACK/블록): 큐에 넣고 바로 반환 (전송 완료를 기다리지 않음)
+ *        메시지는 통째로 들어가거나 버려짐 (일부만 보내지 않음)
+ *        큐가 가득 차면 메인 루프에서는 USB CDC 연결 중에 한해 CDC_TX_FULL_TIMEOUT_MS까지 자리가 나길 기다리고,
+ *        인터럽트(명령 처리) 안에서는 완료 인터럽트가 올 수 없으므로 바로 버림
+ * @retval 큐에 넣었으면 true
+ */
+bool CDC_Queue_Transmit(const uint8_t *data, uint32_t length)
+{
+  uint32_t start_tick = HAL_GetTick();
+  bool queued;
+
+  for (;;) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    bool was_empty = (ring_buffer_available(&cdc_tx_queue) == 0);
+    queued = ring_buffer_write_array(&cdc_tx_queue, data, length);
+    if (queued) {
+      uint32_t depth = ring_buffer_available(&cdc_tx_queue);
+      if (was_empty) {
+        cdc_tx_oldest_cycles = DWT->CYCCNT;
+      }
+      if (depth > cdc_tx_stats.max_queued) {
+        cdc_tx_stats.max_queued = depth;
+      }
+      cdc_tx_stats.messages++;
+      CDC_Process_TX_Queue();
+    }
+    __set_PRIMASK(primask);
+
+    if (queued || __get_IPSR() != 0 || primask != 0 ||
+        !cdc_active || hUsbDeviceHS.dev_state != USBD_STATE_CONFIGURED ||
+        HAL_GetTick() - start_tick >= CDC_TX_FULL_TIMEOUT_MS) {
+      break;
+    }
+  }
+
+  if (!queued) {
+    cdc_tx_stats.drops++;
+  }
+  return queued;
+}
+
+/**
+ * @brief 전송 큐 통계 (현재 또는 마지막 Y-MODEM 모드)
+ */
+void CDC_Get_TX_Stats(CdcTxStats_t *stats)
+{
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  *stats = cdc_tx_stats;
+  __set_PRIMASK(primask);
+}
+
 /**
  * @brief Y-MODEM 모드 설정
  */
@@ -388,27 +625,98 @@ void CDC_Set_YModem_Mode(bool enabled)
 {
   cdc_ymodem_mode = enabled;
   if (enabled) {
+    // 모드 전환 전에 들어온 바이트 (DOWNLOAD 직후 수신측의 'C' 등)가 다음 명령 앞에 붙지 않도록
+    // (링 버퍼/슬롯 풀 클리어는 소비자 쪽 연산이므로 수신 인터럽트와 겹쳐도 안전)
+    cdc_cmd_index = 0;
+#if CDC_RX_ZERO_COPY
+    cdc_rx_pool_clear();
+#else
     ring_buffer_clear(&cdc_ring_buffer);
+#endif
+    CDC_Resume_Receive();
+    memset(&cdc_rx_flow, 0, sizeof(cdc_rx_flow));
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    memset(&cdc_tx_stats, 0, sizeof(cdc_tx_stats));
+    __set_PRIMASK(primask);
+    cdc_rx_crc_reset();
     printf("[DEBUG] CDC: Y-MODEM mode enabled\r\n");
   } else {
-    printf("[DEBUG] CDC: Y-MODEM mode disabled\r\n");
+    // 남은 데이터 버림 (수신이 보류된 상태면 명령을 받을 수 있도록 다시 시작)
+#if CDC_RX_ZERO_COPY
+    cdc_rx_pool_clear();
+#else
+    ring_buffer_clear(&cdc_ring_buffer);
+#endif
+    CDC_Resume_Receive();
+    printf("[DEBUG] CDC: Y-MODEM mode disabled, receive paused %lu times (%lu us, max %lu us)\r\n",
+           cdc_rx_flow.pauses, cdc_rx_flow.stall_us, cdc_rx_flow.max_stall_us);
   }
 }
 
 /**
- * @brief 링 버퍼에서 데이터 읽기 (타임아웃 지원)
+ * @brief 수신 데이터 읽기 (타임아웃 지원)
  */
 uint32_t CDC_Read_Data(uint8_t *data, uint32_t length, uint32_t timeout_ms)
 {
-  return ring_buffer_read_array(&cdc_ring_buffer, data, length, timeout_ms);
+#if CDC_RX_ZERO_COPY
+  // 슬롯에서 바로 복사 (USB 버퍼 → 링 버퍼 복사 단계 없음), 반환한 슬롯으로 보류된 수신 재개
+  uint32_t start_tick = HAL_GetTick();
+  uint32_t read = cdc_rx_pool_read(data, length);
+  CDC_Resume_Receive();
+  while (read < length && HAL_GetTick() - start_tick < timeout_ms) {
+    HAL_Delay(1);
+    read += cdc_rx_pool_read(&data[read], length - read);
+    CDC_Resume_Receive();
+  }
+#else
+  uint32_t read = ring_buffer_read_array(&cdc_ring_buffer, data, length, timeout_ms);
+  CDC_Resume_Receive();
+#endif
+  cdc_rx_crc_consumed(read);
+  return read;
+}
+
+/**
+ * @brief 수신 흐름 제어 통계 (현재 또는 마지막 Y-MODEM 모드)
+ */
+void CDC_Get_Rx_Flow_Stats(CdcRxFlowStats_t *stats)
+{
+  *stats = cdc_rx_flow;
 }
 
 /**
- * @brief 링 버퍼에 사용 가능한 데이터 수
+ * @brief 수신 대기 중인 데이터 수
  */
 uint32_t CDC_Available_Data(void)
 {
+#if CDC_RX_ZERO_COPY
+  return cdc_rx_pool_available();
+#else
   return ring_buffer_available(&cdc_ring_buffer);
+#endif
+}
+
+/**
+ * @brief 링 버퍼 검증/벤치마크 (RINGTEST 명령)
+ *        명령 모드에서는 수신 버퍼가 비어 있으므로 저장 공간을 시험용으로 빌림 (Y-MODEM 모드면 -1)
+ *        슬롯 풀 사용 시에는 지금 파싱 중인(다음 수신할) 슬롯을 피한 절반만 빌림
+ */
+int CDC_Ring_Self_Test(char *report, uint32_t report_size)
+{
+  if (cdc_ymodem_mode) {
+    return -1;
+  }
+
+#if CDC_RX_ZERO_COPY
+  uint32_t scratch_size;
+  uint8_t *scratch = cdc_rx_pool_scratch(&scratch_size);
+  return ring_buffer_self_test(scratch, scratch_size, report, report_size);
+#else
+  int failures = ring_buffer_self_test(cdc_ring_storage, sizeof(cdc_ring_storage), report, report_size);
+  ring_buffer_init(&cdc_ring_buffer, cdc_ring_storage, sizeof(cdc_ring_storage));
+  return failures;
+#endif
 }
 
 /* USER CODE END PRIVATE_FUNCTIONS_IMPLEMENTATION */
@@ -53,6 +53,29 @@
 #define APP_TX_DATA_SIZE  2048
 /* USER CODE BEGIN EXPORTED_DEFINES */
 
+// Y-MODEM 모드 수신 방식
+// 1: 수신 슬롯 풀 (OUT 패킷을 빈 슬롯에 직접 수신, 인터럽트에서 복사 없음, 슬롯이 없으면 NAK로 대기)
+// 0: 링 버퍼 (UserRxBufferHS → 링 버퍼 복사)
+#ifndef CDC_RX_ZERO_COPY
+#define CDC_RX_ZERO_COPY  1
+#endif
+
+// 수신 재개 워터마크 (바이트): 다음 패킷이 들어갈 공간이 없어 수신을 보류(NAK)한 뒤
+// 메인 루프가 이만큼 비워야 다시 수신 (슬롯 풀은 8슬롯)
+#ifndef CDC_RX_RESUME_FREE
+#define CDC_RX_RESUME_FREE  4096
+#endif
+
+// 전송 큐 크기 (2의 거듭제곱): 응답/ACK를 쌓아 두고 전송 완료 인터럽트에서 APP_TX_DATA_SIZE까지 모아 전송
+#ifndef CDC_TX_QUEUE_SIZE
+#define CDC_TX_QUEUE_SIZE  4096
+#endif
+
+// 전송 큐가 가득 찼을 때 메인 루프에서 자리가 나길 기다리는 최대 시간 (인터럽트 안에서는 바로 버림)
+#ifndef CDC_TX_FULL_TIMEOUT_MS
+#define CDC_TX_FULL_TIMEOUT_MS  100
+#endif
+
 /* USER CODE END EXPORTED_DEFINES */
 
 /**
@@ -66,6 +89,26 @@
 
 /* USER CODE BEGIN EXPORTED_TYPES */
 
+// Y-MODEM 모드 수신 흐름 제어 통계 (모드 진입 시 초기화)
+typedef struct {
+  uint32_t pauses;          // 수신 보류 횟수 (여유 공간 부족 → NAK)
+  uint32_t resumes;         // 수신 재개 횟수
+  uint32_t stall_us;        // 보류 누적 시간
+  uint32_t max_stall_us;    // 최장 보류 시간
+} CdcRxFlowStats_t;
+
+// 전송 큐 통계 (Y-MODEM 모드 진입 시 초기화)
+typedef struct {
+  uint32_t messages;        // 큐에 넣은 메시지 수
+  uint32_t packets;         // USB 전송 수 (여러 메시지를 한 번에)
+  uint32_t bytes;           // 전송 완료 바이트
+  uint32_t drops;           // 큐가 가득 차 버린 메시지
+  uint32_t max_queued;      // 최대 대기 바이트
+  uint32_t latency_us;      // 큐 적재 → 전송 완료 누적 (평균 = latency_us / packets)
+  uint32_t max_latency_us;  // 큐 적재 → 전송 완료 최장
+  uint32_t busy_us;         // 전송 중 시간 합 (처리량 = bytes / busy_us)
+} CdcTxStats_t;
+
 /* USER CODE END EXPORTED_TYPES */
 
 /**
@@ -114,6 +157,14 @@ uint8_t CDC_Transmit_HS(uint8_t* Buf, uint16_t Len);
 void CDC_Set_YModem_Mode(bool enabled);
 uint32_t CDC_Read_Data(uint8_t *data, uint32_t length, uint32_t timeout_ms);
 uint32_t CDC_Available_Data(void);
+void CDC_Get_Rx_Flow_Stats(CdcRxFlowStats_t *stats);
+
+// 비차단 전송 (응답, Y-MODEM 프레임): 큐에 넣었으면 true
+bool CDC_Queue_Transmit(const uint8_t *data, uint32_t length);
+void CDC_Get_TX_Stats(CdcTxStats_t *stats);
+
+// 링 버퍼 검증/벤치마크 (RINGTEST, 명령 모드에서만)
+int CDC_Ring_Self_Test(char *report, uint32_t report_size);
 
 /* USER CODE END EXPORTED_FUNCTIONS */
 
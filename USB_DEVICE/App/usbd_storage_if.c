@@ -0,0 +1,250 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : usbd_storage_if.c
+  * @version        : v1.0_Cube
+  * @brief          : Memory management layer.
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2025 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+/* Includes ------------------------------------------------------------------*/
+#include "usbd_storage_if.h"
+
+/* USER CODE BEGIN INCLUDE */
+#include "msc_storage.h"   // SD 블록 접근 + FatFs 소유권 (sd_diskio DMA 다중 블록)
+/* USER CODE END INCLUDE */
+
+#if USBD_MSC_ENABLE
+
+/* Private typedef -----------------------------------------------------------*/
+/* Private define ------------------------------------------------------------*/
+/* Private macro -------------------------------------------------------------*/
+
+/** @addtogroup STM32_USB_OTG_DEVICE_LIBRARY
+  * @brief Usb device.
+  * @{
+  */
+
+/** @defgroup USBD_STORAGE
+  * @brief Usb mass storage device module
+  * @{
+  */
+
+/** @defgroup USBD_STORAGE_Private_Defines
+  * @brief Private defines.
+  * @{
+  */
+
+#define STORAGE_LUN_NBR                  1
+
+/* USER CODE BEGIN PRIVATE_DEFINES */
+
+/* USER CODE END PRIVATE_DEFINES */
+
+/**
+  * @}
+  */
+
+/** @defgroup USBD_STORAGE_Private_Variables
+  * @brief Private variables.
+  * @{
+  */
+
+/* USER CODE BEGIN INQUIRY_DATA_HS */
+/** USB Mass storage Standard Inquiry Data. */
+const int8_t STORAGE_Inquirydata_HS[] = {/* 36 */
+
+  /* LUN 0 */
+  0x00,
+  0x80,
+  0x02,
+  0x02,
+  (STANDARD_INQUIRY_DATA_LEN - 5),
+  0x00,
+  0x00,
+  0x00,
+  'S', 'T', 'M', ' ', ' ', ' ', ' ', ' ', /* Manufacturer : 8 bytes */
+  'A', 'u', 'd', 'i', 'o', ' ', 'M', 'u', /* Product      : 16 Bytes */
+  'x', ' ', 'S', 'D', ' ', ' ', ' ', ' ',
+  '0', '.', '0' ,'1'                      /* Version      : 4 Bytes */
+};
+/* USER CODE END INQUIRY_DATA_HS */
+
+/**
+  * @}
+  */
+
+/** @defgroup USBD_STORAGE_Private_FunctionPrototypes
+  * @brief Private functions declaration.
+  * @{
+  */
+
+static int8_t STORAGE_Init_HS(uint8_t lun);
+static int8_t STORAGE_GetCapacity_HS(uint8_t lun, uint32_t *block_num, uint16_t *block_size);
+static int8_t STORAGE_IsReady_HS(uint8_t lun);
+static int8_t STORAGE_IsWriteProtected_HS(uint8_t lun);
+static int8_t STORAGE_Read_HS(uint8_t lun, uint8_t *buf, uint32_t blk_addr, uint16_t blk_len);
+static int8_t STORAGE_Write_HS(uint8_t lun, uint8_t *buf, uint32_t blk_addr, uint16_t blk_len);
+static int8_t STORAGE_GetMaxLun_HS(void);
+
+/**
+  * @}
+  */
+
+USBD_StorageTypeDef USBD_Storage_Interface_fops_HS =
+{
+  STORAGE_Init_HS,
+  STORAGE_GetCapacity_HS,
+  STORAGE_IsReady_HS,
+  STORAGE_IsWriteProtected_HS,
+  STORAGE_Read_HS,
+  STORAGE_Write_HS,
+  STORAGE_GetMaxLun_HS,
+  (int8_t *)STORAGE_Inquirydata_HS
+};
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief  Initializes the storage unit (medium).
+  * @param  lun: Logical unit number.
+  * @retval USBD_OK if all operations are OK else USBD_FAIL
+  */
+int8_t STORAGE_Init_HS(uint8_t lun)
+{
+  /* USER CODE BEGIN 9 */
+  UNUSED(lun);
+  /* SD는 init_sdmmc()에서 이미 초기화됨, FatFs 마운트 해제는 MSC ON 명령에서 */
+  return (USBD_OK);
+  /* USER CODE END 9 */
+}
+
+/**
+  * @brief  Returns the medium capacity.
+  * @param  lun: Logical unit number.
+  * @param  block_num: Number of total block number.
+  * @param  block_size: Block size.
+  * @retval USBD_OK if all operations are OK else USBD_FAIL
+  */
+int8_t STORAGE_GetCapacity_HS(uint8_t lun, uint32_t *block_num, uint16_t *block_size)
+{
+  /* USER CODE BEGIN 10 */
+  UNUSED(lun);
+  if (!capacity_cached) {
+    return (USBD_FAIL);
+  }
+  *block_num = cached_block_num + 1;
+  *block_size = cached_block_size;
+  return (USBD_OK);
+  /* USER CODE END 10 */
+}
+
+/**
+  * @brief  Checks whether the medium is ready.
+  * @param  lun:  Logical unit number.
+  * @retval USBD_OK if all operations are OK else USBD_FAIL
+  */
+int8_t STORAGE_IsReady_HS(uint8_t lun)
+{
+  /* USER CODE BEGIN 11 */
+  UNUSED(lun);
+  /* 펌웨어가 FatFs를 쓰는 동안에는 매체 없음으로 보고 */
+  return msc_storage_host_owned() ? (USBD_OK) : (USBD_FAIL);
+  /* USER CODE END 11 */
+}
+
+/**
+  * @brief  Checks whether the medium is write protected.
+  * @param  lun: Logical unit number.
+  * @retval USBD_OK if all operations are OK else USBD_FAIL
+  */
+int8_t STORAGE_IsWriteProtected_HS(uint8_t lun)
+{
+  /* USER CODE BEGIN 12 */
+  UNUSED(lun);
+  return (USBD_OK);
+  /* USER CODE END 12 */
+}
+
+/**
+  * @brief  Reads data from the medium.
+  * @param  lun: Logical unit number.
+  * @param  buf: data buffer.
+  * @param  blk_addr: Logical block address.
+  * @param  blk_len: Blocks number.
+  * @retval USBD_OK if all operations are OK else USBD_FAIL
+  */
+int8_t STORAGE_Read_HS(uint8_t lun, uint8_t *buf, uint32_t blk_addr, uint16_t blk_len)
+{
+  /* USER CODE BEGIN 13 */
+  UNUSED(lun);
+  /* MSC_MEDIA_PACKET 단위 다중 블록 DMA 한 번 */
+  return (msc_storage_read(buf, blk_addr, blk_len) == 0) ? (USBD_OK) : (USBD_FAIL);
+  /* USER CODE END 13 */
+}
+
+/**
+  * @brief  Writes data into the medium.
+  * @param  lun: Logical unit number.
+  * @param  buf: data buffer.
+  * @param  blk_addr: Logical block address.
+  * @param  blk_len: Blocks number.
+  * @retval USBD_OK if all operations are OK else USBD_FAIL
+  */
+int8_t STORAGE_Write_HS(uint8_t lun, uint8_t *buf, uint32_t blk_addr, uint16_t blk_len)
+{
+  /* USER CODE BEGIN 14 */
+  UNUSED(lun);
+  return (msc_storage_write(buf, blk_addr, blk_len) == 0) ? (USBD_OK) : (USBD_FAIL);
+  /* USER CODE END 14 */
+}
+
+/**
+  * @brief  Returns the Max Supported LUNs.
+  * @param  None
+  * @retval Lun(s) number.
+  */
+int8_t STORAGE_GetMaxLun_HS(void)
+{
+  /* USER CODE BEGIN 15 */
+  return (STORAGE_LUN_NBR - 1);
+  /* USER CODE END 15 */
+}
+
+/* USER CODE BEGIN PRIVATE_FUNCTIONS_IMPLEMENTATION */
+
+bool STORAGE_Ejected_HS(void)
+{
+  extern USBD_HandleTypeDef hUsbDeviceHS;
+  USBD_MSC_BOT_HandleTypeDef *hmsc = (USBD_MSC_BOT_HandleTypeDef*)hUsbDeviceHS.pClassData;
+  return (hmsc != NULL) && (hmsc->scsi_medium_state == SCSI_MEDIUM_EJECTED);
+}
+
+/* USER CODE END PRIVATE_FUNCTIONS_IMPLEMENTATION */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+#else  /* USBD_MSC_ENABLE */
+
+bool STORAGE_Ejected_HS(void)
+{
+  return false;
+}
+
+#endif /* USBD_MSC_ENABLE */
@@ -26,7 +26,9 @@
 #include "usbd_cdc.h"
 
 /* USER CODE BEGIN Includes */
-
+#include "cdc_rx_pool.h"   // MSC 모드 클래스 핸들 (CDC 수신 슬롯 풀 대여)
+// 아래 생성 코드의 USBD_static_malloc() 정의는 원래 이름 그대로 두고, 클래스 쪽 호출만 USBD_class_malloc()으로
+#undef USBD_static_malloc
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -50,12 +52,29 @@ void Error_Handler(void);
 /* USER CODE BEGIN PFP */
 /* Private function prototypes -----------------------------------------------*/
 USBD_StatusTypeDef USBD_Get_USB_Status(HAL_StatusTypeDef hal_status);
+void *USBD_static_malloc(uint32_t size);
 
 /* USER CODE END PFP */
 
 /* Private functions ---------------------------------------------------------*/
 
 /* USER CODE BEGIN 1 */
+/**
+  * @brief  클래스 핸들 할당 (usbd_conf.h의 USBD_malloc → USBD_class_malloc)
+  *         CDC 핸들은 생성 코드의 USBD_static_malloc() mem[], 그보다 큰 MSC 핸들(미디어 패킷 포함)은
+  *         CDC 클래스가 내려가 있는 동안 쉬는 수신 슬롯 풀에 배치
+  * @param  size: Size of allocated memory
+  * @retval 할당 영역, 풀보다 크면 NULL
+  */
+void *USBD_class_malloc(uint32_t size)
+{
+  if (size > sizeof(USBD_CDC_HandleTypeDef)) {
+    uint32_t pool_size;
+    uint8_t *pool = cdc_rx_pool_storage(&pool_size);
+    return (size <= pool_size) ? pool : NULL;
+  }
+  return USBD_static_malloc(size);
+}
 /* USER CODE END 1 */
 
 /*******************************************************************************
@@ -36,6 +36,21 @@
 
 /* USER CODE BEGIN INCLUDE */
 
+/* USB 대용량 저장 장치 모드 (MSC ON): CDC 대신 MSC 클래스(Middlewares/.../Class/MSC)로 다시 연결해
+   SD 카드를 호스트에 노출, 0이면 MSC 클래스와 usbd_storage_if를 링크하지 않음 (MSC ON은 ERR 501) */
+#ifndef USBD_MSC_ENABLE
+#define USBD_MSC_ENABLE     1
+#endif
+
+/* MSC 미디어 패킷 = SCSI READ/WRITE 한 번의 SD 다중 블록 전송 크기 (MSCBENCH로 청크별 속도 확인) */
+#define MSC_MEDIA_PACKET    16384
+
+/* 클래스 핸들 할당: 생성 코드의 USBD_static_malloc()은 CDC 핸들 크기 mem[] 하나뿐이라 MSC 핸들(16KB+)이 넘침
+   → USBD_malloc이 부르는 이름을 USBD_class_malloc()으로 돌려, 큰 핸들은 MSC 모드에서 쉬는
+     CDC 수신 슬롯 풀(32KB)을 빌려 씀 (usbd_conf.c USER CODE 1, 재생성 시에도 유지) */
+#define USBD_static_malloc(size)  USBD_class_malloc(size)
+void *USBD_class_malloc(uint32_t size);
+
 /* USER CODE END INCLUDE */
 
 /** @addtogroup USBD_OTG_DRIVER